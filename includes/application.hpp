@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 //
 // Might be a good idea to contain all instances of Window objects
 // inside of the Application class, that way I can track when a window is open or closed
@@ -49,6 +51,9 @@ namespace app {
 
     double m_physics_interval;
     double m_physics_time;
+
+    // Physics ticks run so far, m_physics_time is worked out from this rather than added up so it doesn't drift.
+    uint64_t m_physics_ticks;
     double m_physics_remainder;
 
   public:
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <game/board.hpp>
+#include <bot/features.hpp>
+#include <bot/transposition.hpp>
+
+namespace bot {
+
+  struct SearchSettings {
+    // Boards kept after each tetromino is placed.
+    int beam_width = 8;
+
+    // Tetromino searched ahead, including the falling one. Capped to the ones the board lets the
+    // player see (the falling tetromino plus its preview queue).
+    int depth = 2;
+
+    // Seconds a search may take before it settles for the best placement found so far, 0 for no
+    // limit. The first tetromino is always searched in full so there's always a placement.
+    double time_budget = 0.0;
+
+    Weights weights;
+  };
+
+  //
+  // Plays a board by itself.
+  //
+  //    Placements are picked with a beam search: every placement of the falling tetromino is made
+  //    on a copy of the board and scored by its features, the best beam_width boards are kept and
+  //    every placement of the next tetromino is made on those, and so on, then the first placement
+  //    on the way to the best board found is played. Boards reached more than once (same Zobrist
+  //    hash) only take up one place in the beam.
+  //
+  //    The placement is then steered into place one tick at a time through the same InputState
+  //    bitfield the keyboard produces. The autoplayer watches where the tetromino actually is each
+  //    tick (rather than trusting a precomputed input sequence), tapping sideways, holding rotate
+  //    until it takes and soft dropping between moves, hard dropping once the last move is done,
+  //    and finds a new path if gravity pulls the tetromino past a move that had to happen on a
+  //    higher line.
+  //
+  class Autoplayer {
+  private:
+    SearchSettings m_settings;
+
+    //
+    // Search data, kept between searches so they don't allocate.
+    //
+    struct Candidate {
+      double score;
+      uint64_t hash;
+      int parent;
+      int placement;
+    };
+
+    std::vector< game::Board > m_beam;
+    std::vector< game::Board > m_next_beam;
+    std::vector< int > m_beam_lines;
+    std::vector< int > m_next_lines;
+    std::vector< int > m_beam_root;
+    std::vector< int > m_next_root;
+    std::vector< game::PlacementList > m_placements;
+    std::vector< Candidate > m_candidates;
+
+    // Candidates waiting on their features, their boards' lines are packed one after another
+    // into m_batch_lines for extract_features_batch.
+    struct Pending {
+      size_t candidate;
+      uint64_t board_hash;
+      int lines;
+    };
+
+    std::vector< Pending > m_pending;
+    std::vector< uint32_t > m_batch_lines;
+    std::vector< Features > m_batch_features;
+
+    game::PlacementList m_root_placements;
+    game::Board m_scratch;
+
+    // Optional cache of board scores, keyed by Board::board_hash since a board's score only
+    // depends on its locked cells. Can be shared with other autoplayers on other threads.
+    TranspositionTable* m_table;
+    TranspositionStats m_table_stats;
+
+    //
+    // Plan for the falling tetromino.
+    //
+    //    The path is broken into the sideways moves and rotations and the line each one has to
+    //    happen on, moving down is left to soft dropping and gravity.
+    //
+    struct Action {
+      uint8_t move;
+      int y;
+
+      // Where the tetromino should be once the move has happened.
+      int rotation;
+      int x;
+    };
+
+    bool m_planned;
+    game::Placement m_target;
+    std::vector< Action > m_actions;
+    size_t m_action;
+
+    uint8_t m_last_input;
+
+    //
+    // Stats.
+    //
+    uint64_t m_searches;
+    uint64_t m_replans;
+    double m_search_time;
+
+  private:
+    // Runs the beam search, returns false if the falling tetromino has nowhere to go.
+    bool search( const game::Board& board, game::Placement& best );
+
+    // Sets up the actions for a placement from the path find_placements gave for it.
+    void follow( const game::Board& board, const game::PlacementList& placements, const game::Placement& placement );
+
+    // Picks (or finds a new path to) a placement for the falling tetromino.
+    void plan( const game::Board& board );
+
+  public:
+    Autoplayer( const SearchSettings& settings = {} );
+
+    // Forgets the current plan, use when the board is reset.
+    void reset();
+
+    // Returns the InputState bitfield to feed the board's next physics tick.
+    uint8_t input( const game::Board& board );
+
+    // Lets the autoplayer know what happened during the tick it just gave input for.
+    void observe( const game::StepResult& result );
+
+    // Picks the best placement for the board's falling tetromino without playing it.
+    bool best_placement( const game::Board& board, game::Placement& best ) {
+      return search( board, best );
+    }
+
+    void set_table( TranspositionTable* table ) {
+      m_table = table;
+    }
+
+    const TranspositionStats& table_stats() const {
+      return m_table_stats;
+    }
+
+    SearchSettings& settings() {
+      return m_settings;
+    }
+
+    const uint64_t searches() const {
+      return m_searches;
+    }
+
+    // Times gravity pulled a tetromino past a planned move and a new path had to be found.
+    const uint64_t replans() const {
+      return m_replans;
+    }
+
+    // Total seconds spent searching.
+    const double search_time() const {
+      return m_search_time;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <game/board.hpp>
+
+namespace bot {
+
+  //
+  // Shape of the locked cells of a board, as used to judge how good a placement was.
+  //
+  struct Features {
+    // Height of each column (lines from the floor up to and including its highest filled cell).
+    uint8_t column_heights[ game::BitBoard::MAX_WIDTH ];
+
+    // Sum of the column heights.
+    int aggregate_height;
+
+    // Empty cells with a filled cell somewhere above them.
+    int holes;
+
+    // Sum of the height differences between neighbouring columns.
+    int bumpiness;
+
+    // Sum of the well depths, how far each column sits below the lower of its neighbours (the
+    // walls count as full height).
+    int wells;
+
+    // Changes between filled and empty cells along each line, the walls counting as filled. Only
+    // lines from the highest filled cell down are counted.
+    int row_transitions;
+
+    // Changes between filled and empty cells down each column, the floor counting as filled.
+    int column_transitions;
+  };
+
+  //
+  // Weights for each feature and for lines cleared, the defaults are the weights from
+  // https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/ with a
+  // penalty for wells added, the transitions aren't used unless given a weight.
+  //
+  struct Weights {
+    double aggregate_height = -0.510066;
+    double lines = 0.760666;
+    double holes = -0.35663;
+    double bumpiness = -0.184483;
+    double wells = -0.1;
+    double row_transitions = 0.0;
+    double column_transitions = 0.0;
+  };
+
+  // Extracts the features of width x height lines of cells (bit n of a line being x = n).
+  //
+  //    This is the scalar reference, extract_features_batch gives exactly the same results.
+  //
+  Features extract_features( const uint32_t* lines, const int width, const int height );
+
+  // Extracts the features of the locked cells of a board, the falling tetromino isn't included.
+  Features extract_features( const game::Board& board );
+
+  //
+  // Extracts the features of count boards at once, board b's lines being lines[ b * height ] to
+  // lines[ b * height + height - 1 ].
+  //
+  //    Boards are processed 8 at a time with AVX2 or 4 at a time with SSE2 (whichever the build
+  //    targets), one board per 32 bit lane, walking down the lines of every board together.
+  //
+  void extract_features_batch( const uint32_t* lines, const int width, const int height, const size_t count, Features* features );
+
+  // Scores features plus the lines cleared getting there, higher is better.
+  double evaluate( const Features& features, const int lines_cleared, const Weights& weights );
+
+}
\ No newline at end of file
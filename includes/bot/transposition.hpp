@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace bot {
+
+  //
+  // What a search remembers about a state.
+  //
+  struct TranspositionEntry {
+    float score;
+
+    // Search defined, e.g., the index of the best placement found.
+    uint16_t move;
+
+    // How many tetromino deep the score was searched, deeper entries are kept over shallower ones.
+    uint8_t depth;
+  };
+
+  //
+  // Counters for one thread's use of a table, kept per thread so probing never writes to memory
+  // shared with other threads besides the table itself. Add them up for the whole search.
+  //
+  struct TranspositionStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+
+    // Probes are timed one in every TIMING_INTERVAL, these are the ones that were.
+    uint64_t timed_probes = 0;
+    uint64_t probe_ns = 0;
+
+    double hit_rate() const {
+      return probes ? ( double ) hits / probes : 0.0;
+    }
+
+    double average_probe_ns() const {
+      return timed_probes ? ( double ) probe_ns / timed_probes : 0.0;
+    }
+
+    void add( const TranspositionStats& other ) {
+      probes += other.probes;
+      hits += other.hits;
+      stores += other.stores;
+      timed_probes += other.timed_probes;
+      probe_ns += other.probe_ns;
+    }
+  };
+
+  //
+  // Fixed size hash table of search results keyed by Zobrist hash (see game::Board::hash), shared
+  // by any number of search threads without locks.
+  //
+  //    Entries are grouped 4 to a 64 byte bucket so a probe touches one cache line. Each entry is
+  //    two 64 bit words, the packed data and the key XORed with the data, written and read with
+  //    relaxed atomics. A probe only accepts an entry if the words XOR back to its key, so an
+  //    entry torn by two threads writing at once reads as a miss instead of as wrong data
+  //    (https://craftychess.com/hyatt/hashing.html).
+  //
+  //    When a bucket is full the entry from the oldest search goes first, then the shallowest.
+  //
+  class TranspositionTable {
+  public:
+    static constexpr int BUCKET_ENTRIES = 4;
+    static constexpr uint64_t TIMING_INTERVAL = 64;
+
+  private:
+    struct alignas( 64 ) Bucket {
+      std::atomic< uint64_t > words[ BUCKET_ENTRIES * 2 ];
+    };
+
+    std::unique_ptr< Bucket[] > m_buckets;
+    size_t m_num_buckets;
+
+    // Bumped by new_search() so entries from earlier searches are replaced first.
+    uint8_t m_generation;
+
+  public:
+    // Allocates the largest power of two number of buckets that fits in size_mb megabytes.
+    TranspositionTable( const size_t size_mb = 16 );
+
+    void clear();
+
+    // Marks everything stored so far as coming from an older search.
+    void new_search();
+
+    // Looks up a key, returns true and fills entry if it's stored.
+    bool probe( const uint64_t key, TranspositionEntry& entry, TranspositionStats& stats ) const;
+
+    void store( const uint64_t key, const TranspositionEntry& entry, TranspositionStats& stats );
+
+    // Number of entries the table can hold.
+    const size_t capacity() const {
+      return m_num_buckets * BUCKET_ENTRIES;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <game/line_mask.hpp>
+
+namespace game {
+
+  // Board dimension given at run time rather than compile time, see BasicBitBoard and BasicBoard.
+  constexpr int DYNAMIC_SIZE = 0;
+
+  //
+  // Width and height of a board.
+  //
+  //    Fixed sizes are template arguments and take up no space, so loops bounded by them are
+  //    bounded by constants the compiler can unroll. DYNAMIC_SIZE keeps both in members.
+  //
+  template< int W, int H >
+  struct BoardExtent {
+    static_assert( W > 0 && H > 0, "a board is either fixed in both dimensions or dynamic in both" );
+
+    constexpr BoardExtent( const int, const int ) {}
+
+    constexpr int width() const {
+      return W;
+    }
+
+    constexpr int height() const {
+      return H;
+    }
+  };
+
+  template<>
+  struct BoardExtent< DYNAMIC_SIZE, DYNAMIC_SIZE > {
+    int m_width;
+    int m_height;
+
+    constexpr BoardExtent( const int width, const int height ) :
+      m_width( width ),
+      m_height( height ) {}
+
+    constexpr int width() const {
+      return m_width;
+    }
+
+    constexpr int height() const {
+      return m_height;
+    }
+  };
+
+  //
+  // Line based storage for the board.
+  //
+  //    Each line (a row of cells sharing the same y coordinate) is stored as a single occupancy
+  //    bitmask where bit n is set when the cell at x = n is filled, this turns collision and
+  //    full line checks into a handful of AND/compare operations on whole lines.
+  //
+  //    The block state (which tetromino filled a cell) lives in a separate colour plane, packed
+  //    4 bits per cell into 64 bit words, one per 16 cells of a line, it's only read when drawing.
+  //
+  //    W and H fix the size at compile time, the lines are then held inline in the smallest
+  //    integer that fits a line so the whole board copies as one flat block, or as a LineMask
+  //    for lines wider than 64 cells. With DYNAMIC_SIZE the size comes from the constructor and
+  //    the lines live on the heap.
+  //
+  template< int W, int H >
+  class BasicBitBoard {
+  public:
+    static constexpr bool DYNAMIC = W == DYNAMIC_SIZE;
+
+    // Widest a dynamically sized board can be, and the widest the zobrist keys, placement
+    // search and bot features cover.
+    static constexpr int MAX_WIDTH = 16;
+
+    // Widest a board fixed at compile time can be.
+    static constexpr int MAX_WIDE_WIDTH = 128;
+
+    // Cleared lines are reported as a 64 bit mask.
+    static constexpr int MAX_HEIGHT = 64;
+
+    static_assert( W <= MAX_WIDE_WIDTH && H <= MAX_HEIGHT );
+
+    using line_t = std::conditional_t< DYNAMIC, uint32_t,
+      std::conditional_t< ( W <= 8 ), uint8_t,
+      std::conditional_t< ( W <= 16 ), uint16_t,
+      std::conditional_t< ( W <= 32 ), uint32_t,
+      std::conditional_t< ( W <= 64 ), uint64_t, LineMask< ( W + 63 ) / 64 > > > > > >;
+
+    // Words of colour plane per line.
+    static constexpr int COLOUR_WORDS = DYNAMIC ? 1 : ( W * 4 + 63 ) / 64;
+
+  private:
+    template< typename T, int N >
+    using storage_t = std::conditional_t< DYNAMIC, std::vector< T >, std::array< T, N > >;
+
+    BoardExtent< W, H > m_extent;
+
+    // Mask with all cells of a line set.
+    line_t m_full_line;
+
+    storage_t< line_t, H > m_lines;
+    storage_t< uint64_t, H * COLOUR_WORDS > m_colours;
+
+  public:
+    BasicBitBoard( const int width = W, const int height = H );
+
+  public:
+    // Empties every line.
+    void clear();
+
+    constexpr int width() const {
+      return m_extent.width();
+    }
+
+    constexpr int height() const {
+      return m_extent.height();
+    }
+
+    const line_t full_line() const {
+      return m_full_line;
+    }
+
+    // Returns the occupancy mask of a line, lines outside the board are reported as empty.
+    const line_t line( const int y ) const {
+      if( y < 0 || y >= height() ) {
+        return {};
+      }
+
+      return m_lines[ y ];
+    }
+
+    // Returns the occupancy mask of a line that's known to be on the board.
+    const line_t line_unchecked( const int y ) const {
+      return m_lines[ y ];
+    }
+
+    const bool is_line_full( const int y ) const {
+      return line( y ) == m_full_line;
+    }
+
+    // Returns the block state of a cell (0 being empty), cells outside the board are reported as empty.
+    const int get( const int x, const int y ) const;
+
+    // Sets the block state of a cell, a state of 0 empties it.
+    void set( const int x, const int y, const int state );
+
+    // Empties a single line.
+    void clear_line( const int y );
+
+    // Removes every full line and compacts the remaining lines downwards in a single pass,
+    // returns a mask of the lines that were cleared (bit n being line n, before compaction).
+    uint64_t clear_full_lines();
+  };
+
+  // The sizes game::BasicBoard is instantiated for, see board.hpp.
+  extern template class BasicBitBoard< 10, 20 >;
+  extern template class BasicBitBoard< 10, 40 >;
+  extern template class BasicBitBoard< 4, 20 >;
+  extern template class BasicBitBoard< DYNAMIC_SIZE, DYNAMIC_SIZE >;
+  extern template class BasicBitBoard< 32, 20 >;
+  extern template class BasicBitBoard< 64, 20 >;
+  extern template class BasicBitBoard< 128, 20 >;
+
+  using BitBoard = BasicBitBoard< DYNAMIC_SIZE, DYNAMIC_SIZE >;
+
+}
\ No newline at end of file
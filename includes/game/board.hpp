@@ -4,35 +4,80 @@
 #include <memory>
 
 #include <game/shape.hpp>
+#include <game/piece.hpp>
+#include <game/bitboard.hpp>
+#include <game/input.hpp>
+#include <game/random.hpp>
+#include <game/placement.hpp>
 
 namespace game {
 
-  class Game;
-
   enum BlockState {
     state_empty = 0,
   };
 
-  class Board {
+  //
+  // Everything needed to put a board back exactly as it was, see BasicBoard::snapshot. The hash
+  // and surface aren't included, they're worked out again from the cells.
+  //
+  struct BoardSnapshot {
+    // Block state of every cell, cells[ y ][ x ].
+    uint8_t cells[ BitBoard::MAX_HEIGHT ][ BitBoard::MAX_WIDTH ];
+
+    PieceState piece;
+
+    int rotate_timer;
+    int move_timer;
+    bool first_move;
+    int gravity_timer;
+    bool hard_drop_held;
+    uint64_t ticks;
+
+    bool game_over;
+    int level;
+    int lines_cleared;
+    int score;
+
+    GeneratorState generator;
+  };
+
+  //
+  // The game rules for a single board.
+  //
+  //    Everything in here (besides the draw functions in board_draw.cpp) is plain C++ with no
+  //    ImGui, windows.h or audio dependencies, input comes in as an InputState bitfield per tick
+  //    and whatever happened during the tick is handed back as a StepResult, that way the same
+  //    rules can run behind a window or headless as fast as the CPU allows.
+  //
+  //    The size is fixed at compile time by W (across) and H (down) so every loop over the
+  //    board is bounded by a constant and the lines are stored in the narrowest integer that
+  //    fits. The member functions are defined in the .cpp files and instantiated there for the
+  //    sizes below, BasicBoard< DYNAMIC_SIZE, DYNAMIC_SIZE > takes its size from the constructor
+  //    for anything else (up to BitBoard::MAX_WIDTH by BitBoard::MAX_HEIGHT).
+  //
+  template< int W, int H >
+  class BasicBoard {
+  public:
+    // Rate at which step() advances the simulation.
+    static constexpr int TICKS_PER_SECOND = 60;
+
+    static constexpr bool DYNAMIC = BasicBitBoard< W, H >::DYNAMIC;
+
+    using line_t = typename BasicBitBoard< W, H >::line_t;
+
   private:
-    Game* m_game;
-
-    int m_columns;
-    int m_rows;
-
-    // 1D reprensation of a 2D grid board.
-    std::unique_ptr< int[] > m_state;
-
-    // All available tetromino to be used for placing.
-    Tetromino m_tetromino[ NUM_TETROMINO ] = {
-      IShape(),
-      OShape(),
-      TShape(),
-      JShape(),
-      LShape(),
-      SShape(),
-      ZShape()
-    };
+    // One occupancy mask per line plus a packed colour plane, see BitBoard.
+    BasicBitBoard< W, H > m_state;
+
+    // Zobrist hash of the locked cells (see ZobristKeys), kept up to date as cells are set and lines cleared.
+    uint64_t m_hash;
+
+    //
+    // Surface of the stack, the y of the highest filled cell in each column (x), columns() for an
+    // empty column. Kept up to date as cells are set and lines cleared so the distance a tetromino
+    // can fall is a lookup against its bottom profile rather than a walk down the board.
+    //
+    int m_surface[ DYNAMIC ? BitBoard::MAX_WIDTH : W ];
 
     uint32_t m_colours[ NUM_TETROMINO ] = {
       0xFF00FFFF,
@@ -47,28 +92,39 @@ namespace game {
     //
     // Tetromino data.
     //
-    int m_curr_tetromino_idx;
+    PieceGenerator m_generator;
+
     int m_next_tetromino_idx;
-    Tetromino* m_curr_tetromino;
 
     //
-    // Position data.
+    // The falling tetromino.
     //
-    int m_previous_position_x;
-    int m_previous_position_y;
-
-    int m_current_position_x;
-    int m_current_position_y;
+    //    It's never written into m_state while it's falling, it's kept as an overlay and only
+    //    stamped into the board once it locks.
+    //
+    PieceState m_piece;
 
     //
     // Physics data.
     //
+    //    Everything is counted in whole ticks using the frame counts from rules.hpp, the same
+    //    rules sim::BoardBatch runs, so the two play identically.
+    //
+    // Ticks left before rotate is taken again.
+    int m_rotate_timer;
+
+    // Ticks left before a held movement key moves again, the first repeat waits the auto shift delay.
+    int m_move_timer;
     bool m_first_move;
-    double m_next_move_time;
-    double m_last_move_time;
-    double m_next_rotate_time;
-    double m_last_rotate_time;
-    double m_time_on_line;
+
+    // Ticks spent on the current line.
+    int m_gravity_timer;
+
+    // Whether input_hard_drop was held last tick, a hard drop only happens when it goes down.
+    bool m_hard_drop_held;
+
+    // Number of ticks advanced through step().
+    uint64_t m_ticks;
 
     //
     // Game state.
@@ -84,9 +140,6 @@ namespace game {
     //
     void initialize();
 
-    // Get the array index for a given row, column combination, access with m_state[...]
-    const int get_index( const int row, const int column ) const;
-
     // Spawn a new tetromino, reset any previous states, etc..
     void new_tetromino();
     bool can_spawn_tetromino();
@@ -94,30 +147,42 @@ namespace game {
     // TODO:
     //    Maybe all this can be abstracted out to it's own class.
     //    Piece::move() etc..
-    bool can_move_down( const Tetromino& tetromino, const int x, const int y );
-    bool can_move_side( const int side /* -1, 1 */ );
-    bool can_rotate();
+    bool can_move_down() const;
+    bool can_move_side( const int side /* -1, 1 */ ) const;
+    bool can_rotate() const;
 
-    void rotate_tetromino();
+    // Returns true if any cell of rotation placed at x, y is out of bounds or lands on a filled cell.
+    bool collides( const ShapeRotation& rotation, const int x, const int y ) const;
 
-    // Clears the current tetromino's mask from the board.
-    void clear_tetromino();
+    bool collides( const PieceState& piece ) const {
+      return collides( piece.shape(), piece.x, piece.y );
+    }
+
+    // Returns how many lines rotation placed at x, y can fall before it lands.
+    //
+    //    Every cell above the surface is empty, so while the tetromino is above the surface in
+    //    each of its columns the answer is the smallest gap between its bottom profile and the
+    //    surface. Tucked under an overhang it falls back to checking one line at a time.
+    //
+    const int drop_distance( const ShapeRotation& rotation, const int x, const int y ) const;
+
+    // Finds the highest filled cell in column x from line y down.
+    const int find_surface( const int x, const int y ) const;
+
+    // Writes the current tetromino into the board at its current position.
+    void lock_tetromino();
 
-    // Clears the current tetromino's previous mask from the board.
-    //    * not to be confused with ""previous tetromino""
-    //      this function uses the previous mask for the current tetromino, i.e., previous rotation.
-    void clear_prev_tetromino();
+    // Locks the current tetromino, clears any completed lines and spawns the next one.
+    void land_tetromino( StepResult& result );
 
-    // Draws the tetromino to the board.
-    void draw_tetromino();
+    // Returns the state of a cell with the current tetromino composited on top of the board.
+    const int get_draw_state( const int row, const int column ) const;
 
     //
     // Line clearing functions.
     //
-    int num_lines_completed();
-    bool is_line_complete( const int line );
-    void move_line_down( const int line );
-    void clear_completed_lines();
+    // Clears every completed line in one pass, returns a mask of the cleared lines (bit n being line n).
+    uint64_t clear_completed_lines();
 
     //
     // Score
@@ -127,10 +192,16 @@ namespace game {
     //
     // Physics
     //
-    void physics_start();
-    bool physics_rotate( const double t, const double dt );
-    void physics_move( const double t, const double dt );
-    bool physics_gravity( const double dt );
+    bool physics_rotate( const uint8_t input, StepResult& result );
+    void physics_move( const uint8_t input, StepResult& result );
+    bool physics_gravity( const uint8_t input, StepResult& result );
+
+    // Returns how many ticks from now the next event happens with input held (1 being the next
+    // tick), up to limit.
+    const uint64_t ticks_to_event( const uint8_t input, const uint64_t limit );
+
+    // Runs ticks with input held that are known to have nothing happen on them.
+    void skip_ticks( const uint8_t input, const uint64_t ticks );
 
     //
     // UI
@@ -139,7 +210,9 @@ namespace game {
     void draw_next_tetromino( const float x, const float y );
 
   public:
-    Board( Game* game );
+    BasicBoard( const uint64_t seed = 0, const RandomizerType randomizer = randomizer_uniform, const int preview_size = 1 ) requires( !DYNAMIC );
+
+    BasicBoard( const int rows, const int columns, const uint64_t seed = 0, const RandomizerType randomizer = randomizer_uniform, const int preview_size = 1 ) requires( DYNAMIC );
 
   public:
     const int get_state( const int row, const int column ) const;
@@ -152,19 +225,181 @@ namespace game {
   public:
     void draw( const float x, const float y );
 
-    void physics( const double t, const double dt );
+    // Advances the board by one fixed 1 / TICKS_PER_SECOND tick with the given InputState bitfield.
+    StepResult step( const uint8_t input );
+
+    //
+    // Advances the board by up to max_ticks ticks with the same input held, stopping after the
+    // first tick anything happens on. Returns the number of ticks advanced, result holds what
+    // happened on the last one.
+    //
+    //    The board ends up exactly as if step( input ) had been called that many times, but the
+    //    ticks leading up to the next event (gravity, a rotation or auto shift repeat coming off
+    //    cooldown, a lock) only count timers down so they're skipped over in one go.
+    //
+    const uint64_t fast_forward( const uint8_t input, const uint64_t max_ticks, StepResult& result );
 
     void update();
 
+    //
+    // Fills list with every distinct place the falling tetromino can come to rest, starting from
+    // where it is now and following the same movement rules as the physics (moving sideways,
+    // rotating and moving down one line at a time), so tucks and spins under overhangs are found.
+    //
+    //    Timing isn't taken into account, the tetromino is assumed to have as long as it needs
+    //    on every line. Placements covering the same cells are only reported once, with the
+    //    shortest path to reach them.
+    //
+    void find_placements( PlacementList& list ) const;
+
+    // Moves the falling tetromino straight to a placement from find_placements and locks it
+    // there, as if it had been steered there and landed.
+    StepResult place( const Placement& placement );
+
+    // Starts a new game, the tetromino sequence carries on from where the last game left off.
     void reset();
 
+    // Starts a new game with the tetromino sequence restarted from the given seed.
+    void reset( const uint64_t seed );
+
+    // Captures the whole state of the board, for keyframes in replays.
+    BoardSnapshot snapshot() const requires( DYNAMIC || W <= BitBoard::MAX_WIDTH );
+
+    // Puts the board back the way it was when the snapshot was taken. The board has to have the
+    // same size, randomizer and preview size as the one the snapshot came from.
+    void restore( const BoardSnapshot& snapshot ) requires( DYNAMIC || W <= BitBoard::MAX_WIDTH );
+
+    // Size of the board in cells, rows being x (across) and columns being y (down).
+    const int rows() const {
+      return m_state.width();
+    }
+
+    const int columns() const {
+      return m_state.height();
+    }
+
+    // Returns the tetromino index n places ahead of the current one in the preview queue
+    // (0 being the next tetromino), n is clamped to the preview size.
+    const int preview( const int n ) const {
+      return m_generator.peek( n );
+    }
+
+    const int preview_size() const {
+      return m_generator.preview_size();
+    }
+
+    const uint64_t seed() const {
+      return m_generator.seed();
+    }
+
+    const RandomizerType randomizer() const {
+      return m_generator.type();
+    }
+
+    // Ticks advanced since the game started.
+    const uint64_t ticks() const {
+      return m_ticks;
+    }
+
     const int score() const {
       return m_score;
     }
 
+    const int level() const {
+      return m_level;
+    }
+
+    const int lines_cleared() const {
+      return m_lines_cleared;
+    }
+
+    // The falling tetromino.
+    const PieceState& piece() const {
+      return m_piece;
+    }
+
+    // Index of the falling tetromino (into TETROMINO_TABLE), its rotation index and position.
+    const int tetromino() const {
+      return m_piece.type;
+    }
+
+    const int rotation() const {
+      return m_piece.rotation;
+    }
+
+    const int position_x() const {
+      return m_piece.x;
+    }
+
+    const int position_y() const {
+      return m_piece.y;
+    }
+
+    // Zobrist hash of the locked cells alone.
+    const uint64_t board_hash() const;
+
+    // Zobrist hash of the locked cells plus the falling and next tetromino.
+    const uint64_t hash() const;
+
+    // Returns the occupancy mask of a line of locked cells (bit n being x = n).
+    const line_t line( const int y ) const {
+      return m_state.line( y );
+    }
+
+    // Line of the highest filled cell in column x (across), columns() if the column is empty.
+    const int surface( const int x ) const {
+      return m_surface[ x ];
+    }
+
+    // Number of lines from the floor up to and including the highest filled cell in column x.
+    const int column_height( const int x ) const {
+      return columns() - m_surface[ x ];
+    }
+
+    // How many lines the falling tetromino can drop before it lands.
+    const int drop_distance() const {
+      return drop_distance( m_piece.shape(), m_piece.x, m_piece.y );
+    }
+
+    // Line the falling tetromino would land on if it were dropped now (where the ghost is drawn).
+    const int ghost_y() const {
+      return m_piece.y + drop_distance();
+    }
+
     const bool is_game_over() const {
       return m_game_over;
     }
   };
 
+  extern template class BasicBoard< 10, 20 >;
+  extern template class BasicBoard< 10, 40 >;
+  extern template class BasicBoard< 4, 20 >;
+  extern template class BasicBoard< DYNAMIC_SIZE, DYNAMIC_SIZE >;
+  extern template class BasicBoard< 32, 20 >;
+  extern template class BasicBoard< 64, 20 >;
+  extern template class BasicBoard< 128, 20 >;
+
+  // The standard 10 x 20 well.
+  using Board = BasicBoard< 10, 20 >;
+
+  // A plain 10 x 40 well. Pieces spawn at the top like any other size and all 40 lines are in
+  // play, there's no hidden buffer zone or lock out above a visible 20.
+  using TallBoard = BasicBoard< 10, 40 >;
+
+  // A 4 x 20 well for puzzles.
+  using PuzzleBoard = BasicBoard< 4, 20 >;
+
+  // A board sized at run time.
+  using DynamicBoard = BasicBoard< DYNAMIC_SIZE, DYNAMIC_SIZE >;
+
+  //
+  // 32, 64 and 128 wide wells for co-op and stress runs.
+  //
+  //    Lines are a uint32_t, a uint64_t or a 128 bit LineMask, so collisions and line clears cost
+  //    about the same as on a 10 wide board. They're headless only, there's no placement search
+  //    or drawing past BitBoard::MAX_WIDTH.
+  //
+  template< int W >
+  using WideBoard = BasicBoard< W, 20 >;
+
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <game/board.hpp>
+
+namespace game {
+
+  //
+  // A board as rebuilt from a stream, what a spectator draws from.
+  //
+  struct StreamedBoard {
+    int width;
+    int height;
+    int preview_size;
+
+    uint64_t ticks;
+
+    // Occupancy mask of each line (bit n being x = n) and the block state of each cell packed 4
+    // bits per cell, the same layout as BitBoard.
+    uint32_t lines[ BitBoard::MAX_HEIGHT ];
+    uint64_t colours[ BitBoard::MAX_HEIGHT ];
+
+    PieceState piece;
+    uint8_t preview[ PieceGenerator::MAX_PREVIEW ];
+
+    int score;
+    int lines_cleared;
+    int level;
+    bool game_over;
+
+    // Returns the block state of a locked cell (0 being empty).
+    const int get( const int x, const int y ) const {
+      return ( int ) ( ( colours[ y ] >> ( x * 4 ) ) & 0xF );
+    }
+  };
+
+  //
+  // Streams the state of a board tick by tick, sending only what changed.
+  //
+  //    Each tick something changes on is one frame, a header byte saying which parts changed
+  //    followed by just those parts:
+  //
+  //      FRAME_PIECE_X       varint, zigzag x delta of the falling tetromino
+  //      FRAME_PIECE_Y       varint, zigzag y delta
+  //      FRAME_PIECE_SHAPE   u8, type << 4 | rotation
+  //      FRAME_LOCKED        u8 block state of the cells locked, varint mask of the lines
+  //                          cleared, varint mask of the lines changed, then a varint per changed
+  //                          line of its occupancy XOR'd with the line before (after the cleared
+  //                          lines have been taken out)
+  //      FRAME_PREVIEW       u8 per preview slot
+  //      FRAME_STATS         varint, zigzag deltas of score, lines cleared and level
+  //      FRAME_GAME_OVER     nothing, the board has topped out
+  //
+  //    Runs of ticks nothing visible happens on (most of them, the tetromino only moves every
+  //    few ticks) are a single FRAME_IDLE with a varint tick count, so a game averages well
+  //    under a byte per tick.
+  //
+  //    Every resync_interval ticks, and whenever the board doesn't carry on from the last tick
+  //    (reset, restored or a different board), a FRAME_RESYNC holds the whole board instead, the
+  //    line masks as varints and the block state of each filled cell 2 to a byte. A spectator
+  //    joining mid game is sent the stream from the last resync (resync_offset()).
+  //
+  //    All varints are LEB128, 7 bits a byte, lowest first.
+  //
+  class BoardStreamEncoder {
+  public:
+    enum FrameFlags : uint8_t {
+      FRAME_PIECE_X = 1 << 0,
+      FRAME_PIECE_Y = 1 << 1,
+      FRAME_PIECE_SHAPE = 1 << 2,
+      FRAME_LOCKED = 1 << 3,
+      FRAME_PREVIEW = 1 << 4,
+      FRAME_STATS = 1 << 5,
+      FRAME_GAME_OVER = 1 << 6,
+
+      // Headers with the top bit set are whole frames of their own.
+      FRAME_IDLE = 0x80,
+      FRAME_RESYNC = 0x81,
+    };
+
+    // 10 seconds of play.
+    static constexpr int DEFAULT_RESYNC_INTERVAL = 600;
+
+  private:
+    std::vector< uint8_t > m_data;
+    size_t m_resync_offset;
+    int m_resync_interval;
+
+    // The board as the stream last left it.
+    StreamedBoard m_last;
+    bool m_started;
+    uint64_t m_last_resync;
+
+    // Ticks since the last frame with nothing to send yet.
+    uint64_t m_idle;
+
+  private:
+    void flush_idle();
+
+    template< int W, int H >
+    void write_resync( const BasicBoard< W, H >& board );
+
+  public:
+    BoardStreamEncoder( const int resync_interval = DEFAULT_RESYNC_INTERVAL );
+
+    //
+    // Adds the board after a step (or a fast_forward of ticks ticks) to the stream, result being
+    // what the step returned. Defined for Board, TallBoard, PuzzleBoard and DynamicBoard, boards
+    // wider than BitBoard::MAX_WIDTH can't be streamed.
+    //
+    template< int W, int H >
+    void encode( const BasicBoard< W, H >& board, const StepResult& result, const uint64_t ticks = 1 );
+
+    // Writes out a pending run of idle ticks, for when the stream is about to be sent.
+    void flush() {
+      flush_idle();
+    }
+
+    // Drops everything encoded so far, the next board is sent as a resync.
+    void clear();
+
+    const std::vector< uint8_t >& data() const {
+      return m_data;
+    }
+
+    // Offset of the last resync frame in data(), where a spectator joining now starts reading.
+    const size_t resync_offset() const {
+      return m_resync_offset;
+    }
+  };
+
+  //
+  // Rebuilds the board from a BoardStreamEncoder stream.
+  //
+  class BoardStreamDecoder {
+  private:
+    StreamedBoard m_board;
+    bool m_synced;
+    bool m_error;
+
+  public:
+    BoardStreamDecoder();
+
+    //
+    // Reads one frame from [data, end) and applies it, returns the first byte after it. Returns
+    // data if the frame isn't all there yet (nothing is applied), or nullptr if it's invalid.
+    // Everything before the first resync frame is invalid.
+    //
+    const uint8_t* decode_frame( const uint8_t* data, const uint8_t* end );
+
+    // Applies every whole frame in the buffer, returns the number of bytes used. A frame cut off
+    // at the end is left for the next call, check error() for invalid data.
+    size_t decode( const uint8_t* data, const size_t size );
+
+    // Goes back to waiting for a resync frame.
+    void reset();
+
+    const StreamedBoard& board() const {
+      return m_board;
+    }
+
+    const bool is_synced() const {
+      return m_synced;
+    }
+
+    const bool error() const {
+      return m_error;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace game {
+
+  //
+  // Little endian values of a fixed number of bytes (up to 8), the way replay files and network
+  // messages store them whatever the byte order of the machine writing them.
+  //
+  //    The pointer versions move the pointer past what they wrote or read. Nothing is bounds
+  //    checked, callers know the size of what they write and check sizes before reading.
+  //
+  inline void put_bytes( uint8_t*& out, const uint64_t value, const int bytes ) {
+    for( int i{}; i < bytes; ++i ) {
+      *out++ = ( uint8_t ) ( value >> ( i * 8 ) );
+    }
+  }
+
+  inline void put_bytes( std::vector< uint8_t >& out, const uint64_t value, const int bytes ) {
+    for( int i{}; i < bytes; ++i ) {
+      out.push_back( ( uint8_t ) ( value >> ( i * 8 ) ) );
+    }
+  }
+
+  inline uint64_t get_bytes( const uint8_t*& in, const int bytes ) {
+    uint64_t value = 0;
+
+    for( int i{}; i < bytes; ++i ) {
+      value |= ( uint64_t ) *in++ << ( i * 8 );
+    }
+
+    return value;
+  }
+
+}
\ No newline at end of file
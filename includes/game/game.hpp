@@ -1,7 +1,10 @@
 #pragma once
 
 #include <windows.h>
+#include <vector>
 #include <game/board.hpp>
+#include <game/replay.hpp>
+#include <bot/autoplayer.hpp>
 #include <audio.hpp>
 
 // forward delcarations.
@@ -17,9 +20,41 @@ namespace game {
     Board m_board;
     app::Audio m_music;
 
+    // Plays the game by itself when autoplay is on, restarting whenever it tops out (attract mode).
+    bot::Autoplayer m_autoplayer;
+    bool m_autoplay;
+
+    // Every tick of the current game, written out to REPLAY_PATH when it ends.
+    Replay m_replay;
+
+    //
+    // Replay viewer, shows the last game saved to REPLAY_PATH in place of the current one (which
+    // stays paused) with a window to play, scrub and jump through it.
+    //
+    bool m_viewing;
+    bool m_view_playing;
+    int m_view_speed;
+    uint64_t m_view_tick;
+    uint64_t m_view_jump;
+    std::vector< uint8_t > m_view_data;
+    SeekableReplay m_view_replay;
+    Board m_view_board;
+
     bool m_draw_metrics;
     bool m_paused;
 
+  private:
+    // Reads the keys held down for this physics tick into an InputState bitfield.
+    uint8_t read_input() const;
+
+    // Opens REPLAY_PATH in the viewer, returns false if there's no replay there to watch.
+    bool open_replay();
+
+    // Moves the viewer to a tick of the replay.
+    void seek_replay( const uint64_t tick );
+
+    void draw_replay_window();
+
   public:
     Game();
 
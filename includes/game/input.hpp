@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+namespace game {
+
+  //
+  // Keys held down during a physics tick, the board never reads the keyboard itself so the
+  // same rules can be driven by a window, a bot or a replay.
+  //
+  enum InputState : uint8_t {
+    input_none = 0,
+    input_left = 1 << 0,
+    input_right = 1 << 1,
+    input_rotate = 1 << 2,
+    input_soft_drop = 1 << 3,
+
+    // Drops the tetromino as far as it goes and locks it, on the tick the key goes down.
+    input_hard_drop = 1 << 4,
+
+    // The game was paused for the tick, the board isn't stepped. Only ever seen in replays.
+    input_pause = 1 << 5,
+  };
+
+  //
+  // Things that happened during a physics tick.
+  //
+  enum EventState : uint32_t {
+    event_none = 0,
+    event_moved = 1 << 0,
+    event_rotated = 1 << 1,
+    event_dropped = 1 << 2,
+    event_locked = 1 << 3,
+    event_lines_cleared = 1 << 4,
+    event_level_up = 1 << 5,
+    event_spawned = 1 << 6,
+    event_game_over = 1 << 7,
+  };
+
+  struct StepResult {
+    // Bitfield of EventState.
+    uint32_t events;
+
+    // Lines cleared during the tick (bit n being line n, before they were removed).
+    uint64_t cleared_lines;
+  };
+
+}
\ No newline at end of file
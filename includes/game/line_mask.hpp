@@ -0,0 +1,193 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define LINE_MASK_SSE2
+#include <immintrin.h>
+#endif
+
+namespace game {
+
+  //
+  // Occupancy of a line wider than 64 cells, as WORDS 64 bit words (bit n of word w being
+  // x = w * 64 + n).
+  //
+  //    Only what a board needs from a line is here: building one from a tetromino's cells,
+  //    testing and setting single cells, and comparing or intersecting whole lines. The whole
+  //    line operations take two words at a time with SSE2, so a 128 cell line costs the same
+  //    single AND or compare a native integer line does.
+  //
+  template< int WORDS >
+  struct alignas( 16 ) LineMask {
+    uint64_t words[ WORDS ];
+
+    constexpr bool test( const int x ) const {
+      return ( words[ x >> 6 ] >> ( x & 63 ) ) & 1;
+    }
+
+    constexpr void set( const int x ) {
+      words[ x >> 6 ] |= 1ull << ( x & 63 );
+    }
+
+    constexpr void reset( const int x ) {
+      words[ x >> 6 ] &= ~( 1ull << ( x & 63 ) );
+    }
+
+    // Returns true if any cell is set in both lines.
+    bool overlaps( const LineMask& other ) const {
+#if defined( LINE_MASK_SSE2 )
+      if constexpr( WORDS % 2 == 0 ) {
+        __m128i any = _mm_setzero_si128();
+
+        for( int i{}; i < WORDS; i += 2 ) {
+          const __m128i a = _mm_load_si128( ( const __m128i* ) &words[ i ] );
+          const __m128i b = _mm_load_si128( ( const __m128i* ) &other.words[ i ] );
+          any = _mm_or_si128( any, _mm_and_si128( a, b ) );
+        }
+
+        return _mm_movemask_epi8( _mm_cmpeq_epi8( any, _mm_setzero_si128() ) ) != 0xFFFF;
+      }
+#endif
+
+      uint64_t any = 0;
+      for( int i{}; i < WORDS; ++i ) {
+        any |= words[ i ] & other.words[ i ];
+      }
+
+      return any != 0;
+    }
+
+    bool operator==( const LineMask& other ) const {
+#if defined( LINE_MASK_SSE2 )
+      if constexpr( WORDS % 2 == 0 ) {
+        __m128i diff = _mm_setzero_si128();
+
+        for( int i{}; i < WORDS; i += 2 ) {
+          const __m128i a = _mm_load_si128( ( const __m128i* ) &words[ i ] );
+          const __m128i b = _mm_load_si128( ( const __m128i* ) &other.words[ i ] );
+          diff = _mm_or_si128( diff, _mm_xor_si128( a, b ) );
+        }
+
+        return _mm_movemask_epi8( _mm_cmpeq_epi8( diff, _mm_setzero_si128() ) ) == 0xFFFF;
+      }
+#endif
+
+      uint64_t diff = 0;
+      for( int i{}; i < WORDS; ++i ) {
+        diff |= words[ i ] ^ other.words[ i ];
+      }
+
+      return diff == 0;
+    }
+  };
+
+  //
+  // The operations a board needs from a line, for native integer lines and LineMask alike.
+  //
+
+  // Returns a line with the first n cells set.
+  template< typename Line >
+  constexpr Line make_full_line( const int n ) {
+    if constexpr( std::is_integral_v< Line > ) {
+      return n >= 64 ? ( Line ) ~0ull : ( Line ) ( ( 1ull << n ) - 1 );
+    }
+    else {
+      Line line{};
+      for( int x{}; x < n; ++x ) {
+        line.set( x );
+      }
+
+      return line;
+    }
+  }
+
+  // Returns the cells of a tetromino's line (bit n being x + n) moved to start at x, which can
+  // be negative for a tetromino whose first rows are empty.
+  template< typename Line >
+  constexpr Line make_line( uint32_t cells, int x ) {
+    if( x < 0 ) {
+      cells >>= -x;
+      x = 0;
+    }
+
+    if constexpr( std::is_integral_v< Line > ) {
+      return ( Line ) ( ( uint64_t ) cells << x );
+    }
+    else {
+      Line line{};
+
+      // The 4 cells of a tetromino's line straddle at most two words.
+      const int word = x >> 6;
+      const int shift = x & 63;
+
+      line.words[ word ] = ( uint64_t ) cells << shift;
+      if( shift > 60 && word + 1 < ( int ) std::size( line.words ) ) {
+        line.words[ word + 1 ] = ( uint64_t ) cells >> ( 64 - shift );
+      }
+
+      return line;
+    }
+  }
+
+  template< typename Line >
+  constexpr bool line_test( const Line& line, const int x ) {
+    if constexpr( std::is_integral_v< Line > ) {
+      return ( line >> x ) & 1;
+    }
+    else {
+      return line.test( x );
+    }
+  }
+
+  template< typename Line >
+  constexpr void line_set( Line& line, const int x, const bool filled ) {
+    if constexpr( std::is_integral_v< Line > ) {
+      if( filled ) {
+        line |= ( Line ) ( 1ull << x );
+      }
+      else {
+        line &= ( Line ) ~( 1ull << x );
+      }
+    }
+    else {
+      if( filled ) {
+        line.set( x );
+      }
+      else {
+        line.reset( x );
+      }
+    }
+  }
+
+  template< typename Line >
+  bool lines_overlap( const Line& a, const Line& b ) {
+    if constexpr( std::is_integral_v< Line > ) {
+      return ( a & b ) != 0;
+    }
+    else {
+      return a.overlaps( b );
+    }
+  }
+
+  // Calls f( x ) for every filled cell of a line, lowest x first.
+  template< typename Line, typename F >
+  constexpr void for_each_cell( const Line& line, F&& f ) {
+    if constexpr( std::is_integral_v< Line > ) {
+      for( uint64_t bits = line; bits != 0; bits &= bits - 1 ) {
+        f( std::countr_zero( bits ) );
+      }
+    }
+    else {
+      for( int i{}; i < ( int ) std::size( line.words ); ++i ) {
+        for( uint64_t bits = line.words[ i ]; bits != 0; bits &= bits - 1 ) {
+          f( i * 64 + std::countr_zero( bits ) );
+        }
+      }
+    }
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <game/shape.hpp>
+
+namespace game {
+
+  //
+  // The falling tetromino: which one it is, its rotation and where it is on the board.
+  //
+  //    Everything else about it comes from the shared, immutable TETROMINO_TABLE, so this is
+  //    all there is to copy when a board is copied, a search tries a move or a snapshot is taken.
+  //    Moving or rotating gives back a new state rather than changing the shape.
+  //
+  struct PieceState {
+    // Index into TETROMINO_TABLE.
+    uint8_t type;
+
+    // Rotation index into the tetromino's rotations.
+    uint8_t rotation;
+
+    // Position of the top left of the tetromino's 4x4 mask, x across and y down.
+    int16_t x;
+    int16_t y;
+
+    constexpr const Tetromino& tetromino() const {
+      return TETROMINO_TABLE[ type ];
+    }
+
+    constexpr const ShapeRotation& shape() const {
+      return tetromino().rotation( rotation );
+    }
+
+    // Returns the state turned to the next rotation.
+    constexpr PieceState rotated() const {
+      return { type, ( uint8_t ) tetromino().next_rotation( rotation ), x, y };
+    }
+
+    // Returns the state moved by dx, dy.
+    constexpr PieceState moved( const int dx, const int dy ) const {
+      return { type, rotation, ( int16_t ) ( x + dx ), ( int16_t ) ( y + dy ) };
+    }
+
+    constexpr bool operator==( const PieceState& other ) const = default;
+  };
+
+  static_assert( std::is_trivially_copyable_v< PieceState > && sizeof( PieceState ) == 6 );
+
+  // Whether a type and rotation read from outside (a file, a stream) index a real shape.
+  constexpr bool valid_shape( const uint8_t type, const uint8_t rotation ) {
+    return type < NUM_TETROMINO && rotation < TETROMINO_TABLE[ type ].num_rotations();
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <game/bitboard.hpp>
+
+namespace game {
+
+  //
+  // A single step taken by the current tetromino on its way to a placement, these are the
+  // movements the board's physics can make (there's no rotating backwards and no moving up).
+  //
+  enum Move : uint8_t {
+    move_left = 0,
+    move_right,
+    move_rotate,
+    move_down,
+  };
+
+  //
+  // A final resting position of the current tetromino, i.e., somewhere it can't move down from.
+  //
+  struct Placement {
+    // Rotation index and position of the tetromino, the same values the board uses while it falls.
+    int rotation;
+    int x;
+    int y;
+
+    // The cells covered, as line masks (bit n being x = n) for the lines top, top + 1, ..
+    int top;
+    BitBoard::line_t lines[ 4 ];
+
+    // Where the moves to get here live in the owning PlacementList.
+    uint32_t path_offset;
+    uint32_t path_length;
+  };
+
+  //
+  // Output of Board::find_placements.
+  //
+  //    Keep one around and pass it in again, clearing keeps the storage so repeated searches
+  //    don't allocate.
+  //
+  class PlacementList {
+  private:
+    std::vector< Placement > m_placements;
+    std::vector< uint8_t > m_moves;
+
+  public:
+    void clear() {
+      m_placements.clear();
+      m_moves.clear();
+    }
+
+    // Appends a placement with room for a path of path_length moves, returns where the moves go.
+    uint8_t* add( const Placement& placement, const uint32_t path_length ) {
+      Placement& added = m_placements.emplace_back( placement );
+      added.path_offset = ( uint32_t ) m_moves.size();
+      added.path_length = path_length;
+
+      m_moves.resize( m_moves.size() + path_length );
+      return m_moves.data() + added.path_offset;
+    }
+
+    // Returns true if a placement covering exactly the same cells has already been added.
+    const bool contains( const int top, const BitBoard::line_t lines[ 4 ] ) const {
+      for( const Placement& placement : m_placements ) {
+        if( placement.top == top &&
+          placement.lines[ 0 ] == lines[ 0 ] && placement.lines[ 1 ] == lines[ 1 ] &&
+          placement.lines[ 2 ] == lines[ 2 ] && placement.lines[ 3 ] == lines[ 3 ] ) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    const size_t size() const {
+      return m_placements.size();
+    }
+
+    const bool empty() const {
+      return m_placements.empty();
+    }
+
+    const Placement& operator[]( const size_t idx ) const {
+      return m_placements[ idx ];
+    }
+
+    std::vector< Placement >::const_iterator begin() const {
+      return m_placements.begin();
+    }
+
+    std::vector< Placement >::const_iterator end() const {
+      return m_placements.end();
+    }
+
+    // Returns the moves (Move values) that take the tetromino from where the search started to the placement.
+    const uint8_t* path( const Placement& placement ) const {
+      return m_moves.data() + placement.path_offset;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+#include <game/shape.hpp>
+
+namespace game {
+
+  //
+  // Small, fast and seedable random number generator (xoshiro128**, https://prng.di.unimi.it/).
+  //
+  //    The whole state is 16 bytes and trivially copyable, so a board (and its upcoming pieces)
+  //    can be snapshotted and replayed exactly from a seed.
+  //
+  class Random {
+  private:
+    uint32_t m_state[ 4 ];
+
+  public:
+    Random( const uint64_t seed = 0 );
+
+    // Re-initializes the state from a 64 bit seed (expanded with splitmix64).
+    void seed( const uint64_t seed );
+
+    uint32_t next();
+
+    // Returns a uniformly distributed number in the range [0, bound).
+    uint32_t next_below( const uint32_t bound );
+
+    // The raw generator state, for snapshots.
+    const uint32_t* state() const {
+      return m_state;
+    }
+
+    void set_state( const uint32_t state[ 4 ] );
+  };
+
+  //
+  // The different ways of picking the next tetromino.
+  //
+  enum RandomizerType {
+    // Every tetromino has an equal chance of being picked each time.
+    randomizer_uniform = 0,
+
+    // All 7 tetromino are shuffled into a bag and dealt out before the bag is refilled.
+    randomizer_bag,
+
+    // NES style, pick from 8 outcomes and reroll once if it's the "8th" or a repeat of the last pick.
+    randomizer_nes,
+  };
+
+  //
+  // Where a PieceGenerator is in its sequence, enough to carry on dealing exactly where it left
+  // off (see PieceGenerator::state), the randomizer and preview size aren't included.
+  //
+  struct GeneratorState {
+    uint32_t random[ 4 ];
+    uint64_t seed;
+
+    uint8_t bag[ NUM_TETROMINO ];
+    int bag_size;
+    int last;
+
+    // PieceGenerator::MAX_PREVIEW entries.
+    uint8_t queue[ NUM_TETROMINO ];
+    int queue_start;
+  };
+
+  //
+  // Deals out tetromino indices for a board and keeps a queue of the upcoming ones filled ahead
+  // of time so they can be previewed.
+  //
+  class PieceGenerator {
+  public:
+    static constexpr int MAX_PREVIEW = 7;
+
+  private:
+    Random m_random;
+    RandomizerType m_type;
+    uint64_t m_seed;
+
+    // Remaining tetromino in the bag (randomizer_bag).
+    uint8_t m_bag[ NUM_TETROMINO ];
+    int m_bag_size;
+
+    // The last tetromino picked (randomizer_nes).
+    int m_last;
+
+    // Ring buffer of upcoming tetromino, the front is the next one to be dealt.
+    uint8_t m_queue[ MAX_PREVIEW ];
+    int m_queue_start;
+    int m_preview_size;
+
+  private:
+    int pick();
+
+  public:
+    PieceGenerator( const uint64_t seed = 0, const RandomizerType type = randomizer_uniform, const int preview_size = 1 );
+
+    // Restarts the sequence from the given seed.
+    void reset( const uint64_t seed );
+
+    // Deals out the next tetromino index and tops the preview queue back up.
+    int next();
+
+    // Returns the tetromino index n places ahead in the queue (0 being the next one dealt),
+    // n is clamped to the preview size.
+    int peek( const int n ) const;
+
+    const int preview_size() const {
+      return m_preview_size;
+    }
+
+    const uint64_t seed() const {
+      return m_seed;
+    }
+
+    const RandomizerType type() const {
+      return m_type;
+    }
+
+    GeneratorState state() const;
+
+    void restore( const GeneratorState& state );
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <game/board.hpp>
+#include <game/input.hpp>
+#include <game/random.hpp>
+
+namespace game {
+
+  //
+  // A recorded game, the seed and randomizer the board started from and the InputState of every
+  // physics tick after that, paused ticks included (as input_pause).
+  //
+  //    Recording is one byte appended per tick, the file is only written once the game is over.
+  //    The score, lines and hash the game ended on are stored with it, so playing it back on
+  //    another build shows straight away whether that build plays the game the same way.
+  //
+  //    File layout, all values little endian:
+  //
+  //      u32  MAGIC
+  //      u32  VERSION
+  //      u64  seed
+  //      u8   randomizer
+  //      u8   preview size
+  //      u16  reserved (0)
+  //      u64  number of ticks
+  //      i32  final score
+  //      i32  final lines cleared
+  //      u64  final Board::hash
+  //      u8   input for each tick
+  //
+  class Replay {
+    friend class SeekableReplay;
+
+  public:
+    static constexpr uint32_t MAGIC = 0x4C505254; // "TRPL"
+    static constexpr uint32_t VERSION = 1;
+
+  private:
+    uint64_t m_seed;
+    RandomizerType m_randomizer;
+    int m_preview_size;
+
+    std::vector< uint8_t > m_inputs;
+
+    // The board at the end of the recording.
+    bool m_finished;
+    int m_score;
+    int m_lines;
+    uint64_t m_hash;
+
+  public:
+    Replay();
+
+    // Starts a new recording for a board that's just been reset.
+    void start( const Board& board );
+
+    // Appends the input for a tick.
+    void record( const uint8_t input ) {
+      m_inputs.push_back( input );
+    }
+
+    // Ends the recording, noting the state the board ended up in.
+    void finish( const Board& board );
+
+    // Returns false if the file couldn't be written.
+    bool save( const char* path ) const;
+
+    // Returns false if the file couldn't be read or isn't a replay of this version, the replay
+    // is left empty. Reads SeekableReplay files as well.
+    bool load( const char* path );
+
+    const uint64_t seed() const {
+      return m_seed;
+    }
+
+    const RandomizerType randomizer() const {
+      return m_randomizer;
+    }
+
+    const int preview_size() const {
+      return m_preview_size;
+    }
+
+    // Number of ticks recorded.
+    const size_t size() const {
+      return m_inputs.size();
+    }
+
+    const uint8_t input( const size_t tick ) const {
+      return m_inputs[ tick ];
+    }
+
+    const uint8_t* inputs() const {
+      return m_inputs.data();
+    }
+
+    const bool is_finished() const {
+      return m_finished;
+    }
+
+    const int score() const {
+      return m_score;
+    }
+
+    const int lines() const {
+      return m_lines;
+    }
+
+    const uint64_t hash() const {
+      return m_hash;
+    }
+  };
+
+  //
+  // A replay with keyframes, so it can be started from any tick without playing everything
+  // before it.
+  //
+  //    The inputs are split into chunks of keyframe_interval ticks, each chunk following a
+  //    keyframe of the board (see BoardSnapshot) as it was before the chunk's first tick, and
+  //    an index at the end holds the offset of each chunk. Getting to tick t is reading index
+  //    entry t / keyframe_interval, restoring that keyframe and playing fewer than
+  //    keyframe_interval ticks from there, however long the replay is.
+  //
+  //    Everything is read straight out of the bytes handed to open(), so a memory mapped file
+  //    works as well as one read into memory and only the pages touched are loaded.
+  //
+  //    File layout, all values little endian:
+  //
+  //      u32  MAGIC
+  //      u32  VERSION
+  //      u64  seed
+  //      u8   randomizer
+  //      u8   preview size
+  //      u8   board width
+  //      u8   board height
+  //      u32  keyframe interval
+  //      u64  number of ticks
+  //      u64  number of keyframes
+  //      u64  offset of the index
+  //      i32  final score
+  //      i32  final lines cleared
+  //      u64  final Board::hash
+  //
+  //      for each keyframe:
+  //        keyframe (KEYFRAME_SIZE + width * height bytes)
+  //        u8   input for each tick up to the next keyframe
+  //
+  //      u64  offset of each keyframe
+  //
+  class SeekableReplay {
+  public:
+    static constexpr uint32_t MAGIC = 0x4B505254; // "TRPK"
+    static constexpr uint32_t VERSION = 1;
+
+    // 10 seconds of play.
+    static constexpr int DEFAULT_KEYFRAME_INTERVAL = 600;
+
+    static constexpr size_t HEADER_SIZE = 64;
+
+    // Size of a keyframe without its cells.
+    static constexpr size_t KEYFRAME_SIZE = 96;
+
+  private:
+    const uint8_t* m_data;
+    size_t m_size;
+
+    uint64_t m_seed;
+    RandomizerType m_randomizer;
+    int m_preview_size;
+    int m_width;
+    int m_height;
+
+    int m_keyframe_interval;
+    uint64_t m_ticks;
+    uint64_t m_keyframes;
+    const uint8_t* m_index;
+
+    int m_score;
+    int m_lines;
+    uint64_t m_hash;
+
+  private:
+    // Returns where the inputs of the chunk holding tick start.
+    const uint8_t* chunk_inputs( const uint64_t tick ) const;
+
+  public:
+    SeekableReplay();
+
+    //
+    // Writes a replay out with a keyframe every keyframe_interval ticks, the keyframes are taken
+    // by playing it through once. Returns false if the file couldn't be written.
+    //
+    static bool write( const Replay& replay, const char* path, const int keyframe_interval = DEFAULT_KEYFRAME_INTERVAL );
+
+    // Reads a replay from memory (a mapped file or a file read into memory), which has to stay
+    // valid for as long as this does. Returns false if it isn't a valid replay of this version.
+    bool open( const uint8_t* data, const size_t size );
+
+    // Copies the inputs and results out into a plain replay.
+    void extract( Replay& replay ) const;
+
+    // Returns a board set up to play this replay from the start.
+    Board make_board() const;
+
+    // Puts board in the state it was in just before tick was played (tick = size() being the
+    // end of the replay).
+    void seek( Board& board, const uint64_t tick ) const;
+
+    // Plays the recorded inputs for ticks [from, from + ticks) on board, paused ticks are
+    // skipped. Returns the tick played up to.
+    const uint64_t play( Board& board, const uint64_t from, const uint64_t ticks ) const;
+
+    const uint8_t input( const uint64_t tick ) const {
+      return chunk_inputs( tick )[ tick % m_keyframe_interval ];
+    }
+
+    // Number of ticks recorded.
+    const uint64_t size() const {
+      return m_ticks;
+    }
+
+    const int keyframe_interval() const {
+      return m_keyframe_interval;
+    }
+
+    const uint64_t keyframes() const {
+      return m_keyframes;
+    }
+
+    const uint64_t seed() const {
+      return m_seed;
+    }
+
+    const int score() const {
+      return m_score;
+    }
+
+    const int lines() const {
+      return m_lines;
+    }
+
+    const uint64_t hash() const {
+      return m_hash;
+    }
+  };
+
+  //
+  // Plays a replay back on a board of its own, no window needed.
+  //
+  class ReplayPlayer {
+  private:
+    const Replay& m_replay;
+    Board m_board;
+
+    // Index of the next tick to play.
+    size_t m_tick;
+
+  public:
+    ReplayPlayer( const Replay& replay );
+
+    // Goes back to the start of the replay.
+    void restart();
+
+    // Plays the next recorded tick.
+    StepResult step();
+
+    //
+    // Plays up to ticks recorded ticks as fast as possible, returns the number played.
+    //
+    //    Each run of ticks with the same input goes through Board::fast_forward and paused runs
+    //    are skipped over in one go, so a replay plays back at millions of ticks per second.
+    //
+    const uint64_t run( const uint64_t ticks );
+
+    // Returns true once every tick has been played and the board ended up the way the
+    // recording did.
+    const bool matches() const;
+
+    const bool is_finished() const {
+      return m_tick >= m_replay.size();
+    }
+
+    const size_t tick() const {
+      return m_tick;
+    }
+
+    const Board& board() const {
+      return m_board;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+//
+// Scoring, levelling and timing rules shared by everything that simulates a board.
+//
+//    Timings are expressed in physics ticks (frames) at 60 ticks per second and kept as integer
+//    tick counters, so a game plays out exactly the same from the same seed and inputs whatever
+//    the compiler or floating point settings.
+//
+
+namespace game {
+
+  // Ticks a rotation has to wait before the tetromino can be rotated again.
+  constexpr int ROTATE_FRAMES = 6;
+
+  // Ticks before a held movement key starts repeating (delayed auto shift) and the repeat rate after that.
+  //    https://en.wikipedia.org/wiki/Tetris_(NES_video_game)
+  constexpr int DAS_FRAMES = 16;
+  constexpr int ARR_FRAMES = 6;
+
+  // Ticks spent on a line while soft dropping.
+  constexpr int SOFT_DROP_FRAMES = 2;
+
+  // Points for each line a tetromino is soft or hard dropped.
+  constexpr int SOFT_DROP_POINTS = 1;
+  constexpr int HARD_DROP_POINTS = 2;
+
+  //
+  // Ticks spent on a line for each level, NTSC NES Tetris
+  // (https://tetris.wiki/Tetris_(NES,_Nintendo)#Gravity), level 29 being the kill screen.
+  //
+  constexpr int GRAVITY_FRAMES[] = {
+    48, 43, 38, 33, 28, 23, 18, 13, 8, 6,
+    5, 5, 5, 4, 4, 4, 3, 3, 3, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 1
+  };
+
+  constexpr int NUM_GRAVITY_LEVELS = sizeof( GRAVITY_FRAMES ) / sizeof( GRAVITY_FRAMES[ 0 ] );
+
+  // Ticks spent on a line for a given level, 0 past the end of the table where the tetromino
+  // falls as far as it can every tick (20G).
+  constexpr int gravity_frames( const int level ) {
+    return level < NUM_GRAVITY_LEVELS ? GRAVITY_FRAMES[ level ] : 0;
+  }
+
+  // Ticks spent on a line with the level's gravity and soft dropping or not, soft dropping never
+  // makes the tetromino fall slower than it already does.
+  constexpr int drop_frames( const int gravity, const bool soft_drop ) {
+    if( !soft_drop ) {
+      return gravity;
+    }
+
+    return gravity < SOFT_DROP_FRAMES ? gravity : SOFT_DROP_FRAMES;
+  }
+
+  // Points awarded for clearing 1 - 4 lines at once at a given level.
+  constexpr int line_clear_score( const int lines, const int level ) {
+    constexpr int base_scores[] = {
+      // single
+      40,
+
+      // double
+      100,
+
+      // triple
+      300,
+
+      // tetris
+      1200
+    };
+
+    if( lines < 1 || lines > 4 ) {
+      return 0;
+    }
+
+    return base_scores[ lines - 1 ] * ( level + 1 );
+  }
+
+  // The level reached after clearing a number of lines (we're using A-Type level system).
+  constexpr int level_for_lines( const int lines ) {
+    return lines / 10;
+  }
+
+}
\ No newline at end of file
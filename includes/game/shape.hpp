@@ -9,6 +9,84 @@ namespace game {
   
   const size_t NUM_TETROMINO = 7;
 
+  //
+  // Everything the board needs to know about a single tetromino mask, the masks are laid out as
+  // index = row * 4 + column (row being x, column being y) and each field is derived from that.
+  //
+  // Generated at compile time from the shape definitions below (see make_rotation) so rotating,
+  // copying and querying a tetromino never has to rescan the 16 bits of its mask.
+  //
+  struct ShapeRotation {
+    int       mask;
+
+    // Number of rows/columns spanned from index 0, i.e., the last set row/column + 1.
+    int       width;
+    int       height;
+
+    // The first set row/column.
+    int       left;
+    int       top;
+
+    // Bottom profile, the last set column for each row (0 if the row is empty).
+    int       column_height[ 4 ];
+
+    // The first/last set row for each column (-1 and 0 respectively if the column is empty).
+    int       row_start[ 4 ];
+    int       row_end[ 4 ];
+
+    // The cells of each column as a line mask (bit n being row n), shift by the tetromino's
+    // row position to line it up with the board's line masks.
+    uint32_t  lines[ 4 ];
+
+    // Returns the line mask for a column, columns outside the mask are empty.
+    constexpr uint32_t line( const int column ) const {
+      if( column < 0 || column >= 4 ) {
+        return 0;
+      }
+
+      return lines[ column ];
+    }
+  };
+
+  constexpr ShapeRotation make_rotation( const int mask ) {
+    ShapeRotation rotation{};
+    rotation.mask = mask;
+    rotation.left = 4;
+    rotation.top = 4;
+
+    for( int i{}; i < 4; ++i ) {
+      rotation.row_start[ i ] = -1;
+    }
+
+    for( int row{}; row < 4; ++row ) {
+      for( int column{}; column < 4; ++column ) {
+        const int index = row * 4 + column;
+        if( ( mask & ( 1 << index ) ) == 0 ) {
+          continue;
+        }
+
+        rotation.width = row > rotation.width ? row : rotation.width;
+        rotation.height = column > rotation.height ? column : rotation.height;
+        rotation.left = row < rotation.left ? row : rotation.left;
+        rotation.top = column < rotation.top ? column : rotation.top;
+
+        rotation.column_height[ row ] = column;
+
+        if( rotation.row_start[ column ] == -1 ) {
+          rotation.row_start[ column ] = row;
+        }
+
+        rotation.row_end[ column ] = row;
+        rotation.lines[ column ] |= 1u << row;
+      }
+    }
+
+    rotation.width += 1;
+    rotation.height += 1;
+
+    return rotation;
+  }
+
   class Tetromino {
     //
     // Designed to fit into a 4x4 grid.
@@ -18,58 +96,54 @@ namespace game {
     // Position data wont be stored in this class, this class simply defines
     // the possible orientations for a given tetromino.
     //
+    //    It's immutable once constructed, which rotation a falling tetromino is in lives in its
+    //    PieceState (see piece.hpp), so every board shares the one TETROMINO_TABLE.
+    //
 
   private:
     // The maximum number of masks that any single tetromino can have is 4, the min. is 1.
-    int     m_masks[ 4 ];
-    size_t  m_num_masks;
-
-    int     m_curr_mask;
-    int     m_prev_mask;
-
-    size_t  m_curr_idx;
-
-    int     m_width;
-    int     m_height;
-
-  private:
-    void calculate_width();
-    void calculate_height();
+    ShapeRotation m_rotations[ 4 ];
+    size_t        m_num_masks;
 
   protected:
-    void add_mask( const int mask );
+    constexpr void add_mask( const int mask ) {
+      if( m_num_masks >= 4 ) {
+        return;
+      }
 
-  public:
-    Tetromino();
-    Tetromino( const Tetromino& other );
+      m_rotations[ m_num_masks++ ] = make_rotation( mask );
+    }
 
   public:
-    const int current_mask() const;
-    const int previous_mask() const;
-    const int next_mask() const;
+    constexpr Tetromino() :
+      m_rotations{},
+      m_num_masks( 0 ) {}
 
-    void reset();
-    void rotate();
-
-    // Returns the shapes width.
-    const int width() const;
+    constexpr size_t num_rotations() const {
+      return m_num_masks;
+    }
 
-    // Returns the shapes height.
-    const int height() const;
+    constexpr const ShapeRotation& rotation( const size_t idx ) const {
+      return m_rotations[ idx ];
+    }
 
-    // Returns the row index of the first cell with a set bit given a columm.
-    int row_start( const int column );
+    // Index of the rotation after idx, wrapping back around to the first.
+    constexpr size_t next_rotation( const size_t idx ) const {
+      return idx + 1 < m_num_masks ? idx + 1 : 0;
+    }
 
-    // Returns the row index of the last cell with a set bit given a columm.
-    int row_end( const int column );
+  public:
+    // Returns the mask of a rotation.
+    const int mask( const size_t idx ) const;
 
-    // Returns the height of a column given a row index.
-    const int column_height( const int row ) const;
+    // Returns the width/height of a rotation.
+    const int width( const size_t idx ) const;
+    const int height( const size_t idx ) const;
   };
 
   class IShape : public Tetromino {
   public:
-    IShape() {
+    constexpr IShape() {
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 2 | 1 << 3 ) );
       add_mask( ( 1 << 0 | 1 << 4 | 1 << 8 | 1 << 12 ) );
     }
@@ -77,14 +151,14 @@ namespace game {
 
   class OShape : public Tetromino {
   public:
-    OShape() {
+    constexpr OShape() {
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 4 | 1 << 5 ) );
     }
   };
 
   class TShape : public Tetromino {
   public:
-    TShape() {
+    constexpr TShape() {
       add_mask( ( 1 << 0 | 1 << 4 | 1 << 5 | 1 << 8 ) );
       add_mask( ( 1 << 1 | 1 << 5 | 1 << 4 | 1 << 9 ) );
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 2 | 1 << 5 ) );
@@ -94,7 +168,7 @@ namespace game {
 
   class JShape : public Tetromino {
   public:
-    JShape() {
+    constexpr JShape() {
       add_mask( ( 1 << 4 | 1 << 5 | 1 << 6 | 1 << 2 ) );
       add_mask( ( 1 << 0 | 1 << 4 | 1 << 8 | 1 << 9 ) );
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 2 | 1 << 6 ) );
@@ -104,7 +178,7 @@ namespace game {
 
   class LShape : public Tetromino {
   public:
-    LShape() {
+    constexpr LShape() {
       add_mask( ( 1 << 4 | 1 << 5 | 1 << 6 | 1 << 0 ) );
       add_mask( ( 1 << 1 | 1 << 5 | 1 << 9 | 1 << 8 ) );
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 2 | 1 << 6 ) );
@@ -114,7 +188,7 @@ namespace game {
 
   class SShape : public Tetromino {
   public:
-    SShape() {
+    constexpr SShape() {
       add_mask( ( 1 << 1 | 1 << 4 | 1 << 5 | 1 << 8 ) );
       add_mask( ( 1 << 0 | 1 << 1 | 1 << 5 | 1 << 6 ) );
     }
@@ -122,9 +196,22 @@ namespace game {
 
   class ZShape : public Tetromino {
   public:
-    ZShape() {
+    constexpr ZShape() {
       add_mask( ( 1 << 0 | 1 << 4 | 1 << 5 | 1 << 9 ) );
       add_mask( ( 1 << 1 | 1 << 2 | 1 << 4 | 1 << 5 ) );
     }
   };
+
+  //
+  // Every tetromino, indexed by the tetromino type the piece generator deals (PieceState::type).
+  //
+  inline constexpr Tetromino TETROMINO_TABLE[ NUM_TETROMINO ] = {
+    IShape(),
+    OShape(),
+    TShape(),
+    JShape(),
+    LShape(),
+    SShape(),
+    ZShape()
+  };
 }
\ No newline at end of file
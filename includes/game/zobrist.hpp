@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include <game/bitboard.hpp>
+#include <game/shape.hpp>
+
+namespace game {
+
+  //
+  // Random keys for Zobrist hashing (https://en.wikipedia.org/wiki/Zobrist_hashing).
+  //
+  //    A board's hash is the XOR of the keys of its filled cells, so filling or emptying a cell
+  //    is a single XOR. The falling and next tetromino each get their own set of keys on top.
+  //
+  //    Generated at compile time with splitmix64 from a fixed seed so hashes are the same on
+  //    every run and every machine.
+  //
+  struct ZobristKeys {
+    uint64_t cells[ BitBoard::MAX_HEIGHT ][ BitBoard::MAX_WIDTH ];
+    uint64_t current[ NUM_TETROMINO ];
+    uint64_t next[ NUM_TETROMINO ];
+  };
+
+  constexpr ZobristKeys make_zobrist_keys( uint64_t seed ) {
+    ZobristKeys keys{};
+
+    const auto next_key = [ &seed ]() {
+      uint64_t z = ( seed += 0x9E3779B97F4A7C15ull );
+      z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+      z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+      return z ^ ( z >> 31 );
+    };
+
+    for( int y{}; y < BitBoard::MAX_HEIGHT; ++y ) {
+      for( int x{}; x < BitBoard::MAX_WIDTH; ++x ) {
+        keys.cells[ y ][ x ] = next_key();
+      }
+    }
+
+    for( size_t i{}; i < NUM_TETROMINO; ++i ) {
+      keys.current[ i ] = next_key();
+      keys.next[ i ] = next_key();
+    }
+
+    return keys;
+  }
+
+  inline constexpr ZobristKeys ZOBRIST_KEYS = make_zobrist_keys( 0x5A0B7157ull );
+
+  // Key for the cell at x, y. Boards wider than the table (see WideBoard) reuse its keys, rotated
+  // by which block of MAX_WIDTH cells x falls in.
+  constexpr uint64_t zobrist_cell( const int x, const int y ) {
+    return std::rotl( ZOBRIST_KEYS.cells[ y ][ x % BitBoard::MAX_WIDTH ], x / BitBoard::MAX_WIDTH );
+  }
+
+  // Returns the XOR of the keys of every filled cell of a line (bit n being x = n).
+  template< typename Line >
+  uint64_t zobrist_line( const int y, const Line& line ) {
+    uint64_t key = 0;
+
+    for_each_cell( line, [ & ]( const int x ) {
+      key ^= zobrist_cell( x, y );
+    } );
+
+    return key;
+  }
+
+}
\ No newline at end of file
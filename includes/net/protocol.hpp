@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace net {
+
+  //
+  // Messages between the match server and its clients (see MatchServer).
+  //
+  //    Over UDP each datagram is one message. Over TCP each message is preceded by its size as a
+  //    u16. All values are little endian, the fields each type carries are listed below.
+  //
+  enum MessageType : uint8_t {
+    // Client to server.
+    message_join = 1,       // u32 tag, u8 mode
+    message_input = 2,      // u32 game, u32 sequence, u8 player, u8 input
+    message_leave = 3,      // u32 game, u8 player
+
+    // Server to client.
+    message_welcome = 0x81, // u32 tag, u32 game, u64 seed, u8 randomizer, u8 preview size, u8 player
+    message_state = 0x82,   // u32 game, u8 player, u32 tick, u8 piece, i8 x, i8 y, u32 score, u16 lines, u8 level, u8 game over
+    message_result = 0x83,  // u32 game, u8 player, u32 tick, u32 score, u16 lines, u8 won
+    message_full = 0x84,    // u32 tag
+  };
+
+  enum MatchMode : uint8_t {
+    // One player playing until they top out.
+    mode_marathon = 0,
+
+    // Two players on the same tetromino sequence, the last one standing wins.
+    mode_versus = 1,
+  };
+
+  //
+  // Every field any message has, each type only uses its own.
+  //
+  struct Message {
+    MessageType type;
+
+    // Picked by the client so it can tell which join a welcome answers.
+    uint32_t tag;
+    uint32_t game;
+    uint8_t mode;
+
+    // Inputs are the InputState held, the highest sequence seen wins so late datagrams are ignored.
+    uint32_t sequence;
+    uint8_t input;
+
+    // The rules a client needs to play the same board (from ServerSettings), and which player it
+    // is. Inputs and leaves name the player again, both players of a match can share a socket.
+    uint64_t seed;
+    uint8_t randomizer;
+    uint8_t preview_size;
+    uint8_t player;
+
+    uint32_t tick;
+    uint8_t piece;   // type << 4 | rotation
+    int8_t x;
+    int8_t y;
+    uint32_t score;
+    uint16_t lines;
+    uint8_t level;
+    uint8_t game_over;
+    uint8_t won;
+  };
+
+  // Largest a message gets.
+  constexpr size_t MAX_MESSAGE = 32;
+
+  // Writes a message out, returns its size.
+  size_t write_message( const Message& message, uint8_t* out );
+
+  // Reads a message, returns false if it's not a whole message of a known type.
+  bool read_message( const uint8_t* data, const size_t size, Message& message );
+
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <game/board.hpp>
+#include <net/transport.hpp>
+
+namespace net {
+
+  struct SessionSettings {
+    // Both boards are dealt the same tetromino sequence.
+    uint64_t seed = 0;
+    game::RandomizerType randomizer = game::randomizer_bag;
+    int preview_size = 1;
+
+    // Furthest the session runs ahead of the last input confirmed by the other player before it
+    // stalls, which is also the deepest a rollback can go.
+    int max_rollback = 8;
+
+    // Most inputs sent in one datagram. Every input the other player hasn't acknowledged yet is
+    // sent again each tick, up to this many.
+    int max_batch = 64;
+  };
+
+  struct SessionStats {
+    // Ticks advanced, and ticks advance() refused because the other player was too far behind.
+    uint64_t ticks;
+    uint64_t stalls;
+
+    // Rollbacks done, how many ticks they went back in total and the deepest one.
+    uint64_t rollbacks;
+    uint64_t rollback_ticks;
+    uint64_t max_rollback_depth;
+
+    // Time spent restoring snapshots and stepping the boards back up to date.
+    double resimulate_seconds;
+
+    // Remote inputs that turned out different to the prediction.
+    uint64_t mispredictions;
+
+    uint64_t datagrams_sent;
+    uint64_t datagrams_received;
+    uint64_t bytes_sent;
+
+    // Ticks both players simulated with the same inputs but ended up on different boards.
+    uint64_t desyncs;
+  };
+
+  //
+  // Two player versus without waiting on the network.
+  //
+  //    Each tick advances both boards straight away with the local input and a prediction of the
+  //    remote one (whatever the remote player was last known to be holding, keys are usually held
+  //    for several ticks). The boards are copied into a ring of snapshots before every tick, a
+  //    board is a few hundred flat bytes so that's cheap.
+  //
+  //    When the real remote input for a tick arrives and differs from the prediction, the boards
+  //    are put back to the snapshot from before that tick and stepped forward again to the
+  //    current tick with the inputs now known. The session never gets more than max_rollback
+  //    ticks ahead of the remote inputs it has, it stalls instead.
+  //
+  //    Every tick a datagram goes out with every local input the other side hasn't acknowledged
+  //    (so a lost datagram is covered by the next one), an acknowledgement of the remote inputs
+  //    received, and a checksum of the latest tick both inputs are confirmed for, which the
+  //    other side compares against its own to spot desyncs.
+  //
+  //    Datagram layout, all values little endian:
+  //
+  //      u16  MAGIC
+  //      u32  remote inputs received (the next tick the sender needs)
+  //      u32  tick of the first input in the datagram
+  //      u8   number of inputs
+  //      u32  tick the checksum is for, NO_CHECKSUM if none
+  //      u64  checksum
+  //      u8   input for each tick
+  //
+  class RollbackSession {
+  public:
+    static constexpr uint16_t MAGIC = 0x5254; // "TR"
+    static constexpr uint32_t NO_CHECKSUM = 0xFFFFFFFF;
+    static constexpr size_t HEADER_SIZE = 23;
+
+  private:
+    struct Snapshot {
+      game::Board boards[ 2 ];
+    };
+
+    Transport& m_transport;
+    SessionSettings m_settings;
+    int m_local;
+
+    game::Board m_boards[ 2 ];
+    uint64_t m_tick;
+
+    // What the local board's last tick did, it's never rolled back.
+    game::StepResult m_local_result;
+
+    // Confirmed inputs of each player, by tick.
+    std::vector< uint8_t > m_inputs[ 2 ];
+
+    // The remote input each simulated tick was stepped with, confirmed or predicted.
+    std::vector< uint8_t > m_remote_used;
+
+    // Boards before tick t are in m_snapshots[ t % size ].
+    std::vector< Snapshot > m_snapshots;
+
+    // Local inputs the other player has acknowledged.
+    uint64_t m_acked;
+
+    // Earliest tick found mispredicted since the last rollback.
+    uint64_t m_rollback_from;
+
+    // Checksum after each tick both inputs are confirmed for, and the next tick whose checksum
+    // from the other player hasn't been compared yet.
+    std::vector< uint64_t > m_checksums;
+    uint64_t m_compared;
+
+    SessionStats m_stats;
+
+  private:
+    const int remote() const {
+      return 1 - m_local;
+    }
+
+    // The remote input to step tick with.
+    uint8_t remote_input( const uint64_t tick ) const;
+
+    // Steps both boards through one tick, snapshotting them first.
+    void simulate( const uint64_t tick );
+
+    void receive( const uint8_t* data, const size_t size );
+    void rollback();
+    void send_inputs();
+
+    // Records checksums for every tick that's become confirmed.
+    void confirm_checksums();
+
+  public:
+    // local_player is 0 or 1, the two sessions of a match each take one.
+    RollbackSession( Transport& transport, const int local_player, const SessionSettings& settings = {} );
+
+    // Reads every datagram that's arrived and rolls back if any prediction was wrong. Call
+    // before advance each tick.
+    void poll();
+
+    //
+    // Advances both boards one tick with the local player's input. Returns false (and doesn't
+    // advance) when the session is max_rollback ticks ahead of the remote inputs it has, the
+    // caller tries again next tick with the same input.
+    //
+    bool advance( const uint8_t input );
+
+    // Sends the inputs the other player hasn't acknowledged again without advancing, for when
+    // the match has stopped advancing (paused or over) but the other side is still catching up.
+    void resend() {
+      send_inputs();
+    }
+
+    const game::Board& board( const int player ) const {
+      return m_boards[ player ];
+    }
+
+    const game::StepResult& local_result() const {
+      return m_local_result;
+    }
+
+    const int local_player() const {
+      return m_local;
+    }
+
+    // Ticks simulated.
+    const uint64_t tick() const {
+      return m_tick;
+    }
+
+    // Ticks simulated with both players' real inputs, these never get rolled back.
+    const uint64_t confirmed_ticks() const {
+      return m_checksums.size();
+    }
+
+    // Checksum of both boards after a confirmed tick.
+    const uint64_t checksum( const uint64_t tick ) const {
+      return m_checksums[ tick ];
+    }
+
+    // How checksums are made, from player 0 and player 1's boards.
+    static uint64_t make_checksum( const game::Board boards[ 2 ] );
+
+    // Inputs confirmed for a player so far, for replays and checking.
+    const std::vector< uint8_t >& inputs( const int player ) const {
+      return m_inputs[ player ];
+    }
+
+    const SessionStats& stats() const {
+      return m_stats;
+    }
+  };
+
+}
\ No newline at end of file
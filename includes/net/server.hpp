@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <game/random.hpp>
+#include <net/protocol.hpp>
+
+namespace net {
+
+  struct ServerSettings {
+    // UDP and TCP both listen on this port.
+    uint16_t port = 47100;
+
+    // 0 runs a shard on every hardware thread, at most 256.
+    int shards = 0;
+
+    // Pins shard n to core n.
+    bool pin_shards = true;
+
+    // Rules of every game hosted, sent to the players in the welcome.
+    game::RandomizerType randomizer = game::randomizer_bag;
+    int preview_size = 1;
+
+    // Ticks between the state messages sent for each game, 6 is 10 a second.
+    int state_interval = 6;
+
+    // Games each shard can hold, at most 65536.
+    int max_games = 32768;
+
+    // Seconds without hearing from a player before they're taken to have left.
+    double timeout = 10.0;
+
+    // Most ticks a shard runs back to back to catch up after falling behind, the rest are
+    // dropped (and counted).
+    int max_catch_up = 4;
+  };
+
+  struct ShardStats {
+    uint64_t games;
+    uint64_t players;
+
+    // Shard ticks run, games stepped over all of them and shard ticks dropped for falling behind.
+    uint64_t ticks;
+    uint64_t game_ticks;
+    uint64_t dropped_ticks;
+
+    // Time spent stepping games, and time spent doing anything (networking included).
+    double tick_seconds;
+    double busy_seconds;
+
+    uint64_t games_started;
+    uint64_t games_finished;
+    uint64_t connections;
+
+    uint64_t messages_received;
+    uint64_t messages_sent;
+  };
+
+  //
+  // Hosts marathon and versus games for clients on the network, headless, Linux only.
+  //
+  //    Games are spread over shards, one thread each, pinned to its own core, sharing nothing.
+  //    Each shard has its own UDP socket and TCP listener on the same port (SO_REUSEPORT), so
+  //    the kernel spreads clients over the shards by address, and a game lives on the shard its
+  //    players' messages arrive at. A shard waits on one epoll set for datagrams, connections and
+  //    a 60 Hz timerfd.
+  //
+  //    On every timer tick the shard steps all of its running games in one pass over a compact
+  //    list, each board with the input its player last sent (the server is authoritative, late
+  //    input just takes effect a tick later), then sends every message the tick produced in one
+  //    sendmmsg. Each game's state goes out every state_interval ticks, staggered by game so the
+  //    sends are spread evenly over the ticks.
+  //
+  //    Datagrams and TCP messages are handled the same way (see protocol.hpp), the game just
+  //    remembers which way to answer each player.
+  //
+  class MatchServer {
+  private:
+    struct Shard;
+
+    ServerSettings m_settings;
+    std::vector< std::unique_ptr< Shard > > m_shards;
+    std::vector< std::thread > m_threads;
+    std::atomic< bool > m_running;
+
+  public:
+    MatchServer( const ServerSettings& settings = {} );
+    ~MatchServer();
+
+    // Opens every shard's sockets and starts their threads, returns false if the sockets
+    // couldn't be opened.
+    bool start();
+
+    // Stops the shards and waits for their threads.
+    void stop();
+
+    const int shards() const {
+      return ( int ) m_shards.size();
+    }
+
+    // A copy of a shard's counters, safe to call while it runs.
+    ShardStats stats( const int shard ) const;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <game/random.hpp>
+
+namespace net {
+
+  // Largest datagram any transport carries.
+  constexpr size_t MAX_DATAGRAM = 1200;
+
+  //
+  // Carries datagrams between two peers.
+  //
+  //    Like UDP, a datagram sent may arrive late, out of order or not at all, and nothing blocks:
+  //    receive returns straight away whether or not anything has arrived.
+  //
+  class Transport {
+  public:
+    virtual ~Transport() = default;
+
+    // Sends a datagram of at most MAX_DATAGRAM bytes.
+    virtual void send( const uint8_t* data, const size_t size ) = 0;
+
+    // Copies the next datagram that's arrived into buffer, returns its size or 0 if there isn't one.
+    virtual size_t receive( uint8_t* buffer, const size_t capacity ) = 0;
+  };
+
+  //
+  // One end of an in-process link, datagrams sent on one end are received on the other as soon
+  // as they're sent.
+  //
+  class LocalTransport : public Transport {
+  private:
+    LocalTransport* m_peer;
+    std::deque< std::vector< uint8_t > > m_inbox;
+
+  public:
+    LocalTransport();
+
+    // Joins two ends together.
+    static void connect( LocalTransport& a, LocalTransport& b );
+
+    void send( const uint8_t* data, const size_t size ) override;
+    size_t receive( uint8_t* buffer, const size_t capacity ) override;
+  };
+
+  //
+  // A UDP socket sending to one address, for POSIX systems.
+  //
+  class UdpTransport : public Transport {
+  private:
+    int m_socket;
+    uint32_t m_remote_address;
+    uint16_t m_remote_port;
+
+  public:
+    // Binds local_port on every interface and sends to remote_host (a dotted IPv4 address) on
+    // remote_port. is_open() is false if the socket couldn't be set up.
+    UdpTransport( const uint16_t local_port, const char* remote_host, const uint16_t remote_port );
+    ~UdpTransport();
+
+    UdpTransport( const UdpTransport& ) = delete;
+    UdpTransport& operator=( const UdpTransport& ) = delete;
+
+    const bool is_open() const {
+      return m_socket >= 0;
+    }
+
+    void send( const uint8_t* data, const size_t size ) override;
+
+    // Datagrams from any address other than the remote one are dropped.
+    size_t receive( uint8_t* buffer, const size_t capacity ) override;
+  };
+
+  struct LinkConditions {
+    // One way delay in seconds, and how far either side of it a datagram's delay can land.
+    double latency = 0.0;
+    double jitter = 0.0;
+
+    // Chance of a datagram being dropped, 0 to 1.
+    double loss = 0.0;
+  };
+
+  //
+  // Wraps another transport and makes its link worse, for testing on links that are too good.
+  //
+  //    Each datagram sent is dropped with the chance given, or held back for latency plus or
+  //    minus jitter seconds before it's passed on, so with jitter they can arrive out of order.
+  //    Time only moves when set_time is called, so the same seed and times always give the same
+  //    link, whether the times come from a clock or a simulation.
+  //
+  class ConditionedTransport : public Transport {
+  private:
+    struct Pending {
+      double release;
+      std::vector< uint8_t > data;
+    };
+
+    Transport& m_inner;
+    LinkConditions m_conditions;
+    game::Random m_random;
+
+    double m_time;
+    std::vector< Pending > m_pending;
+
+    uint64_t m_sent;
+    uint64_t m_dropped;
+
+  private:
+    // Passes on every held back datagram that's due.
+    void release();
+
+  public:
+    ConditionedTransport( Transport& inner, const LinkConditions& conditions, const uint64_t seed = 0 );
+
+    void set_time( const double time );
+
+    void send( const uint8_t* data, const size_t size ) override;
+    size_t receive( uint8_t* buffer, const size_t capacity ) override;
+
+    const uint64_t sent() const {
+      return m_sent;
+    }
+
+    const uint64_t dropped() const {
+      return m_dropped;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <game/board.hpp>
+#include <game/random.hpp>
+
+namespace sim {
+
+  //
+  // Picks the input for the next tick of a game.
+  //
+  //    board: the board about to be stepped
+  //    previous: the input used for the last tick
+  //    random: random stream owned by the game being played
+  //
+  //    Called concurrently from every worker, so it must not share mutable state between calls.
+  //
+  using InputPolicy = std::function< uint8_t( const game::Board& board, const uint8_t previous, game::Random& random ) >;
+
+  // Mashes random keys, holding each combination for 8 ticks on average.
+  uint8_t random_input( const game::Board& board, const uint8_t previous, game::Random& random );
+
+  struct FarmSettings {
+    // Games are played for seeds [first_seed, first_seed + num_games).
+    uint64_t first_seed = 0;
+    uint64_t num_games = 1000;
+
+    // Games still running after this many ticks are cut short.
+    uint64_t max_ticks = 1ull << 20;
+
+    // 0 uses every hardware thread.
+    int num_threads = 0;
+
+    game::RandomizerType randomizer = game::randomizer_uniform;
+
+    // Seed ranges are split in half until they're this small, the halves left behind are
+    // what idle workers steal.
+    uint64_t grain = 8;
+  };
+
+  struct GameResult {
+    uint64_t seed;
+    uint64_t ticks;
+    int score;
+    int lines;
+    int level;
+  };
+
+  struct WorkerReport {
+    uint64_t games;
+    uint64_t ticks;
+    uint64_t steals;
+  };
+
+  struct FarmReport {
+    // Every game played, in seed order regardless of which worker played it.
+    std::vector< GameResult > games;
+    std::vector< WorkerReport > workers;
+
+    uint64_t total_ticks;
+    uint64_t total_score;
+    uint64_t total_lines;
+
+    int max_score;
+    uint64_t max_score_seed;
+
+    // Hash over every game result in seed order, identical for any number of threads.
+    uint64_t digest;
+
+    double seconds;
+  };
+
+  //
+  // Plays a range of seeded games headlessly across a work-stealing thread pool.
+  //
+  //    Every game is a pure function of its seed: the board is reset with it and the input
+  //    policy gets its own random stream derived from it. Each worker owns its board and
+  //    streams, so the results (and the report built from them) don't depend on how many
+  //    threads ran them or which worker picked up which seeds.
+  //
+  class GameFarm {
+  private:
+    FarmSettings m_settings;
+    InputPolicy m_policy;
+
+  private:
+    GameResult play( game::Board& board, const uint64_t seed ) const;
+
+  public:
+    GameFarm( const FarmSettings& settings, InputPolicy policy = random_input );
+
+    FarmReport run() const;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include <game/board.hpp>
+
+namespace sim {
+
+  struct PerftResult {
+    // Placements made across the whole tree (every node besides the root).
+    uint64_t nodes;
+
+    // Sequences of placements that reach the full depth without topping out.
+    uint64_t leaves;
+
+    // Different boards (by locked cells) among the leaves.
+    uint64_t distinct;
+
+    double seconds;
+  };
+
+  //
+  // Move generation counter in the spirit of chess "perft".
+  //
+  //    Starting from board, every placement find_placements reports for the falling tetromino is
+  //    made, then every placement of the next tetromino and so on for depth tetromino. The tetromino
+  //    sequence comes from the board's own generator so it's the same down every branch, branches
+  //    that top out early stop there.
+  //
+  //    With num_threads > 1 the subtrees below the first two placements are shared out between
+  //    threads, the counts are the same for any number of threads.
+  //
+  //    Distinct boards are told apart by their Zobrist hash (Board::board_hash).
+  //
+  PerftResult perft( const game::Board& board, const int depth, const int num_threads = 1 );
+
+}
\ No newline at end of file
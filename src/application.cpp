@@ -11,6 +11,7 @@ app::Application::Application() {
   m_running = false;
   m_physics_interval = 1.0 / 60.0;
   m_physics_time = 0.0;
+  m_physics_ticks = 0;
   m_delta_time = 0.0;
   m_frame_count = 0;
   m_frame_measure = 0.0;
@@ -58,7 +59,7 @@ void app::Application::exec( render_routine_t render_routine, physics_routine_t
       while( accumulator >= m_physics_interval ) {
         physics_routine( *this, m_physics_time, m_physics_interval );
 
-        m_physics_time += m_physics_interval;
+        m_physics_time = ++m_physics_ticks * m_physics_interval;
         accumulator -= m_physics_interval;
       }
 
@@ -0,0 +1,328 @@
+#include <bot/autoplayer.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+
+bot::Autoplayer::Autoplayer( const SearchSettings& settings ) :
+  m_settings( settings ),
+  m_table( nullptr ),
+  m_planned( false ),
+  m_target{},
+  m_action( 0 ),
+  m_last_input( game::input_none ),
+  m_searches( 0 ),
+  m_replans( 0 ),
+  m_search_time( 0.0 ) {}
+
+void bot::Autoplayer::reset() {
+  m_planned = false;
+  m_actions.clear();
+  m_action = 0;
+  m_last_input = game::input_none;
+}
+
+bool bot::Autoplayer::search( const game::Board& board, game::Placement& best ) {
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto elapsed = [ & ]() {
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  };
+
+  ++m_searches;
+
+  board.find_placements( m_root_placements );
+  if( m_root_placements.empty() ) {
+    m_search_time += elapsed();
+    return false;
+  }
+
+  // Only search as far ahead as a player could see.
+  const int depth = std::clamp( m_settings.depth, 1, 1 + board.preview_size() );
+  const size_t beam_width = ( size_t ) std::max( 1, m_settings.beam_width );
+
+  m_beam.resize( 1, board );
+  m_beam[ 0 ] = board;
+  m_beam_lines.assign( 1, 0 );
+  m_beam_root.assign( 1, -1 );
+
+  int best_root = 0;
+
+  for( int level{}; level < depth; ++level ) {
+    m_candidates.clear();
+    m_pending.clear();
+    m_batch_lines.clear();
+
+    if( m_placements.size() < m_beam.size() ) {
+      m_placements.resize( m_beam.size() );
+    }
+
+    //
+    // Score every placement on every board in the beam.
+    //
+    bool out_of_time = false;
+
+    for( size_t parent{}; parent < m_beam.size() && !out_of_time; ++parent ) {
+      if( level > 0 ) {
+        m_beam[ parent ].find_placements( m_placements[ parent ] );
+      }
+
+      const game::PlacementList& placements = level == 0 ? m_root_placements : m_placements[ parent ];
+
+      for( size_t i{}; i < placements.size(); ++i ) {
+        m_scratch = m_beam[ parent ];
+
+        const game::StepResult result = m_scratch.place( placements[ i ] );
+        const int lines = m_beam_lines[ parent ] + std::popcount( result.cleared_lines );
+
+        if( m_scratch.is_game_over() ) {
+          m_candidates.push_back( { -std::numeric_limits< double >::infinity(), 0, ( int ) parent, ( int ) i } );
+          continue;
+        }
+
+        // Board scores are kept as floats, the precision the table stores, so using the table doesn't change any decisions.
+        TranspositionEntry entry;
+
+        if( m_table && m_table->probe( m_scratch.board_hash(), entry, m_table_stats ) ) {
+          m_candidates.push_back( { entry.score + m_settings.weights.lines * lines, m_scratch.hash(), ( int ) parent, ( int ) i } );
+          continue;
+        }
+
+        // Scored below along with the rest of the level.
+        m_pending.push_back( { m_candidates.size(), m_scratch.board_hash(), lines } );
+        m_candidates.push_back( { 0.0, m_scratch.hash(), ( int ) parent, ( int ) i } );
+
+        for( int y{}; y < m_scratch.columns(); ++y ) {
+          m_batch_lines.push_back( m_scratch.line( y ) );
+        }
+      }
+
+      // Deeper levels only refine the choice, give up on them once the budget has run out.
+      out_of_time = level > 0 && m_settings.time_budget > 0.0 && elapsed() > m_settings.time_budget;
+    }
+
+    //
+    // Extract the features of every board that wasn't in the table in one go.
+    //
+    m_batch_features.resize( m_pending.size() );
+    extract_features_batch( m_batch_lines.data(), board.rows(), board.columns(), m_pending.size(), m_batch_features.data() );
+
+    for( size_t i{}; i < m_pending.size(); ++i ) {
+      const Pending& pending = m_pending[ i ];
+      const float board_score = ( float ) evaluate( m_batch_features[ i ], 0, m_settings.weights );
+
+      if( m_table ) {
+        m_table->store( pending.board_hash, { board_score, 0, 0 }, m_table_stats );
+      }
+
+      m_candidates[ pending.candidate ].score = board_score + m_settings.weights.lines * pending.lines;
+    }
+
+    if( m_candidates.empty() ) {
+      break;
+    }
+
+    //
+    // Keep the best boards, ties go to the earliest placement so a search always picks the same one.
+    //
+    const size_t keep = std::min( beam_width, m_candidates.size() );
+
+    std::partial_sort( m_candidates.begin(), m_candidates.begin() + keep, m_candidates.end(), []( const Candidate& a, const Candidate& b ) {
+      if( a.score != b.score ) {
+        return a.score > b.score;
+      }
+
+      if( a.parent != b.parent ) {
+        return a.parent < b.parent;
+      }
+
+      return a.placement < b.placement;
+    } );
+
+    best_root = level == 0 ? m_candidates[ 0 ].placement : m_beam_root[ m_candidates[ 0 ].parent ];
+
+    if( out_of_time || level + 1 == depth ) {
+      break;
+    }
+
+    //
+    // Make the kept placements for real, they're the boards the next tetromino is searched on.
+    //
+    m_next_beam.resize( keep, board );
+    m_next_lines.clear();
+    m_next_root.clear();
+
+    size_t kept = 0;
+
+    for( size_t i{}; i < keep; ++i ) {
+      const Candidate& candidate = m_candidates[ i ];
+      if( candidate.score == -std::numeric_limits< double >::infinity() ) {
+        break;
+      }
+
+      // The same board and tetromino reached in a different order, the better scoring one is already kept.
+      bool duplicate = false;
+      for( size_t j{}; j < i && !duplicate; ++j ) {
+        duplicate = m_candidates[ j ].hash == candidate.hash;
+      }
+
+      if( duplicate ) {
+        continue;
+      }
+
+      const game::PlacementList& placements = level == 0 ? m_root_placements : m_placements[ candidate.parent ];
+
+      game::Board& child = m_next_beam[ kept++ ];
+      child = m_beam[ candidate.parent ];
+
+      const game::StepResult result = child.place( placements[ candidate.placement ] );
+
+      m_next_lines.push_back( m_beam_lines[ candidate.parent ] + std::popcount( result.cleared_lines ) );
+      m_next_root.push_back( level == 0 ? candidate.placement : m_beam_root[ candidate.parent ] );
+    }
+
+    // Everything tops out, there's nothing left to look ahead on.
+    if( kept == 0 ) {
+      break;
+    }
+
+    m_next_beam.resize( kept, board );
+
+    std::swap( m_beam, m_next_beam );
+    std::swap( m_beam_lines, m_next_lines );
+    std::swap( m_beam_root, m_next_root );
+  }
+
+  best = m_root_placements[ best_root ];
+
+  m_search_time += elapsed();
+  return true;
+}
+
+void bot::Autoplayer::follow( const game::Board& board, const game::PlacementList& placements, const game::Placement& placement ) {
+  m_planned = true;
+  m_target = placement;
+  m_actions.clear();
+  m_action = 0;
+
+  const int num_rotations = ( int ) game::TETROMINO_TABLE[ board.tetromino() ].num_rotations();
+
+  int rotation = board.rotation();
+  int x = board.position_x();
+  int y = board.position_y();
+
+  const uint8_t* path = placements.path( placement );
+
+  for( uint32_t i{}; i < placement.path_length; ++i ) {
+    const int line = y;
+
+    switch( path[ i ] ) {
+      case game::move_down:
+        ++y;
+        continue;
+
+      case game::move_left:
+        --x;
+        break;
+
+      case game::move_right:
+        ++x;
+        break;
+
+      case game::move_rotate:
+        rotation = ( rotation + 1 ) % num_rotations;
+        break;
+    }
+
+    m_actions.push_back( { path[ i ], line, rotation, x } );
+  }
+}
+
+void bot::Autoplayer::plan( const game::Board& board ) {
+  if( m_planned ) {
+    // Look for another way into the same cells from where the tetromino is now.
+    board.find_placements( m_root_placements );
+
+    for( const game::Placement& placement : m_root_placements ) {
+      if( placement.top == m_target.top &&
+        std::equal( placement.lines, placement.lines + 4, m_target.lines ) ) {
+        follow( board, m_root_placements, placement );
+        return;
+      }
+    }
+
+    m_planned = false;
+  }
+
+  game::Placement best;
+  if( search( board, best ) ) {
+    follow( board, m_root_placements, best );
+  }
+}
+
+uint8_t bot::Autoplayer::input( const game::Board& board ) {
+  if( board.is_game_over() ) {
+    m_last_input = game::input_none;
+    return m_last_input;
+  }
+
+  if( !m_planned ) {
+    plan( board );
+  }
+
+  const int rotation = board.rotation();
+  const int x = board.position_x();
+  const int y = board.position_y();
+
+  // Skip the moves that have happened.
+  while( m_action < m_actions.size() && m_actions[ m_action ].rotation == rotation && m_actions[ m_action ].x == x ) {
+    ++m_action;
+  }
+
+  // Gravity pulled the tetromino past the line the next move had to happen on.
+  if( m_action < m_actions.size() && y > m_actions[ m_action ].y ) {
+    ++m_replans;
+    plan( board );
+
+    while( m_action < m_actions.size() && m_actions[ m_action ].rotation == rotation && m_actions[ m_action ].x == x ) {
+      ++m_action;
+    }
+  }
+
+  uint8_t input = game::input_soft_drop;
+
+  if( !m_planned ) {
+    input = game::input_none;
+  }
+  else if( m_action == m_actions.size() ) {
+    // Every move has happened, drop the rest of the way (letting go first if it's still held).
+    input = ( m_last_input & game::input_hard_drop ) ? game::input_none : game::input_hard_drop;
+  }
+  else if( m_action < m_actions.size() && y == m_actions[ m_action ].y ) {
+    switch( m_actions[ m_action ].move ) {
+      case game::move_left:
+        // Tap rather than hold, letting go resets the auto shift delay so the next press moves straight away.
+        input = ( m_last_input & game::input_left ) ? game::input_none : game::input_left;
+        break;
+
+      case game::move_right:
+        input = ( m_last_input & game::input_right ) ? game::input_none : game::input_right;
+        break;
+
+      case game::move_rotate:
+        input = game::input_rotate;
+        break;
+    }
+  }
+
+  m_last_input = input;
+  return input;
+}
+
+void bot::Autoplayer::observe( const game::StepResult& result ) {
+  // A new tetromino needs a new plan.
+  if( result.events & ( game::event_spawned | game::event_game_over ) ) {
+    m_planned = false;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include <bot/features.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+#if defined( __AVX2__ )
+#define FEATURES_AVX2
+#endif
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define FEATURES_SSE2
+#endif
+
+#if defined( FEATURES_AVX2 ) || defined( FEATURES_SSE2 )
+#include <immintrin.h>
+#endif
+
+// Fills in the features that only depend on the column heights.
+static void summarize_columns( const int* heights, const int width, const int height, bot::Features& features ) {
+  for( int x{}; x < width; ++x ) {
+    features.column_heights[ x ] = ( uint8_t ) heights[ x ];
+    features.aggregate_height += heights[ x ];
+
+    if( x + 1 < width ) {
+      features.bumpiness += std::abs( heights[ x ] - heights[ x + 1 ] );
+    }
+
+    const int left = x > 0 ? heights[ x - 1 ] : height;
+    const int right = x + 1 < width ? heights[ x + 1 ] : height;
+
+    features.wells += std::max( 0, std::min( left, right ) - heights[ x ] );
+  }
+}
+
+bot::Features bot::extract_features( const uint32_t* lines, const int width, const int height ) {
+  Features features{};
+
+  int heights[ game::BitBoard::MAX_WIDTH ] = {};
+
+  const uint32_t full = ( 1u << width ) - 1;
+
+  // Lines are padded with a filled cell either side for counting row transitions.
+  const uint32_t walls = 1u | ( 1u << ( width + 1 ) );
+  const uint32_t transitions = ( 1u << ( width + 1 ) ) - 1;
+
+  //
+  // Walk down from the top, seen collects every column that's had a filled cell so far, so any
+  // empty cell in those columns is a hole and the first cell seen in a column sets its height.
+  //
+  uint32_t seen = 0;
+
+  for( int y{}; y < height; ++y ) {
+    const uint32_t line = lines[ y ];
+    const uint32_t below = y + 1 < height ? lines[ y + 1 ] : full;
+
+    features.holes += std::popcount( seen & ~line );
+
+    for( uint32_t first = line & ~seen; first != 0; first &= first - 1 ) {
+      heights[ std::countr_zero( first ) ] = height - y;
+    }
+
+    seen |= line;
+
+    if( seen != 0 ) {
+      const uint32_t padded = ( line << 1 ) | walls;
+      features.row_transitions += std::popcount( ( padded ^ ( padded >> 1 ) ) & transitions );
+    }
+
+    features.column_transitions += std::popcount( line ^ below );
+  }
+
+  summarize_columns( heights, width, height, features );
+
+  return features;
+}
+
+bot::Features bot::extract_features( const game::Board& board ) {
+  uint32_t lines[ game::BitBoard::MAX_HEIGHT ];
+
+  for( int y{}; y < board.columns(); ++y ) {
+    lines[ y ] = board.line( y );
+  }
+
+  return extract_features( lines, board.rows(), board.columns() );
+}
+
+//
+// Vector operations on one 32 bit lane per board, the kernel below is written once against
+// these and instantiated for each instruction set.
+//
+#if defined( FEATURES_AVX2 )
+struct Avx2 {
+  using V = __m256i;
+  static constexpr int LANES = 8;
+
+  static V zero() { return _mm256_setzero_si256(); }
+  static V set1( const uint32_t value ) { return _mm256_set1_epi32( ( int ) value ); }
+
+  static V load( const uint32_t* const* boards, const int y ) {
+    return _mm256_setr_epi32(
+      ( int ) boards[ 0 ][ y ], ( int ) boards[ 1 ][ y ], ( int ) boards[ 2 ][ y ], ( int ) boards[ 3 ][ y ],
+      ( int ) boards[ 4 ][ y ], ( int ) boards[ 5 ][ y ], ( int ) boards[ 6 ][ y ], ( int ) boards[ 7 ][ y ] );
+  }
+
+  static void store( int32_t* out, const V v ) { _mm256_storeu_si256( ( V* ) out, v ); }
+
+  static V and_( const V a, const V b ) { return _mm256_and_si256( a, b ); }
+  static V or_( const V a, const V b ) { return _mm256_or_si256( a, b ); }
+  static V xor_( const V a, const V b ) { return _mm256_xor_si256( a, b ); }
+  static V andnot( const V a, const V b ) { return _mm256_andnot_si256( a, b ); }
+  static V add( const V a, const V b ) { return _mm256_add_epi32( a, b ); }
+  static V sub( const V a, const V b ) { return _mm256_sub_epi32( a, b ); }
+  static V sll( const V v, const int n ) { return _mm256_sll_epi32( v, _mm_cvtsi32_si128( n ) ); }
+  static V srl( const V v, const int n ) { return _mm256_srl_epi32( v, _mm_cvtsi32_si128( n ) ); }
+  static V cmpeq( const V a, const V b ) { return _mm256_cmpeq_epi32( a, b ); }
+  static V min( const V a, const V b ) { return _mm256_min_epi32( a, b ); }
+  static V max( const V a, const V b ) { return _mm256_max_epi32( a, b ); }
+  static V abs( const V v ) { return _mm256_abs_epi32( v ); }
+};
+#endif
+
+#if defined( FEATURES_SSE2 )
+struct Sse2 {
+  using V = __m128i;
+  static constexpr int LANES = 4;
+
+  static V zero() { return _mm_setzero_si128(); }
+  static V set1( const uint32_t value ) { return _mm_set1_epi32( ( int ) value ); }
+
+  static V load( const uint32_t* const* boards, const int y ) {
+    return _mm_setr_epi32( ( int ) boards[ 0 ][ y ], ( int ) boards[ 1 ][ y ], ( int ) boards[ 2 ][ y ], ( int ) boards[ 3 ][ y ] );
+  }
+
+  static void store( int32_t* out, const V v ) { _mm_storeu_si128( ( V* ) out, v ); }
+
+  static V and_( const V a, const V b ) { return _mm_and_si128( a, b ); }
+  static V or_( const V a, const V b ) { return _mm_or_si128( a, b ); }
+  static V xor_( const V a, const V b ) { return _mm_xor_si128( a, b ); }
+  static V andnot( const V a, const V b ) { return _mm_andnot_si128( a, b ); }
+  static V add( const V a, const V b ) { return _mm_add_epi32( a, b ); }
+  static V sub( const V a, const V b ) { return _mm_sub_epi32( a, b ); }
+  static V sll( const V v, const int n ) { return _mm_sll_epi32( v, _mm_cvtsi32_si128( n ) ); }
+  static V srl( const V v, const int n ) { return _mm_srl_epi32( v, _mm_cvtsi32_si128( n ) ); }
+  static V cmpeq( const V a, const V b ) { return _mm_cmpeq_epi32( a, b ); }
+
+  // SSE2 has no 32 bit min/max/abs, pick with a compare mask instead.
+  static V min( const V a, const V b ) {
+    const V greater = _mm_cmpgt_epi32( a, b );
+    return _mm_or_si128( _mm_and_si128( greater, b ), _mm_andnot_si128( greater, a ) );
+  }
+
+  static V max( const V a, const V b ) {
+    const V greater = _mm_cmpgt_epi32( a, b );
+    return _mm_or_si128( _mm_and_si128( greater, a ), _mm_andnot_si128( greater, b ) );
+  }
+
+  static V abs( const V v ) {
+    const V sign = _mm_srai_epi32( v, 31 );
+    return _mm_sub_epi32( _mm_xor_si128( v, sign ), sign );
+  }
+};
+#endif
+
+#if defined( FEATURES_AVX2 ) || defined( FEATURES_SSE2 )
+
+// Counts the set bits of each lane.
+template< typename Ops >
+static typename Ops::V popcount( typename Ops::V v ) {
+  v = Ops::sub( v, Ops::and_( Ops::srl( v, 1 ), Ops::set1( 0x55555555 ) ) );
+  v = Ops::add( Ops::and_( v, Ops::set1( 0x33333333 ) ), Ops::and_( Ops::srl( v, 2 ), Ops::set1( 0x33333333 ) ) );
+  v = Ops::and_( Ops::add( v, Ops::srl( v, 4 ) ), Ops::set1( 0x0F0F0F0F ) );
+  v = Ops::add( v, Ops::srl( v, 8 ) );
+  v = Ops::add( v, Ops::srl( v, 16 ) );
+
+  return Ops::and_( v, Ops::set1( 0x3F ) );
+}
+
+//
+// The same walk as the scalar extract_features for Ops::LANES boards at once.
+//
+//    Column heights are built up differently, rather than looking for the first filled cell of
+//    each column, every line adds 1 to the height of the columns seen so far (which works out
+//    to the same height - y of the first filled cell).
+//
+template< typename Ops >
+static void extract_block( const uint32_t* const* boards, const size_t count, const int width, const int height, bot::Features* features ) {
+  using V = typename Ops::V;
+
+  const V zero = Ops::zero();
+  const V one = Ops::set1( 1 );
+  const V full = Ops::set1( ( 1u << width ) - 1 );
+  const V walls = Ops::set1( 1u | ( 1u << ( width + 1 ) ) );
+  const V transitions = Ops::set1( ( 1u << ( width + 1 ) ) - 1 );
+
+  V seen = zero;
+  V holes = zero;
+  V row_transitions = zero;
+  V column_transitions = zero;
+
+  V heights[ game::BitBoard::MAX_WIDTH ];
+  for( int x{}; x < width; ++x ) {
+    heights[ x ] = zero;
+  }
+
+  V line = Ops::load( boards, 0 );
+
+  for( int y{}; y < height; ++y ) {
+    const V below = y + 1 < height ? Ops::load( boards, y + 1 ) : full;
+
+    holes = Ops::add( holes, popcount< Ops >( Ops::andnot( line, seen ) ) );
+    seen = Ops::or_( seen, line );
+
+    // Lines above the highest filled cell don't count towards the row transitions.
+    const V padded = Ops::or_( Ops::sll( line, 1 ), walls );
+    const V changes = popcount< Ops >( Ops::and_( Ops::xor_( padded, Ops::srl( padded, 1 ) ), transitions ) );
+    row_transitions = Ops::add( row_transitions, Ops::andnot( Ops::cmpeq( seen, zero ), changes ) );
+
+    column_transitions = Ops::add( column_transitions, popcount< Ops >( Ops::xor_( line, below ) ) );
+
+    for( int x{}; x < width; ++x ) {
+      heights[ x ] = Ops::add( heights[ x ], Ops::and_( Ops::srl( seen, x ), one ) );
+    }
+
+    line = below;
+  }
+
+  //
+  // Column features.
+  //
+  const V wall = Ops::set1( ( uint32_t ) height );
+
+  V aggregate_height = zero;
+  V bumpiness = zero;
+  V wells = zero;
+
+  for( int x{}; x < width; ++x ) {
+    aggregate_height = Ops::add( aggregate_height, heights[ x ] );
+
+    if( x + 1 < width ) {
+      bumpiness = Ops::add( bumpiness, Ops::abs( Ops::sub( heights[ x ], heights[ x + 1 ] ) ) );
+    }
+
+    const V left = x > 0 ? heights[ x - 1 ] : wall;
+    const V right = x + 1 < width ? heights[ x + 1 ] : wall;
+
+    wells = Ops::add( wells, Ops::max( zero, Ops::sub( Ops::min( left, right ), heights[ x ] ) ) );
+  }
+
+  //
+  // Spill the lanes back out to one Features per board.
+  //
+  int32_t lanes[ 6 ][ Ops::LANES ];
+  int32_t column_lanes[ game::BitBoard::MAX_WIDTH ][ Ops::LANES ];
+
+  Ops::store( lanes[ 0 ], aggregate_height );
+  Ops::store( lanes[ 1 ], holes );
+  Ops::store( lanes[ 2 ], bumpiness );
+  Ops::store( lanes[ 3 ], wells );
+  Ops::store( lanes[ 4 ], row_transitions );
+  Ops::store( lanes[ 5 ], column_transitions );
+
+  for( int x{}; x < width; ++x ) {
+    Ops::store( column_lanes[ x ], heights[ x ] );
+  }
+
+  for( size_t lane{}; lane < count; ++lane ) {
+    bot::Features& out = features[ lane ];
+    out = {};
+
+    for( int x{}; x < width; ++x ) {
+      out.column_heights[ x ] = ( uint8_t ) column_lanes[ x ][ lane ];
+    }
+
+    out.aggregate_height = lanes[ 0 ][ lane ];
+    out.holes = lanes[ 1 ][ lane ];
+    out.bumpiness = lanes[ 2 ][ lane ];
+    out.wells = lanes[ 3 ][ lane ];
+    out.row_transitions = lanes[ 4 ][ lane ];
+    out.column_transitions = lanes[ 5 ][ lane ];
+  }
+}
+
+#endif
+
+void bot::extract_features_batch( const uint32_t* lines, const int width, const int height, const size_t count, Features* features ) {
+#if defined( FEATURES_AVX2 ) || defined( FEATURES_SSE2 )
+#if defined( FEATURES_AVX2 )
+  using Ops = Avx2;
+#else
+  using Ops = Sse2;
+#endif
+
+  // Lanes past the last board read from an empty board and are thrown away.
+  static const uint32_t empty[ game::BitBoard::MAX_HEIGHT ] = {};
+
+  for( size_t first{}; first < count; first += Ops::LANES ) {
+    const size_t block = std::min< size_t >( Ops::LANES, count - first );
+
+    const uint32_t* boards[ Ops::LANES ];
+    for( size_t lane{}; lane < Ops::LANES; ++lane ) {
+      boards[ lane ] = lane < block ? lines + ( first + lane ) * height : empty;
+    }
+
+    extract_block< Ops >( boards, block, width, height, features + first );
+  }
+#else
+  for( size_t board{}; board < count; ++board ) {
+    features[ board ] = extract_features( lines + board * height, width, height );
+  }
+#endif
+}
+
+double bot::evaluate( const Features& features, const int lines_cleared, const Weights& weights ) {
+  return weights.aggregate_height * features.aggregate_height +
+    weights.lines * lines_cleared +
+    weights.holes * features.holes +
+    weights.bumpiness * features.bumpiness +
+    weights.wells * features.wells +
+    weights.row_transitions * features.row_transitions +
+    weights.column_transitions * features.column_transitions;
+}
\ No newline at end of file
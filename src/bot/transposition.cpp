@@ -0,0 +1,119 @@
+#include <bot/transposition.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+//
+// Entries are packed into a single word as score (32 bits) | move (16) | depth (8) | generation (7) | valid (1),
+// the valid bit keeps a stored entry from ever looking like an empty (all zero) slot.
+//
+static constexpr uint64_t VALID_BIT = 1ull << 63;
+
+static uint64_t pack( const bot::TranspositionEntry& entry, const uint8_t generation ) {
+  return ( uint64_t ) std::bit_cast< uint32_t >( entry.score ) |
+    ( ( uint64_t ) entry.move << 32 ) |
+    ( ( uint64_t ) entry.depth << 48 ) |
+    ( ( uint64_t ) ( generation & 0x7F ) << 56 ) |
+    VALID_BIT;
+}
+
+static bot::TranspositionEntry unpack( const uint64_t data ) {
+  bot::TranspositionEntry entry;
+  entry.score = std::bit_cast< float >( ( uint32_t ) data );
+  entry.move = ( uint16_t ) ( data >> 32 );
+  entry.depth = ( uint8_t ) ( data >> 48 );
+
+  return entry;
+}
+
+static uint8_t generation_of( const uint64_t data ) {
+  return ( uint8_t ) ( ( data >> 56 ) & 0x7F );
+}
+
+bot::TranspositionTable::TranspositionTable( const size_t size_mb ) :
+  m_num_buckets( std::bit_floor( std::max< size_t >( 1, ( size_mb << 20 ) / sizeof( Bucket ) ) ) ),
+  m_generation( 0 ) {
+  m_buckets = std::make_unique< Bucket[] >( m_num_buckets );
+  clear();
+}
+
+void bot::TranspositionTable::clear() {
+  for( size_t i{}; i < m_num_buckets; ++i ) {
+    for( std::atomic< uint64_t >& word : m_buckets[ i ].words ) {
+      word.store( 0, std::memory_order_relaxed );
+    }
+  }
+
+  m_generation = 0;
+}
+
+void bot::TranspositionTable::new_search() {
+  m_generation = ( m_generation + 1 ) & 0x7F;
+}
+
+bool bot::TranspositionTable::probe( const uint64_t key, TranspositionEntry& entry, TranspositionStats& stats ) const {
+  const bool timed = ( stats.probes++ % TIMING_INTERVAL ) == 0;
+  const auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+  const Bucket& bucket = m_buckets[ key & ( m_num_buckets - 1 ) ];
+  bool found = false;
+
+  for( int i{}; i < BUCKET_ENTRIES; ++i ) {
+    const uint64_t check = bucket.words[ i * 2 ].load( std::memory_order_relaxed );
+    const uint64_t data = bucket.words[ i * 2 + 1 ].load( std::memory_order_relaxed );
+
+    if( ( data & VALID_BIT ) && ( check ^ data ) == key ) {
+      entry = unpack( data );
+      found = true;
+      break;
+    }
+  }
+
+  if( found ) {
+    ++stats.hits;
+  }
+
+  if( timed ) {
+    stats.probe_ns += std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count();
+    ++stats.timed_probes;
+  }
+
+  return found;
+}
+
+void bot::TranspositionTable::store( const uint64_t key, const TranspositionEntry& entry, TranspositionStats& stats ) {
+  Bucket& bucket = m_buckets[ key & ( m_num_buckets - 1 ) ];
+
+  //
+  // Reuse the slot already holding this key, otherwise an empty one, otherwise replace the entry
+  // that matters least: from the oldest search first, then the shallowest.
+  //
+  int replace = 0;
+  int worst = 0x7FFFFFFF;
+
+  for( int i{}; i < BUCKET_ENTRIES; ++i ) {
+    const uint64_t check = bucket.words[ i * 2 ].load( std::memory_order_relaxed );
+    const uint64_t data = bucket.words[ i * 2 + 1 ].load( std::memory_order_relaxed );
+
+    if( ( data & VALID_BIT ) == 0 || ( check ^ data ) == key ) {
+      replace = i;
+      break;
+    }
+
+    const int age = ( m_generation - generation_of( data ) ) & 0x7F;
+    const int value = ( int ) ( ( data >> 48 ) & 0xFF ) - age * 256;
+
+    if( value < worst ) {
+      worst = value;
+      replace = i;
+    }
+  }
+
+  const uint64_t data = pack( entry, m_generation );
+
+  bucket.words[ replace * 2 ].store( key ^ data, std::memory_order_relaxed );
+  bucket.words[ replace * 2 + 1 ].store( data, std::memory_order_relaxed );
+
+  ++stats.stores;
+}
\ No newline at end of file
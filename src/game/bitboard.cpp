@@ -0,0 +1,107 @@
+#include <game/bitboard.hpp>
+
+#include <cstring>
+
+template< int W, int H >
+game::BasicBitBoard< W, H >::BasicBitBoard( const int width, const int height ) :
+  m_extent( width, height ),
+  m_full_line( make_full_line< line_t >( m_extent.width() ) ) {
+  if constexpr( DYNAMIC ) {
+    m_lines.resize( m_extent.height() );
+    m_colours.resize( m_extent.height() * COLOUR_WORDS );
+  }
+
+  clear();
+}
+
+template< int W, int H >
+void game::BasicBitBoard< W, H >::clear() {
+  memset( m_lines.data(), 0, sizeof( line_t ) * height() );
+  memset( m_colours.data(), 0, sizeof( uint64_t ) * height() * COLOUR_WORDS );
+}
+
+template< int W, int H >
+const int game::BasicBitBoard< W, H >::get( const int x, const int y ) const {
+  if( x < 0 || y < 0 || x >= width() || y >= height() ) {
+    return 0;
+  }
+
+  return ( int ) ( ( m_colours[ y * COLOUR_WORDS + x / 16 ] >> ( ( x % 16 ) * 4 ) ) & 0xF );
+}
+
+template< int W, int H >
+void game::BasicBitBoard< W, H >::set( const int x, const int y, const int state ) {
+  if( x < 0 || y < 0 || x >= width() || y >= height() ) {
+    return;
+  }
+
+  uint64_t& colours = m_colours[ y * COLOUR_WORDS + x / 16 ];
+  const int shift = ( x % 16 ) * 4;
+  colours = ( colours & ~( 0xFull << shift ) ) | ( ( uint64_t ) ( state & 0xF ) << shift );
+
+  line_set( m_lines[ y ], x, state != 0 );
+}
+
+template< int W, int H >
+void game::BasicBitBoard< W, H >::clear_line( const int y ) {
+  if( y < 0 || y >= height() ) {
+    return;
+  }
+
+  m_lines[ y ] = {};
+  memset( &m_colours[ y * COLOUR_WORDS ], 0, sizeof( uint64_t ) * COLOUR_WORDS );
+}
+
+template< int W, int H >
+uint64_t game::BasicBitBoard< W, H >::clear_full_lines() {
+  uint64_t cleared = 0;
+
+  for( int y{}; y < height(); ++y ) {
+    if( m_lines[ y ] == m_full_line ) {
+      cleared |= 1ull << y;
+    }
+  }
+
+  if( cleared == 0 ) {
+    return 0;
+  }
+
+  // Walk up from the floor, moving each run of surviving lines down in one block so it sits
+  // directly on top of the lines already compacted below it.
+  int destination = height();
+
+  for( int y = height() - 1; y >= 0; --y ) {
+    if( cleared & ( 1ull << y ) ) {
+      continue;
+    }
+
+    int start = y;
+    while( start > 0 && ( cleared & ( 1ull << ( start - 1 ) ) ) == 0 ) {
+      --start;
+    }
+
+    const int count = y - start + 1;
+    destination -= count;
+
+    if( destination != start ) {
+      memmove( &m_lines[ destination ], &m_lines[ start ], sizeof( line_t ) * count );
+      memmove( &m_colours[ destination * COLOUR_WORDS ], &m_colours[ start * COLOUR_WORDS ], sizeof( uint64_t ) * count * COLOUR_WORDS );
+    }
+
+    y = start;
+  }
+
+  // Everything above the compacted lines is now empty.
+  memset( m_lines.data(), 0, sizeof( line_t ) * destination );
+  memset( m_colours.data(), 0, sizeof( uint64_t ) * destination * COLOUR_WORDS );
+
+  return cleared;
+}
+
+template class game::BasicBitBoard< 10, 20 >;
+template class game::BasicBitBoard< 10, 40 >;
+template class game::BasicBitBoard< 4, 20 >;
+template class game::BasicBitBoard< game::DYNAMIC_SIZE, game::DYNAMIC_SIZE >;
+template class game::BasicBitBoard< 32, 20 >;
+template class game::BasicBitBoard< 64, 20 >;
+template class game::BasicBitBoard< 128, 20 >;
\ No newline at end of file
@@ -1,34 +1,26 @@
-#define NOMINMAX
-
 #include <game/board.hpp>
-#include <game/game.hpp>
+#include <game/rules.hpp>
+#include <game/zobrist.hpp>
 
-#include <random>
 #include <algorithm>
 #include <vector>
+#include <bit>
 
-#include <ext/imgui/imgui.h>
-
-const float GRID_SIZE = 32.F;
-const float GRID_SPACING = 2.F;
-
-const auto& random_number = []( const int min, const int max ) -> int {
-  // https://en.cppreference.com/w/cpp/numeric/random
-  static std::random_device r;
-
-  std::default_random_engine e1( r() );
-  std::uniform_int_distribution<int> uniform_dist( min, max );
-  return uniform_dist( e1 );
-};
+template< int W, int H >
+game::BasicBoard< W, H >::BasicBoard( const uint64_t seed, const RandomizerType randomizer, const int preview_size ) requires( !DYNAMIC ) :
+  m_generator( seed, randomizer, preview_size ) {
+  reset();
+}
 
-game::Board::Board( Game* game ) : m_game( game ) {
-  m_columns = 20;
-  m_rows = 10;
-  m_state = std::make_unique< int[] >( m_rows * m_columns );
+template< int W, int H >
+game::BasicBoard< W, H >::BasicBoard( const int rows, const int columns, const uint64_t seed, const RandomizerType randomizer, const int preview_size ) requires( DYNAMIC ) :
+  m_state( rows, columns ),
+  m_generator( seed, randomizer, preview_size ) {
   reset();
 }
 
-void game::Board::initialize() {
+template< int W, int H >
+void game::BasicBoard< W, H >::initialize() {
   //
   // Game state.
   //
@@ -40,638 +32,575 @@ void game::Board::initialize() {
   //
   // Physics data.
   //
+  m_rotate_timer = 0;
+  m_move_timer = 0;
   m_first_move = true;
-  m_next_move_time = 0.0;
-  m_last_move_time = 0.0;
-  m_next_rotate_time = 0.0;
-  m_last_rotate_time = 0.0;
-  m_time_on_line = 0.0;
+  m_gravity_timer = 0;
+  m_hard_drop_held = false;
+  m_ticks = 0;
 
   //
   // Tetromino data.
   //
-  m_curr_tetromino = nullptr;
-  m_next_tetromino_idx = random_number( 0, NUM_TETROMINO - 1 );
-  m_curr_tetromino_idx = m_next_tetromino_idx;
   new_tetromino();
 }
 
-const int game::Board::get_index( const int row, const int column ) const {
-  if( row < 0 || column < 0 || row >= m_rows || column >= m_columns ) {
-    return -1;
-  }
-
-  return row * m_columns + column;
+template< int W, int H >
+const int game::BasicBoard< W, H >::get_state( const int row, const int column ) const {
+  return m_state.get( row, column );
 }
 
-const int game::Board::get_state( const int row, const int column ) const {
-  const int index = get_index( row, column );
-  if( index == -1 ) {
-    return 0;
-  }
-
-  return m_state[ index ];
-}
-
-void game::Board::set_state( const int row, const int column, int state ) {
-  const int index = get_index( row, column );
-  if( index == -1 ) {
+template< int W, int H >
+void game::BasicBoard< W, H >::set_state( const int row, const int column, int state ) {
+  if( row < 0 || column < 0 || row >= rows() || column >= columns() ) {
     return;
   }
 
-  m_state[ index ] = state;
-}
-
-void game::Board::new_tetromino() {
-  m_previous_position_x = 0;
-  m_previous_position_y = 0;
-
-  // TODO: better random
-  srand( time( NULL ) );
-  m_curr_tetromino_idx = m_next_tetromino_idx;
-  m_next_tetromino_idx = random_number( 0, NUM_TETROMINO - 1 );
-
-  if( m_curr_tetromino ) {
-    m_curr_tetromino->reset();
+  // Only filling or emptying a cell changes the hash, the colour doesn't count.
+  if( ( m_state.get( row, column ) != 0 ) != ( state != 0 ) ) {
+    m_hash ^= zobrist_cell( row, column );
   }
 
-  m_curr_tetromino = &m_tetromino[ m_curr_tetromino_idx ];
+  m_state.set( row, column, state );
 
-  m_current_position_x = ( m_rows / 2 );
-  m_current_position_y = 0;
-
-  // GAME OVER!!
-  if( !can_spawn_tetromino() ) {
-    m_game_over = true;
+  if( state != 0 ) {
+    m_surface[ row ] = std::min( m_surface[ row ], column );
   }
-}
-
-bool game::Board::can_spawn_tetromino() {
-  for( int i{}; i < 4; ++i ) {
-    for( int j{}; j < 4; ++j ) {
-      const int index = i * 4 + j;
-
-      const int mask = m_curr_tetromino->current_mask();
-      if( ( mask & ( 1 << index ) ) == 0 ) {
-        continue;
-      }
-
-      if( get_state( m_current_position_x + i, m_current_position_y + j ) ) {
-        return false;
-      }
-    }
+  else if( column == m_surface[ row ] ) {
+    m_surface[ row ] = find_surface( row, column + 1 );
   }
-
-  return true;
 }
 
-bool game::Board::can_move_down( const Tetromino& tetromino, const int x, const int y ) {
-  const int new_x = x;
-  const int new_y = y + 1;
-
-  if( new_y >= m_columns ) {
-    return false;
-  }
-
-  for( int row{ 0 }; row < 4; ++row ) {
-    const int column = tetromino.column_height( row );
-
-    const int index = row * 4 + column;
-    const int mask = tetromino.current_mask();
-    if( ( mask & ( 1 << index ) ) == 0 ) {
-      continue;
-    }
-
-    if( ( new_y + column ) >= m_columns ) {
-      return false;
-    }
-
-    if( get_state( new_x + row, new_y + column ) ) {
-      return false;
+template< int W, int H >
+const int game::BasicBoard< W, H >::find_surface( const int x, const int y ) const {
+  for( int column = y; column < columns(); ++column ) {
+    if( line_test( m_state.line_unchecked( column ), x ) ) {
+      return column;
     }
   }
 
-  return true;
+  return columns();
 }
 
-bool game::Board::can_move_side( const int side ) {
-  const int x = m_current_position_x + side;
-  const int y = m_current_position_y;
+template< int W, int H >
+const int game::BasicBoard< W, H >::drop_distance( const ShapeRotation& rotation, const int x, const int y ) const {
+  int distance = columns();
 
-  for( int column{ 0 }; column < 4; ++column ) {
-    const int row = side == 1 ? m_curr_tetromino->row_end( column ) :
-      m_curr_tetromino->row_start( column );
+  // Tetromino are connected so every row from left to width has a bottom cell.
+  for( int row = rotation.left; row < rotation.width; ++row ) {
+    const int gap = m_surface[ x + row ] - ( y + rotation.column_height[ row ] ) - 1;
 
-    const int index = row * 4 + column;
-    const int mask = m_curr_tetromino->current_mask();
-    if( ( mask & ( 1 << index ) ) == 0 ) {
-      continue;
-    }
+    if( gap < 0 ) {
+      distance = 0;
+      while( !collides( rotation, x, y + distance + 1 ) ) {
+        ++distance;
+      }
 
-    // Clamp to board bounds.
-    if( ( x + row ) >= m_rows || ( x + row ) < 0 ) {
-      return false;
+      return distance;
     }
 
-    // If the cell at the given row, column is set, we can't move there.
-    if( get_state( x + row, y + column ) ) {
-      return false;
-    }
+    distance = std::min( distance, gap );
   }
 
-  return true;
+  return distance;
 }
 
-bool game::Board::can_rotate() {
-  const int x = m_current_position_x;
-  const int y = m_current_position_y;
-
-  for( int row{}; row < 4; ++row ) {
-    for( int column{}; column < 4; ++column ) {
-      const int index = row * 4 + column;
+template< int W, int H >
+const uint64_t game::BasicBoard< W, H >::board_hash() const {
+  return m_hash;
+}
 
-      const int curr_mask = m_curr_tetromino->current_mask();
-      const int next_mask = m_curr_tetromino->next_mask();
-      if( ( next_mask & ( 1 << index ) ) == 0 ) {
-        continue;
-      }
+template< int W, int H >
+const uint64_t game::BasicBoard< W, H >::hash() const {
+  return m_hash ^ ZOBRIST_KEYS.current[ m_piece.type ] ^ ZOBRIST_KEYS.next[ m_next_tetromino_idx ];
+}
 
-      // Skip any overlapping cells.
-      if( ( curr_mask & ( 1 << index ) ) && ( next_mask & ( 1 << index ) ) ) {
-        continue;
-      }
+template< int W, int H >
+void game::BasicBoard< W, H >::new_tetromino() {
+  const int type = m_generator.next();
 
-      if( ( x + row ) >= m_rows || x < 0 ) {
-        return false;
-      }
+  // Spawn in the middle, pulled back in from the right edge on boards too narrow for that.
+  const int x = std::min( rows() / 2, rows() - TETROMINO_TABLE[ type ].rotation( 0 ).width );
 
-      if( ( y + column ) >= m_columns || y < 0 ) {
-        return false;
-      }
+  m_piece = { ( uint8_t ) type, 0, ( int16_t ) x, 0 };
+  m_next_tetromino_idx = m_generator.peek( 0 );
 
-      if( get_state( x + row, y + column ) ) {
-        return false;
-      }
-    }
+  // GAME OVER!!
+  if( !can_spawn_tetromino() ) {
+    m_game_over = true;
   }
-
-  return true;
 }
 
-void game::Board::rotate_tetromino() {
-  clear_tetromino();
-  m_curr_tetromino->rotate();
+template< int W, int H >
+bool game::BasicBoard< W, H >::can_spawn_tetromino() {
+  return !collides( m_piece );
 }
 
-void game::Board::clear_tetromino() {
-  for( int i{}; i < 4; ++i ) {
-    for( int j{}; j < 4; ++j ) {
-      const int index = i * 4 + j;
+template< int W, int H >
+bool game::BasicBoard< W, H >::can_move_down() const {
+  return !collides( m_piece.moved( 0, 1 ) );
+}
 
-      const int mask = m_curr_tetromino->current_mask();
-      if( ( mask & ( 1 << index ) ) == 0 ) {
-        continue;
-      }
+template< int W, int H >
+bool game::BasicBoard< W, H >::can_move_side( const int side ) const {
+  return !collides( m_piece.moved( side, 0 ) );
+}
 
-      set_state( m_current_position_x + i, m_current_position_y + j, 0 );
-    }
-  }
+template< int W, int H >
+bool game::BasicBoard< W, H >::can_rotate() const {
+  return !collides( m_piece.rotated() );
 }
 
-void game::Board::clear_prev_tetromino() {
-  for( int i{}; i < 4; ++i ) {
-    for( int j{}; j < 4; ++j ) {
-      const int index = i * 4 + j;
+template< int W, int H >
+bool game::BasicBoard< W, H >::collides( const ShapeRotation& rotation, const int x, const int y ) const {
+  // Clamp to board bounds.
+  if( x + rotation.left < 0 || x + rotation.width > rows() ) {
+    return true;
+  }
 
-      const int mask = m_curr_tetromino->current_mask();
-      if( ( mask & ( 1 << index ) ) == 0 ) {
-        continue;
-      }
+  if( y + rotation.top < 0 || y + rotation.height > columns() ) {
+    return true;
+  }
 
-      set_state( m_previous_position_x + i, m_previous_position_y + j, 0 );
+  for( int column = rotation.top; column < rotation.height; ++column ) {
+    if( lines_overlap( make_line< line_t >( rotation.lines[ column ], x ), m_state.line_unchecked( y + column ) ) ) {
+      return true;
     }
   }
+
+  return false;
 }
 
-void game::Board::draw_tetromino() {
-  for( int i{}; i < 4; ++i ) {
-    for( int j{}; j < 4; ++j ) {
-      const int index = i * 4 + j;
+template< int W, int H >
+void game::BasicBoard< W, H >::lock_tetromino() {
+  const ShapeRotation& rotation = m_piece.shape();
 
-      const int mask = m_curr_tetromino->current_mask();
-      if( ( mask & ( 1 << index ) ) == 0 ) {
-        continue;
+  for( int row = rotation.left; row < rotation.width; ++row ) {
+    for( int column = rotation.top; column < rotation.height; ++column ) {
+      if( rotation.lines[ column ] & ( 1u << row ) ) {
+        set_state( m_piece.x + row, m_piece.y + column, 1 + m_piece.type );
       }
-
-      set_state( m_current_position_x + i, m_current_position_y + j, 1 + m_curr_tetromino_idx );
     }
   }
 }
 
-int game::Board::num_lines_completed() {
-  int lines = 0;
+template< int W, int H >
+void game::BasicBoard< W, H >::land_tetromino( StepResult& result ) {
+  // The tetromino has landed, this is the only point the board can gain a completed line.
+  const int level = m_level;
 
-  for( int line = m_columns - 1; line >= 0; --line ) {
-    // Skip any incomplete lines.
-    if( !is_line_complete( line ) ) {
-      continue;
-    }
+  lock_tetromino();
+  result.events |= event_locked;
 
-    ++lines;
+  result.cleared_lines = clear_completed_lines();
+  if( result.cleared_lines ) {
+    result.events |= event_lines_cleared;
   }
 
-  return lines;
-}
-
-bool game::Board::is_line_complete( const int line ) {
-  for( int row{}; row < m_rows; ++row ) {
-    if( !get_state( row, line ) ) {
-      return false;
-    }
+  if( m_level != level ) {
+    result.events |= event_level_up;
   }
 
-  return true;
+  new_tetromino();
+  result.events |= m_game_over ? event_game_over : event_spawned;
+
+  m_gravity_timer = 0;
 }
 
-void game::Board::move_line_down( const int line ) {
-  for( int i = 0; i < m_rows; ++i ) {
-    int state = get_state( i, line );
-    set_state( i, line + 1, state );
-    set_state( i, line, 0 );
+template< int W, int H >
+const int game::BasicBoard< W, H >::get_draw_state( const int row, const int column ) const {
+  const int line = column - m_piece.y;
+  const int offset = row - m_piece.x;
+  if( offset >= 0 && offset < 4 && ( m_piece.shape().line( line ) & ( 1u << offset ) ) ) {
+    return 1 + m_piece.type;
   }
+
+  return get_state( row, column );
 }
 
-void game::Board::clear_completed_lines() {
-  // Check all lines of the board from the bottom up and clear any completed lines, shifting
-  // all the above lines downwards by 1 and retaining their states.
+template< int W, int H >
+uint64_t game::BasicBoard< W, H >::clear_completed_lines() {
+  // Only the lines from the lowest full line up move, everything below keeps its place (and hash).
+  int lowest = columns() - 1;
+  while( lowest >= 0 && !m_state.is_line_full( lowest ) ) {
+    --lowest;
+  }
 
-  if( num_lines_completed() == 0 ) {
-    return;
+  if( lowest < 0 ) {
+    return 0;
   }
 
-  // Update the score for the number of lines completed.
-  update_score( num_lines_completed() );
-
-  // Clear all the completed lines.
-  do {
-    for( int line = m_columns - 1; line >= 0; --line ) {
-      // Skip any incomplete lines.
-      if( !is_line_complete( line ) ) {
-        continue;
-      }
+  for( int y{}; y <= lowest; ++y ) {
+    m_hash ^= zobrist_line( y, m_state.line( y ) );
+  }
 
-      // Clear the line.
-      for( int row = 0; row < m_rows; ++row ) {
-        set_state( row, line, 0 );
-      }
+  const uint64_t cleared = m_state.clear_full_lines();
 
-      // No more lines above that can be moved down.
-      if( line - 1 == 0 ) {
-        break;
-      }
+  //
+  // Columns move down by the number of lines cleared below their surface, unless the surface
+  // cell itself was cleared, then the column's new surface is somewhere below where it was.
+  //
+  for( int x{}; x < rows(); ++x ) {
+    const int surface = m_surface[ x ];
+    if( surface >= columns() ) {
+      continue;
+    }
 
-      // For all the lines above this line, move them down by 1.
-      for( int i = line - 1; i >= 0; --i ) {
-        move_line_down( i );
-      }
+    if( cleared & ( 1ull << surface ) ) {
+      m_surface[ x ] = find_surface( x, surface );
+    }
+    else {
+      m_surface[ x ] = surface + std::popcount( ( cleared >> surface ) >> 1 );
     }
   }
-  while( num_lines_completed() > 0 );
-}
-
-void game::Board::update_score( const int num_lines_completed ) {
-  const int base_scores[] = {
-    // single
-    40,
 
-    // double
-    100,
+  for( int y{}; y <= lowest; ++y ) {
+    m_hash ^= zobrist_line( y, m_state.line( y ) );
+  }
 
-    // triple
-    300,
+  // Update the score for the number of lines completed.
+  update_score( std::popcount( cleared ) );
 
-    // tetris
-    1200
-  };
+  return cleared;
+}
 
+template< int W, int H >
+void game::BasicBoard< W, H >::update_score( const int num_lines_completed ) {
   // Update score.
-  const int score = base_scores[ num_lines_completed - 1 ] * ( m_level + 1 );
-  m_score += score;
+  m_score += line_clear_score( num_lines_completed, m_level );
 
   // Update level (we're using A-Type level system)
   m_lines_cleared += num_lines_completed;
-  m_level = ceil( ( float ) ( m_lines_cleared / 10 ) );
-
-  // Whenever we update the score, increase the frequency at which the music plays back.
-  const float frequency_modifer = 1.F + std::min( ( 0.25F / 19 ) * ( m_level - 1 ), 0.25F );
-  m_game->music().set_frequency( frequency_modifer );
+  m_level = level_for_lines( m_lines_cleared );
 }
 
-const int game::Board::width() const {
-  return ( GRID_SIZE + GRID_SPACING ) * m_rows + GRID_SPACING;
-}
+template< int W, int H >
+bool game::BasicBoard< W, H >::physics_rotate( const uint8_t input, StepResult& result ) {
+  // Holding rotate turns the tetromino again every ROTATE_FRAMES ticks.
+  if( m_rotate_timer > 0 ) {
+    --m_rotate_timer;
+    return false;
+  }
 
-const int game::Board::height() const {
-  return ( GRID_SIZE + GRID_SPACING ) * m_columns + GRID_SPACING;
-}
+  if( !( input & input_rotate ) || !can_rotate() ) {
+    return false;
+  }
 
-void game::Board::draw( const float x, const float y ) {
-  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+  m_piece = m_piece.rotated();
+  result.events |= event_rotated;
 
-  float current_x = x;
-  float current_y = y;
+  m_rotate_timer = ROTATE_FRAMES - 1;
+  return true;
+}
 
-  //
-  // Draw the board grid and all tetromino colours.
-  //
-  for( int row{}; row < m_rows; ++row ) {
-    for( int column{}; column < m_columns; ++column ) {
-      if( get_state( row, column ) > 0 ) {
-        const int tetromino_idx = get_state( row, column ) - 1;
-        const uint32_t col = m_colours[ tetromino_idx ];
-        //const uint32_t col1 = 0xAF000000 | m_colours[ tetromino_idx ] & 0x00FFFFFF;
-
-        draw_list->AddRectFilled( 
-          { current_x, current_y },
-          { current_x + GRID_SIZE, current_y + GRID_SIZE }, 
-          col, 
-          4.F
-        );
-
-        //draw_list->AddRect(
-        //  { current_x, current_y },
-        //  { current_x + GRID_SIZE, current_y + GRID_SIZE },
-        //  col,
-        //  4.F,
-        //  0,
-        //  2.F
-        //);
-      }
-      else {
-        draw_list->AddRect( 
-          { current_x, current_y }, 
-          { current_x + GRID_SIZE, current_y + GRID_SIZE }, 
-          0x3FFFFFFF, 
-          4.F 
-        );
-      }
+template< int W, int H >
+void game::BasicBoard< W, H >::physics_move( const uint8_t input, StepResult& result ) {
+  /*
+   https://en.wikipedia.org/wiki/Tetris_(NES_video_game)
 
-      current_y += GRID_SIZE + GRID_SPACING;
-    }
+   One of the most limiting factors in NES Tetris is the speed at which a tetromino can be moved left and
+   right. On the NTSC version, when a movement key is pressed, the piece will instantly move one grid cell,
+   stop for 16 frames due to delayed auto-shift, before moving again once every 6 frames[12] (10 times a
+   second, as the game runs at 60 fps[13][better source needed]). At higher levels, waiting for this delay
+   is not feasible because the pieces fall too fast.
+ */
 
-    current_x += GRID_SIZE + GRID_SPACING;
-    current_y = y;
+  const bool left = input & input_left;
+  const bool right = input & input_right;
+  
+  // If neither movement key is pressed, reset.
+  if( !( left || right ) ) {
+    m_move_timer = 0;
+    m_first_move = true;
+    return;
   }
 
-  draw_list->AddRect(
-    { x - ( GRID_SPACING * 2.F ), y - ( GRID_SPACING * 2.F ) },
-    {
-      x + ( GRID_SIZE + GRID_SPACING ) * m_rows + GRID_SPACING,
-      y + ( GRID_SIZE + GRID_SPACING ) * m_columns + GRID_SPACING
-    },
-    0x7FFFFFFF
-  );
+  // Are we allowed to move yet?
+  if( m_move_timer > 0 ) {
+    --m_move_timer;
+  }
+
+  if( m_move_timer > 0 ) {
+    return;
+  }
 
   //
-  // Draw game information.
+  // We can now move, left wins if both keys are held.
   //
-  {
-    char buf[ 256 ] = { '\0' };
-    sprintf_s( buf, "MODE: A-TYPE\nSCORE: %d\nLEVEL: %d\nLINES: %d", m_score, m_level + 1, m_lines_cleared );
-    draw_list->AddText( { ( float ) current_x + 16, current_y + ( GRID_SIZE + GRID_SPACING ) * 4 + GRID_SPACING }, 0xFFFFFFFF, buf );
+  const int side = left ? -1 : 1;
+
+  if( can_move_side( side ) ) {
+    m_piece = m_piece.moved( side, 0 );
+    result.events |= event_moved;
   }
 
-  draw_preview( x, y );
-  draw_next_tetromino( x, y );
+  // Until we release all keys again, consider any further moves are repeats.
+  m_move_timer = m_first_move ? DAS_FRAMES : ARR_FRAMES;
+  m_first_move = false;
 }
 
-void game::Board::draw_preview( const float x, const float y ) {
-  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
-
-  int position_x = m_current_position_x;
-  int position_y = m_current_position_y;
+template< int W, int H >
+bool game::BasicBoard< W, H >::physics_gravity( const uint8_t input, StepResult& result ) {
+  //
+  // Hard drop, straight down to where the ghost is and locked in the same tick.
+  //
+  const bool hard_drop = ( input & input_hard_drop ) && !m_hard_drop_held;
+  m_hard_drop_held = input & input_hard_drop;
+
+  if( hard_drop ) {
+    const int distance = drop_distance();
+    if( distance > 0 ) {
+      m_piece = m_piece.moved( 0, distance );
+      m_score += distance * HARD_DROP_POINTS;
+      result.events |= event_dropped;
+    }
 
-  const Tetromino tetromino{ m_tetromino[ m_curr_tetromino_idx ] };
-  while( can_move_down( tetromino, position_x, position_y ) ) {
-    position_y += 1;
+    land_tetromino( result );
+    return false;
   }
 
-  const float start_x = x + ( ( GRID_SIZE + GRID_SPACING ) * position_x );
-  const float start_y = y + ( ( GRID_SIZE + GRID_SPACING ) * position_y );
-
-  float current_x = start_x;
-  float current_y = start_y;
-
-  const uint32_t col = m_colours[ m_curr_tetromino_idx ];
-  //const uint32_t col1 = 0x7F000000 | ( col & 0xFFFFFF );
-
-  for( int i{}; i < 4; ++i ) {
-    for( int j{}; j < 4; ++j ) {
-      const int index = i * 4 + j;
-
-      const int mask = m_curr_tetromino->current_mask();
-      if( ( mask & ( 1 << index ) ) ) {
-
-        draw_list->AddRect(
-          { current_x, current_y },
-          { current_x + GRID_SIZE, current_y + GRID_SIZE },
-          col,
-          4.F,
-          0,
-          2.F
-        );
-      }
-
-      current_y += GRID_SIZE + GRID_SPACING;
-    }
+  // How long we're allowed to stay on the current line based on our level.
+  const bool speed_up = input & input_soft_drop;
+  const int frames = drop_frames( gravity_frames( m_level ), speed_up );
 
-    current_x += GRID_SIZE + GRID_SPACING;
-    current_y = start_y;
+  if( ++m_gravity_timer < frames ) {
+    return true;
   }
-}
 
-void game::Board::draw_next_tetromino( const float x, const float y ) {
-  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+  m_gravity_timer = 0;
 
-  // Create a copy of the next tetromino and reset it to prevent copying over
-  // current mask stuff which indicates rotation, normally, this information
-  // is reset when a new tetromino is spawned so it's handled that way
-  // in the game, but in the preview, we just do a copy of the object.
-  Tetromino tetromino{ m_tetromino[ m_next_tetromino_idx ] };
-  tetromino.reset();
+  //
+  // One line at a time, or at 20G as far as the tetromino can fall, the distance comes from the
+  // surface so it's exact however far that is.
+  //
+  const int distance = frames == 0 ? drop_distance() : ( can_move_down() ? 1 : 0 );
 
-  const int rows = tetromino.width();
-  const int columns = tetromino.height();
+  if( distance == 0 ) {
+    land_tetromino( result );
+    return false;
+  }
 
-  const float start_x = x + width() + GRID_SIZE;
-  const float start_y = y;
+  m_piece = m_piece.moved( 0, distance );
+  result.events |= event_dropped;
 
-  float current_x = start_x;
-  float current_y = start_y;
+  if( speed_up ) {
+    m_score += distance * SOFT_DROP_POINTS;
+  }
 
-  for( int row{}; row < 4; ++row ) {
-    for( int column{}; column < 4; ++column ) {
-      // Draw the next tetromino.
-      const int index = row * 4 + column;
-      if( tetromino.current_mask() & ( 1 << index ) ) {
-        draw_list->AddRectFilled(
-          { current_x, current_y },
-          { current_x + GRID_SIZE, current_y + GRID_SIZE },
-          m_colours[ m_next_tetromino_idx ],
-          4.F
-        );
-      }
+  return true;
+}
 
-      current_y += GRID_SIZE + GRID_SPACING;
-    }
+template< int W, int H >
+game::StepResult game::BasicBoard< W, H >::step( const uint8_t input ) {
+  StepResult result{};
+  ++m_ticks;
 
-    current_x += GRID_SIZE + GRID_SPACING;
-    current_y = start_y;
+  if( m_game_over ) {
+    return result;
   }
 
-  draw_list->AddRect(
-    { start_x - ( GRID_SPACING * 2.F ), start_y - ( GRID_SPACING * 2.F ) },
-    {
-      start_x + ( GRID_SIZE + GRID_SPACING ) * rows + GRID_SPACING,
-      start_y + ( GRID_SIZE + GRID_SPACING ) * columns + GRID_SPACING
-    },
-    0x7FFFFFFF,
-    4.F
-  );
-}
+  physics_rotate( input, result );
+  physics_move( input, result );
+  physics_gravity( input, result );
 
-void game::Board::physics_start() {
-  m_previous_position_x = m_current_position_x;
-  m_previous_position_y = m_current_position_y;
+  return result;
 }
 
-bool game::Board::physics_rotate( const double t, const double dt ) {
-  const bool rotate = ImGui::IsKeyDown( ImGuiKey_R );
-
-  m_next_rotate_time = m_last_rotate_time + ( 6.0 / 60.0 );
-  if( t < m_next_rotate_time ) {
-    return false;
+template< int W, int H >
+const uint64_t game::BasicBoard< W, H >::ticks_to_event( const uint8_t input, const uint64_t limit ) {
+  // A hard drop happens on the first tick.
+  if( ( input & input_hard_drop ) && !m_hard_drop_held ) {
+    return 1;
   }
 
-  bool rotated = false;
+  // Gravity always comes around, moving the tetromino down or locking it.
+  const int frames = drop_frames( gravity_frames( m_level ), input & input_soft_drop );
+  uint64_t ticks = std::min< uint64_t >( limit, ( uint64_t ) std::max( 1, frames - m_gravity_timer ) );
 
-  if( rotate && can_rotate() ) {
-    rotate_tetromino();
-    rotated = true;
+  // Rotating and moving are only events if they'd work, the tetromino doesn't move in between so
+  // one that's blocked stays blocked. The collision test is only worth doing if it'd come first.
+  const uint64_t rotate = ( uint64_t ) m_rotate_timer + 1;
+  if( ( input & input_rotate ) && rotate < ticks && can_rotate() ) {
+    ticks = rotate;
   }
 
-  m_last_rotate_time = t;
-  return rotated;
-}
-
-void game::Board::physics_move( const double t, const double dt ) {
-  /*
-   https://en.wikipedia.org/wiki/Tetris_(NES_video_game)
-
-   One of the most limiting factors in NES Tetris is the speed at which a tetromino can be moved left and
-   right. On the NTSC version, when a movement key is pressed, the piece will instantly move one grid cell,
-   stop for 16 frames due to delayed auto-shift, before moving again once every 6 frames[12] (10 times a
-   second, as the game runs at 60 fps[13][better source needed]). At higher levels, waiting for this delay
-   is not feasible because the pieces fall too fast.
- */
+  const uint64_t move = ( uint64_t ) std::max( 1, m_move_timer );
+  if( ( input & ( input_left | input_right ) ) && move < ticks && can_move_side( ( input & input_left ) ? -1 : 1 ) ) {
+    ticks = move;
+  }
 
-  // I'm going to assume a rotation is considered a move and add the logic into here too.
+  return std::max< uint64_t >( 1, ticks );
+}
 
-  const bool left = ImGui::IsKeyDown( ImGuiKey_LeftArrow );
-  const bool right = ImGui::IsKeyDown( ImGuiKey_RightArrow );
-  
-  // If neither movement key is pressed, reset.
-  if( !( left || right ) ) {
-    m_last_move_time = 0.0;
-    m_first_move = true;
+template< int W, int H >
+void game::BasicBoard< W, H >::skip_ticks( const uint8_t input, const uint64_t ticks ) {
+  if( ticks == 0 ) {
     return;
   }
 
-  const double move_delay = m_first_move ? ( 16.0 / 60.0 ) : ( 6.0 / 60.0 );
-  m_next_move_time = m_last_move_time + move_delay;
+  m_ticks += ticks;
+  m_gravity_timer += ( int ) ticks;
+  m_rotate_timer = ( int ) std::max< int64_t >( 0, m_rotate_timer - ( int64_t ) ticks );
+  m_hard_drop_held = input & input_hard_drop;
 
-  // Are we allowed to move yet?
-  if( t < m_next_move_time ) {
+  if( !( input & ( input_left | input_right ) ) ) {
+    m_move_timer = 0;
+    m_first_move = true;
     return;
   }
 
   //
-  // We can now move.
+  // The move is blocked, but the auto shift still counts down, tries, and starts over with the
+  // repeat delay each time it comes around.
   //
-  if( left && can_move_side( -1 ) ) {
-    m_current_position_x -= 1;
-  }
-  else if( right && can_move_side( 1 ) ) {
-    m_current_position_x += 1;
+  const uint64_t first_try = ( uint64_t ) std::max( 1, m_move_timer );
+  if( ticks < first_try ) {
+    m_move_timer -= ( int ) ticks;
+    return;
   }
 
-  // Until we release all keys again, consider any further moves are repeats.
+  const uint64_t delay = m_first_move ? DAS_FRAMES : ARR_FRAMES;
+  const uint64_t after = ticks - first_try;
+
   m_first_move = false;
 
-  // Increment the last time we moved to the current physics time.
-  m_last_move_time = t;
+  if( after < delay ) {
+    m_move_timer = ( int ) ( delay - after );
+  }
+  else {
+    m_move_timer = ( int ) ( ARR_FRAMES - ( after - delay ) % ARR_FRAMES );
+  }
 }
 
-bool game::Board::physics_gravity( const double dt ) {
-  // How long we're allowed to stay on the current line based on our level.
-  //  
-  //    The formula is adapted from (https://harddrop.com/wiki/Tetris_Worlds) to work with
-  //    our physics running at 60fps.
-  //
-  const double max_time = 1.0 - ( m_level * 0.07 );
-  const double fast_time = ( 2.0 / 60.0 );
-
-  const bool speed_up = ImGui::IsKeyDown( ImGuiKey_S );
+template< int W, int H >
+const uint64_t game::BasicBoard< W, H >::fast_forward( const uint8_t input, const uint64_t max_ticks, StepResult& result ) {
+  result = {};
 
-  m_time_on_line += dt;
-  if( m_time_on_line >= ( speed_up ? fast_time : max_time ) ) {
-    if( !can_move_down( *m_curr_tetromino, m_current_position_x, m_current_position_y ) ) {
-      new_tetromino();
-      m_time_on_line = 0.0;
-      return false;
-    }
+  if( max_ticks == 0 ) {
+    return 0;
+  }
 
-    m_current_position_y = std::min( m_columns, m_current_position_y + 1 );
+  if( m_game_over ) {
+    m_ticks += max_ticks;
+    return max_ticks;
+  }
 
-    if( speed_up ) {
-      ++m_score;
-    }
+  const uint64_t ticks = ticks_to_event( input, max_ticks );
 
-    m_time_on_line = 0.0;
-  }
+  skip_ticks( input, ticks - 1 );
+  result = step( input );
 
-  return true;
+  return ticks;
 }
 
-void game::Board::physics( const double t, const double dt ) {
-  if( m_game_over ) {
-    return;
-  }
-  
-  physics_start();
-  physics_rotate( t, dt );
-  physics_move( t, dt );
-  physics_gravity( dt );
-}
+template< int W, int H >
+game::StepResult game::BasicBoard< W, H >::place( const Placement& placement ) {
+  StepResult result{};
 
-void game::Board::update() {
   if( m_game_over ) {
-    return;
+    return result;
   }
 
-  clear_prev_tetromino();
-  clear_completed_lines();
-  draw_tetromino();
+  m_piece.rotation = ( uint8_t ) placement.rotation;
+  m_piece.x = ( int16_t ) placement.x;
+  m_piece.y = ( int16_t ) placement.y;
+
+  land_tetromino( result );
+  return result;
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::update() {
+  // Nothing to do per tick, the current tetromino is composited on top of the board when drawing
+  // and completed lines are cleared as soon as a tetromino locks in physics_gravity.
 }
 
-void game::Board::reset() {
+template< int W, int H >
+void game::BasicBoard< W, H >::reset() {
   //
   // Reset the board state.
   //
-  memset( &m_state[ 0 ], 0, sizeof( int ) * m_rows * m_columns );
+  m_state.clear();
+  m_hash = 0;
+  std::fill( std::begin( m_surface ), std::end( m_surface ), columns() );
 
   //
   // Initialize all board related data (physics, etc..)
   //
   initialize();
-}
\ No newline at end of file
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::reset( const uint64_t seed ) {
+  m_generator.reset( seed );
+  reset();
+}
+
+template< int W, int H >
+game::BoardSnapshot game::BasicBoard< W, H >::snapshot() const requires( DYNAMIC || W <= BitBoard::MAX_WIDTH ) {
+  BoardSnapshot snapshot{};
+
+  for( int y{}; y < columns(); ++y ) {
+    for( int x{}; x < rows(); ++x ) {
+      snapshot.cells[ y ][ x ] = ( uint8_t ) m_state.get( x, y );
+    }
+  }
+
+  snapshot.piece = m_piece;
+
+  snapshot.rotate_timer = m_rotate_timer;
+  snapshot.move_timer = m_move_timer;
+  snapshot.first_move = m_first_move;
+  snapshot.gravity_timer = m_gravity_timer;
+  snapshot.hard_drop_held = m_hard_drop_held;
+  snapshot.ticks = m_ticks;
+
+  snapshot.game_over = m_game_over;
+  snapshot.level = m_level;
+  snapshot.lines_cleared = m_lines_cleared;
+  snapshot.score = m_score;
+
+  snapshot.generator = m_generator.state();
+
+  return snapshot;
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::restore( const BoardSnapshot& snapshot ) requires( DYNAMIC || W <= BitBoard::MAX_WIDTH ) {
+  m_state.clear();
+  m_hash = 0;
+  std::fill( std::begin( m_surface ), std::end( m_surface ), columns() );
+
+  for( int y{}; y < columns(); ++y ) {
+    for( int x{}; x < rows(); ++x ) {
+      if( snapshot.cells[ y ][ x ] != state_empty ) {
+        set_state( x, y, snapshot.cells[ y ][ x ] );
+      }
+    }
+  }
+
+  m_piece = snapshot.piece;
+
+  m_rotate_timer = snapshot.rotate_timer;
+  m_move_timer = snapshot.move_timer;
+  m_first_move = snapshot.first_move;
+  m_gravity_timer = snapshot.gravity_timer;
+  m_hard_drop_held = snapshot.hard_drop_held;
+  m_ticks = snapshot.ticks;
+
+  m_game_over = snapshot.game_over;
+  m_level = snapshot.level;
+  m_lines_cleared = snapshot.lines_cleared;
+  m_score = snapshot.score;
+
+  m_generator.restore( snapshot.generator );
+  m_next_tetromino_idx = m_generator.peek( 0 );
+}
+
+template class game::BasicBoard< 10, 20 >;
+template class game::BasicBoard< 10, 40 >;
+template class game::BasicBoard< 4, 20 >;
+template class game::BasicBoard< game::DYNAMIC_SIZE, game::DYNAMIC_SIZE >;
+template class game::BasicBoard< 32, 20 >;
+template class game::BasicBoard< 64, 20 >;
+template class game::BasicBoard< 128, 20 >;
\ No newline at end of file
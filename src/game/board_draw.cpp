@@ -0,0 +1,199 @@
+#include <game/board.hpp>
+
+#include <cstdio>
+
+#include <ext/imgui/imgui.h>
+
+//
+// Drawing for the board, kept out of board.cpp so the simulation itself builds without ImGui.
+//
+
+const float GRID_SIZE = 32.F;
+const float GRID_SPACING = 2.F;
+
+template< int W, int H >
+const int game::BasicBoard< W, H >::width() const {
+  return ( GRID_SIZE + GRID_SPACING ) * rows() + GRID_SPACING;
+}
+
+template< int W, int H >
+const int game::BasicBoard< W, H >::height() const {
+  return ( GRID_SIZE + GRID_SPACING ) * columns() + GRID_SPACING;
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::draw( const float x, const float y ) {
+  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+
+  float current_x = x;
+  float current_y = y;
+
+  //
+  // Draw the board grid and all tetromino colours.
+  //
+  for( int row{}; row < rows(); ++row ) {
+    for( int column{}; column < columns(); ++column ) {
+      const int state = get_draw_state( row, column );
+      if( state > 0 ) {
+        const int tetromino_idx = state - 1;
+        const uint32_t col = m_colours[ tetromino_idx ];
+        //const uint32_t col1 = 0xAF000000 | m_colours[ tetromino_idx ] & 0x00FFFFFF;
+
+        draw_list->AddRectFilled( 
+          { current_x, current_y },
+          { current_x + GRID_SIZE, current_y + GRID_SIZE }, 
+          col, 
+          4.F
+        );
+
+        //draw_list->AddRect(
+        //  { current_x, current_y },
+        //  { current_x + GRID_SIZE, current_y + GRID_SIZE },
+        //  col,
+        //  4.F,
+        //  0,
+        //  2.F
+        //);
+      }
+      else {
+        draw_list->AddRect( 
+          { current_x, current_y }, 
+          { current_x + GRID_SIZE, current_y + GRID_SIZE }, 
+          0x3FFFFFFF, 
+          4.F 
+        );
+      }
+
+      current_y += GRID_SIZE + GRID_SPACING;
+    }
+
+    current_x += GRID_SIZE + GRID_SPACING;
+    current_y = y;
+  }
+
+  draw_list->AddRect(
+    { x - ( GRID_SPACING * 2.F ), y - ( GRID_SPACING * 2.F ) },
+    {
+      x + ( GRID_SIZE + GRID_SPACING ) * rows() + GRID_SPACING,
+      y + ( GRID_SIZE + GRID_SPACING ) * columns() + GRID_SPACING
+    },
+    0x7FFFFFFF
+  );
+
+  //
+  // Draw game information.
+  //
+  {
+    char buf[ 256 ] = { '\0' };
+    sprintf_s( buf, "MODE: A-TYPE\nSCORE: %d\nLEVEL: %d\nLINES: %d", m_score, m_level + 1, m_lines_cleared );
+    draw_list->AddText( { ( float ) current_x + 16, current_y + ( GRID_SIZE + GRID_SPACING ) * 4 + GRID_SPACING }, 0xFFFFFFFF, buf );
+  }
+
+  draw_preview( x, y );
+  draw_next_tetromino( x, y );
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::draw_preview( const float x, const float y ) {
+  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+
+  const int position_x = m_piece.x;
+  const int position_y = ghost_y();
+
+  const float start_x = x + ( ( GRID_SIZE + GRID_SPACING ) * position_x );
+  const float start_y = y + ( ( GRID_SIZE + GRID_SPACING ) * position_y );
+
+  float current_x = start_x;
+  float current_y = start_y;
+
+  const uint32_t col = m_colours[ m_piece.type ];
+  //const uint32_t col1 = 0x7F000000 | ( col & 0xFFFFFF );
+
+  for( int i{}; i < 4; ++i ) {
+    for( int j{}; j < 4; ++j ) {
+      const int index = i * 4 + j;
+
+      const int mask = m_piece.shape().mask;
+      if( ( mask & ( 1 << index ) ) ) {
+
+        draw_list->AddRect(
+          { current_x, current_y },
+          { current_x + GRID_SIZE, current_y + GRID_SIZE },
+          col,
+          4.F,
+          0,
+          2.F
+        );
+      }
+
+      current_y += GRID_SIZE + GRID_SPACING;
+    }
+
+    current_x += GRID_SIZE + GRID_SPACING;
+    current_y = start_y;
+  }
+}
+
+template< int W, int H >
+void game::BasicBoard< W, H >::draw_next_tetromino( const float x, const float y ) {
+  ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+
+  // The next tetromino is always shown in its spawn rotation.
+  const ShapeRotation& rotation = TETROMINO_TABLE[ m_next_tetromino_idx ].rotation( 0 );
+
+  const int rows = rotation.width;
+  const int columns = rotation.height;
+
+  const float start_x = x + width() + GRID_SIZE;
+  const float start_y = y;
+
+  float current_x = start_x;
+  float current_y = start_y;
+
+  for( int row{}; row < 4; ++row ) {
+    for( int column{}; column < 4; ++column ) {
+      // Draw the next tetromino.
+      const int index = row * 4 + column;
+      if( rotation.mask & ( 1 << index ) ) {
+        draw_list->AddRectFilled(
+          { current_x, current_y },
+          { current_x + GRID_SIZE, current_y + GRID_SIZE },
+          m_colours[ m_next_tetromino_idx ],
+          4.F
+        );
+      }
+
+      current_y += GRID_SIZE + GRID_SPACING;
+    }
+
+    current_x += GRID_SIZE + GRID_SPACING;
+    current_y = start_y;
+  }
+
+  draw_list->AddRect(
+    { start_x - ( GRID_SPACING * 2.F ), start_y - ( GRID_SPACING * 2.F ) },
+    {
+      start_x + ( GRID_SIZE + GRID_SPACING ) * rows + GRID_SPACING,
+      start_y + ( GRID_SIZE + GRID_SPACING ) * columns + GRID_SPACING
+    },
+    0x7FFFFFFF,
+    4.F
+  );
+}
+
+//
+// The rest of BasicBoard is instantiated in board.cpp, the draw functions only exist here.
+//
+#define INSTANTIATE_DRAW( W, H ) \
+  template const int game::BasicBoard< W, H >::width() const; \
+  template const int game::BasicBoard< W, H >::height() const; \
+  template void game::BasicBoard< W, H >::draw( const float x, const float y ); \
+  template void game::BasicBoard< W, H >::draw_preview( const float x, const float y ); \
+  template void game::BasicBoard< W, H >::draw_next_tetromino( const float x, const float y );
+
+INSTANTIATE_DRAW( 10, 20 )
+INSTANTIATE_DRAW( 10, 40 )
+INSTANTIATE_DRAW( 4, 20 )
+INSTANTIATE_DRAW( game::DYNAMIC_SIZE, game::DYNAMIC_SIZE )
+
+#undef INSTANTIATE_DRAW
\ No newline at end of file
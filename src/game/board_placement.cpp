@@ -0,0 +1,204 @@
+#include <game/board.hpp>
+
+#include <algorithm>
+#include <bit>
+
+//
+// Placement search.
+//
+//    Positions are searched breadth first over ( rotation, y, x ) states. Rather than calling
+//    collides() for every state, the positions a rotation fits in on a line are worked out up
+//    front as a bitmask over x for every line the tetromino can reach, after that each step of
+//    the search is a single bit test.
+//
+
+// x ranges from -X_OFFSET (a rotation whose first set row is 3) to the last row of the board.
+static constexpr int X_OFFSET = 3;
+
+static constexpr int MAX_POSITIONS = game::BitBoard::MAX_WIDTH + X_OFFSET;
+
+// States are indexed as rotation << 11 | y << 5 | x so they can be unpacked with shifts.
+static constexpr int X_BITS = 5;
+static constexpr int Y_BITS = 6;
+static constexpr int MAX_STATES = 4 << ( X_BITS + Y_BITS );
+static constexpr int MAX_REACHABLE = 4 * game::BitBoard::MAX_HEIGHT * MAX_POSITIONS;
+
+static_assert( MAX_POSITIONS <= ( 1 << X_BITS ) && game::BitBoard::MAX_HEIGHT <= ( 1 << Y_BITS ) );
+
+static constexpr uint16_t NOT_VISITED = 0xFFFF;
+
+template< int W, int H >
+void game::BasicBoard< W, H >::find_placements( PlacementList& list ) const {
+  static_assert( DYNAMIC || W <= BitBoard::MAX_WIDTH, "positions are searched as 32 bit masks" );
+
+  list.clear();
+
+  if( m_game_over ) {
+    return;
+  }
+
+  const Tetromino& tetromino = m_piece.tetromino();
+  const int num_rotations = ( int ) tetromino.num_rotations();
+  const int positions = rows() + X_OFFSET;
+  const int lines = columns();
+  const int first_line = m_piece.y;
+
+  //
+  // fits[ rotation * lines + y ] has bit x + X_OFFSET set when the rotation can be placed at x, y.
+  //
+  //    Each line is padded with X_OFFSET wall cells on the left and walls from the right edge up,
+  //    lines below the board are solid, that way the bounds checks fall out of the same test as
+  //    the filled cells. A cell at row k of the mask then blocks x wherever the padded line has
+  //    bit x + X_OFFSET + k set, i.e., the padded line shifted down by k.
+  //
+  uint32_t fits[ 4 * ( DYNAMIC ? BitBoard::MAX_HEIGHT : H ) ];
+
+  const uint32_t walls = ~( m_state.full_line() << X_OFFSET );
+  const uint32_t all_positions = ( 1u << positions ) - 1;
+
+  for( int rotation_idx{}; rotation_idx < num_rotations; ++rotation_idx ) {
+    const ShapeRotation& rotation = tetromino.rotation( rotation_idx );
+
+    for( int y = first_line; y < lines; ++y ) {
+      uint32_t blocked = 0;
+
+      for( int column = rotation.top; column < rotation.height; ++column ) {
+        const int line = y + column;
+        const uint32_t padded = line < lines ? ( m_state.line( line ) << X_OFFSET ) | walls : ~0u;
+
+        for( uint32_t cells = rotation.lines[ column ]; cells != 0; cells &= cells - 1 ) {
+          blocked |= padded >> std::countr_zero( cells );
+        }
+      }
+
+      fits[ rotation_idx * lines + y ] = ~blocked & all_positions;
+    }
+  }
+
+  const auto fits_at = [ & ]( const int rotation_idx, const int x, const int y ) {
+    return x >= 0 && y < lines && ( fits[ rotation_idx * lines + y ] & ( 1u << x ) ) != 0;
+  };
+
+  const auto state_of = []( const int rotation_idx, const int x, const int y ) {
+    return ( uint16_t ) ( ( rotation_idx << ( X_BITS + Y_BITS ) ) | ( y << X_BITS ) | x );
+  };
+
+  //
+  // Two rotations of a tetromino could cover the same cells if one of them is the other moved
+  // over, only then can different states end up as the same placement and need to be checked.
+  //
+  bool duplicate_rotations = false;
+
+  for( int a{}; a < num_rotations; ++a ) {
+    for( int b = a + 1; b < num_rotations; ++b ) {
+      const ShapeRotation& first = tetromino.rotation( a );
+      const ShapeRotation& second = tetromino.rotation( b );
+
+      bool same = first.height - first.top == second.height - second.top;
+      for( int column{}; same && column < first.height - first.top; ++column ) {
+        same = ( first.lines[ first.top + column ] >> first.left ) == ( second.lines[ second.top + column ] >> second.left );
+      }
+
+      duplicate_rotations |= same;
+    }
+  }
+
+  //
+  // Breadth first search, parent holds the state each state was first reached from and move the
+  // Move taken to get there.
+  //
+  uint16_t parent[ MAX_STATES ];
+  uint8_t move[ MAX_STATES ];
+  uint16_t queue[ MAX_REACHABLE ];
+  uint8_t path[ MAX_REACHABLE ];
+
+  for( int rotation_idx{}; rotation_idx < num_rotations; ++rotation_idx ) {
+    const uint16_t first = state_of( rotation_idx, 0, first_line );
+    std::fill_n( parent + first, ( lines - first_line ) << X_BITS, NOT_VISITED );
+  }
+
+  const int start_rotation = m_piece.rotation;
+  const int start_x = m_piece.x + X_OFFSET;
+
+  if( !fits_at( start_rotation, start_x, first_line ) ) {
+    return;
+  }
+
+  const uint16_t start = state_of( start_rotation, start_x, first_line );
+  parent[ start ] = start;
+
+  int head = 0;
+  int tail = 0;
+  queue[ tail++ ] = start;
+
+  const auto visit = [ & ]( const uint16_t from, const int rotation_idx, const int x, const int y, const Move how ) {
+    if( !fits_at( rotation_idx, x, y ) ) {
+      return;
+    }
+
+    const uint16_t state = state_of( rotation_idx, x, y );
+    if( parent[ state ] != NOT_VISITED ) {
+      return;
+    }
+
+    parent[ state ] = from;
+    move[ state ] = how;
+    queue[ tail++ ] = state;
+  };
+
+  while( head < tail ) {
+    const uint16_t state = queue[ head++ ];
+
+    const int x = state & ( ( 1 << X_BITS ) - 1 );
+    const int y = ( state >> X_BITS ) & ( ( 1 << Y_BITS ) - 1 );
+    const int rotation_idx = state >> ( X_BITS + Y_BITS );
+
+    if( num_rotations > 1 ) {
+      visit( state, rotation_idx + 1 == num_rotations ? 0 : rotation_idx + 1, x, y, move_rotate );
+    }
+
+    visit( state, rotation_idx, x - 1, y, move_left );
+    visit( state, rotation_idx, x + 1, y, move_right );
+
+    if( fits_at( rotation_idx, x, y + 1 ) ) {
+      visit( state, rotation_idx, x, y + 1, move_down );
+      continue;
+    }
+
+    //
+    // Can't move down from here, the tetromino would lock.
+    //
+    //    Within a rotation every state is a different set of cells. States come off the queue in
+    //    order of distance, so the first time a set of cells is seen is the shortest way there.
+    //
+    const ShapeRotation& rotation = tetromino.rotation( rotation_idx );
+
+    Placement placement{};
+    placement.rotation = rotation_idx;
+    placement.x = x - X_OFFSET;
+    placement.y = y;
+    placement.top = y + rotation.top;
+
+    for( int column = rotation.top; column < rotation.height; ++column ) {
+      const BitBoard::line_t cells = rotation.lines[ column ];
+      placement.lines[ column - rotation.top ] = placement.x < 0 ? cells >> -placement.x : cells << placement.x;
+    }
+
+    if( duplicate_rotations && list.contains( placement.top, placement.lines ) ) {
+      continue;
+    }
+
+    // Walk back to the start, filling the path in from the end.
+    int path_start = MAX_REACHABLE;
+    for( uint16_t step = state; step != start; step = parent[ step ] ) {
+      path[ --path_start ] = move[ step ];
+    }
+
+    std::copy( path + path_start, path + MAX_REACHABLE, list.add( placement, MAX_REACHABLE - path_start ) );
+  }
+}
+
+template void game::BasicBoard< 10, 20 >::find_placements( PlacementList& list ) const;
+template void game::BasicBoard< 10, 40 >::find_placements( PlacementList& list ) const;
+template void game::BasicBoard< 4, 20 >::find_placements( PlacementList& list ) const;
+template void game::BasicBoard< game::DYNAMIC_SIZE, game::DYNAMIC_SIZE >::find_placements( PlacementList& list ) const;
\ No newline at end of file
@@ -0,0 +1,607 @@
+#include <game/board_stream.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+//
+// Varints.
+//
+static void put_varint( uint8_t*& out, uint64_t value ) {
+  while( value >= 0x80 ) {
+    *out++ = ( uint8_t ) ( value | 0x80 );
+    value >>= 7;
+  }
+
+  *out++ = ( uint8_t ) value;
+}
+
+static uint64_t zigzag( const int64_t value ) {
+  return ( ( uint64_t ) value << 1 ) ^ ( uint64_t ) ( value >> 63 );
+}
+
+static int64_t unzigzag( const uint64_t value ) {
+  return ( int64_t ) ( value >> 1 ) ^ -( int64_t ) ( value & 1 );
+}
+
+//
+// Reads a frame, running off the end of the buffer or reading something out of range stops it.
+//
+struct FrameReader {
+  const uint8_t* data;
+  const uint8_t* end;
+
+  // Set when the frame runs past the end of the buffer.
+  bool incomplete;
+
+  // Set when the frame can't be valid however much more of it arrives.
+  bool invalid;
+
+  const bool ok() const {
+    return !incomplete && !invalid;
+  }
+
+  uint8_t u8() {
+    if( data >= end ) {
+      incomplete = true;
+      return 0;
+    }
+
+    return *data++;
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+
+    for( int shift{}; shift < 64; shift += 7 ) {
+      if( data >= end ) {
+        incomplete = true;
+        return 0;
+      }
+
+      const uint8_t byte = *data++;
+      value |= ( uint64_t ) ( byte & 0x7F ) << shift;
+
+      if( !( byte & 0x80 ) ) {
+        return value;
+      }
+    }
+
+    invalid = true;
+    return 0;
+  }
+
+  // A varint that has to be at most limit.
+  uint64_t varint( const uint64_t limit ) {
+    const uint64_t value = varint();
+    invalid |= value > limit;
+    return value;
+  }
+};
+
+//
+// Changes shared by the encoder and decoder, so both sides keep the same board.
+//
+static void compact_lines( game::StreamedBoard& board, const uint64_t cleared ) {
+  int destination = board.height - 1;
+
+  for( int y = board.height - 1; y >= 0; --y ) {
+    if( cleared & ( 1ull << y ) ) {
+      continue;
+    }
+
+    board.lines[ destination ] = board.lines[ y ];
+    board.colours[ destination ] = board.colours[ y ];
+    --destination;
+  }
+
+  for( ; destination >= 0; --destination ) {
+    board.lines[ destination ] = 0;
+    board.colours[ destination ] = 0;
+  }
+}
+
+// XORs a line's occupancy, cells filled by it take on state and cells emptied by it go back to 0.
+static void apply_line( game::StreamedBoard& board, const int y, const uint32_t delta, const int state ) {
+  const uint32_t line = board.lines[ y ] ^ delta;
+
+  uint64_t colours = board.colours[ y ];
+  for( uint32_t bits = delta; bits; bits &= bits - 1 ) {
+    const int x = std::countr_zero( bits );
+    colours &= ~( 0xFull << ( x * 4 ) );
+
+    if( line & ( 1u << x ) ) {
+      colours |= ( uint64_t ) state << ( x * 4 );
+    }
+  }
+
+  board.lines[ y ] = line;
+  board.colours[ y ] = colours;
+}
+
+//
+// Encoder.
+//
+
+// Longest a delta frame can be: header, piece, lock (two masks and a line each), preview and stats.
+static constexpr size_t MAX_FRAME_SIZE = 1 + 3 + 3 + 1 + 1 + 10 + 10 + game::BitBoard::MAX_HEIGHT * 5 + game::PieceGenerator::MAX_PREVIEW + 3 * 10;
+
+// Longest a resync frame can be.
+static constexpr size_t MAX_RESYNC_SIZE = 1 + 3 * 10 + 10 + 1 + 2 * 10 + game::PieceGenerator::MAX_PREVIEW + 3 * 10 + 1 +
+  game::BitBoard::MAX_HEIGHT * 3 + game::BitBoard::MAX_HEIGHT * game::BitBoard::MAX_WIDTH / 2;
+
+game::BoardStreamEncoder::BoardStreamEncoder( const int resync_interval ) :
+  m_resync_offset( 0 ),
+  m_resync_interval( std::max( 1, resync_interval ) ),
+  m_last{},
+  m_started( false ),
+  m_last_resync( 0 ),
+  m_idle( 0 ) {}
+
+void game::BoardStreamEncoder::clear() {
+  m_data.clear();
+  m_resync_offset = 0;
+  m_started = false;
+  m_idle = 0;
+}
+
+void game::BoardStreamEncoder::flush_idle() {
+  if( m_idle == 0 ) {
+    return;
+  }
+
+  uint8_t frame[ 11 ];
+  uint8_t* out = frame;
+
+  *out++ = FRAME_IDLE;
+  put_varint( out, m_idle );
+
+  m_data.insert( m_data.end(), frame, out );
+  m_idle = 0;
+}
+
+template< int W, int H >
+void game::BoardStreamEncoder::write_resync( const BasicBoard< W, H >& board ) {
+  uint8_t frame[ MAX_RESYNC_SIZE ];
+  uint8_t* out = frame;
+
+  StreamedBoard& last = m_last;
+
+  last.width = board.rows();
+  last.height = board.columns();
+  last.preview_size = board.preview_size();
+  last.ticks = board.ticks();
+  last.piece = board.piece();
+  last.score = board.score();
+  last.lines_cleared = board.lines_cleared();
+  last.level = board.level();
+  last.game_over = board.is_game_over();
+
+  *out++ = FRAME_RESYNC;
+  put_varint( out, last.width );
+  put_varint( out, last.height );
+  put_varint( out, last.preview_size );
+  put_varint( out, last.ticks );
+
+  *out++ = ( uint8_t ) ( last.piece.type << 4 | last.piece.rotation );
+  put_varint( out, zigzag( last.piece.x ) );
+  put_varint( out, zigzag( last.piece.y ) );
+
+  for( int n{}; n < last.preview_size; ++n ) {
+    last.preview[ n ] = ( uint8_t ) board.preview( n );
+    *out++ = last.preview[ n ];
+  }
+
+  put_varint( out, ( uint32_t ) last.score );
+  put_varint( out, ( uint32_t ) last.lines_cleared );
+  put_varint( out, ( uint32_t ) last.level );
+  *out++ = last.game_over ? 1 : 0;
+
+  for( int y{}; y < last.height; ++y ) {
+    last.lines[ y ] = ( uint32_t ) board.line( y );
+    put_varint( out, last.lines[ y ] );
+  }
+
+  // Block states of the filled cells, two to a byte.
+  int nibble = 0;
+
+  for( int y{}; y < last.height; ++y ) {
+    last.colours[ y ] = 0;
+
+    for( uint32_t bits = last.lines[ y ]; bits; bits &= bits - 1 ) {
+      const int x = std::countr_zero( bits );
+      const uint8_t state = ( uint8_t ) ( board.get_state( x, y ) & 0xF );
+
+      last.colours[ y ] |= ( uint64_t ) state << ( x * 4 );
+
+      if( nibble++ & 1 ) {
+        out[ -1 ] |= state << 4;
+      }
+      else {
+        *out++ = state;
+      }
+    }
+  }
+
+  m_resync_offset = m_data.size();
+  m_data.insert( m_data.end(), frame, out );
+
+  m_started = true;
+  m_last_resync = last.ticks;
+}
+
+template< int W, int H >
+void game::BoardStreamEncoder::encode( const BasicBoard< W, H >& board, const StepResult& result, const uint64_t ticks ) {
+  static_assert( BasicBoard< W, H >::DYNAMIC || W <= BitBoard::MAX_WIDTH, "lines are streamed as 32 bit masks" );
+
+  StreamedBoard& last = m_last;
+
+  // Anything that isn't the tick after the last one starts over from a resync.
+  if( !m_started || board.ticks() != last.ticks + ticks || board.ticks() - m_last_resync >= ( uint64_t ) m_resync_interval ) {
+    m_idle = 0;
+    write_resync( board );
+    return;
+  }
+
+  last.ticks = board.ticks();
+  m_idle += ticks - 1;
+
+  const PieceState& piece = board.piece();
+
+  uint8_t header = 0;
+
+  if( piece.x != last.piece.x ) {
+    header |= FRAME_PIECE_X;
+  }
+
+  if( piece.y != last.piece.y ) {
+    header |= FRAME_PIECE_Y;
+  }
+
+  if( piece.type != last.piece.type || piece.rotation != last.piece.rotation ) {
+    header |= FRAME_PIECE_SHAPE;
+  }
+
+  // Locked cells and the preview only change when a tetromino lands.
+  if( result.events & event_locked ) {
+    header |= FRAME_LOCKED;
+  }
+
+  if( result.events & ( event_spawned | event_game_over ) ) {
+    for( int n{}; n < last.preview_size; ++n ) {
+      if( board.preview( n ) != last.preview[ n ] ) {
+        header |= FRAME_PREVIEW;
+        break;
+      }
+    }
+  }
+
+  if( board.score() != last.score || board.lines_cleared() != last.lines_cleared || board.level() != last.level ) {
+    header |= FRAME_STATS;
+  }
+
+  if( board.is_game_over() && !last.game_over ) {
+    header |= FRAME_GAME_OVER;
+  }
+
+  if( header == 0 ) {
+    ++m_idle;
+    return;
+  }
+
+  flush_idle();
+
+  uint8_t frame[ MAX_FRAME_SIZE ];
+  uint8_t* out = frame;
+
+  *out++ = header;
+
+  if( header & FRAME_PIECE_X ) {
+    put_varint( out, zigzag( piece.x - last.piece.x ) );
+  }
+
+  if( header & FRAME_PIECE_Y ) {
+    put_varint( out, zigzag( piece.y - last.piece.y ) );
+  }
+
+  if( header & FRAME_PIECE_SHAPE ) {
+    *out++ = ( uint8_t ) ( piece.type << 4 | piece.rotation );
+  }
+
+  last.piece = piece;
+
+  if( header & FRAME_LOCKED ) {
+    const uint64_t cleared = result.cleared_lines;
+    compact_lines( last, cleared );
+
+    // Every cell a tetromino locks is the same block state, taken from whichever is found first.
+    uint64_t changed = 0;
+    uint32_t deltas[ BitBoard::MAX_HEIGHT ];
+    int state = 0;
+
+    for( int y{}; y < last.height; ++y ) {
+      deltas[ y ] = ( uint32_t ) board.line( y ) ^ last.lines[ y ];
+
+      if( deltas[ y ] ) {
+        changed |= 1ull << y;
+
+        const uint32_t filled = deltas[ y ] & ( uint32_t ) board.line( y );
+        if( state == 0 && filled ) {
+          state = board.get_state( std::countr_zero( filled ), y ) & 0xF;
+        }
+      }
+    }
+
+    *out++ = ( uint8_t ) state;
+    put_varint( out, cleared );
+    put_varint( out, changed );
+
+    for( uint64_t bits = changed; bits; bits &= bits - 1 ) {
+      const int y = std::countr_zero( bits );
+
+      put_varint( out, deltas[ y ] );
+      apply_line( last, y, deltas[ y ], state );
+    }
+  }
+
+  if( header & FRAME_PREVIEW ) {
+    for( int n{}; n < last.preview_size; ++n ) {
+      last.preview[ n ] = ( uint8_t ) board.preview( n );
+      *out++ = last.preview[ n ];
+    }
+  }
+
+  if( header & FRAME_STATS ) {
+    put_varint( out, zigzag( ( int64_t ) board.score() - last.score ) );
+    put_varint( out, zigzag( ( int64_t ) board.lines_cleared() - last.lines_cleared ) );
+    put_varint( out, zigzag( ( int64_t ) board.level() - last.level ) );
+
+    last.score = board.score();
+    last.lines_cleared = board.lines_cleared();
+    last.level = board.level();
+  }
+
+  if( header & FRAME_GAME_OVER ) {
+    last.game_over = true;
+  }
+
+  m_data.insert( m_data.end(), frame, out );
+}
+
+//
+// Decoder.
+//
+game::BoardStreamDecoder::BoardStreamDecoder() :
+  m_board{},
+  m_synced( false ),
+  m_error( false ) {}
+
+void game::BoardStreamDecoder::reset() {
+  m_synced = false;
+  m_error = false;
+}
+
+static const uint8_t* decode_resync( FrameReader& in, game::StreamedBoard& board ) {
+  game::StreamedBoard next{};
+
+  next.width = ( int ) in.varint( game::BitBoard::MAX_WIDTH );
+  next.height = ( int ) in.varint( game::BitBoard::MAX_HEIGHT );
+  next.preview_size = ( int ) in.varint( game::PieceGenerator::MAX_PREVIEW );
+  next.ticks = in.varint();
+
+  const uint8_t shape = in.u8();
+  next.piece.type = shape >> 4;
+  next.piece.rotation = shape & 0xF;
+  next.piece.x = ( int16_t ) unzigzag( in.varint( 0xFFFF ) );
+  next.piece.y = ( int16_t ) unzigzag( in.varint( 0xFFFF ) );
+
+  for( int n{}; n < next.preview_size; ++n ) {
+    next.preview[ n ] = in.u8();
+    in.invalid |= next.preview[ n ] >= game::NUM_TETROMINO;
+  }
+
+  next.score = ( int ) in.varint( UINT32_MAX );
+  next.lines_cleared = ( int ) in.varint( UINT32_MAX );
+  next.level = ( int ) in.varint( UINT32_MAX );
+  next.game_over = in.u8() != 0;
+
+  if( !in.ok() ) {
+    return nullptr;
+  }
+
+  if( next.width == 0 || next.height == 0 || next.preview_size == 0 || !game::valid_shape( next.piece.type, next.piece.rotation ) ) {
+    in.invalid = true;
+    return nullptr;
+  }
+
+  const uint32_t full_line = ( uint32_t ) ( ( 1ull << next.width ) - 1 );
+
+  for( int y{}; y < next.height && in.ok(); ++y ) {
+    next.lines[ y ] = ( uint32_t ) in.varint( full_line );
+  }
+
+  uint8_t byte = 0;
+  int nibble = 0;
+
+  for( int y{}; y < next.height && in.ok(); ++y ) {
+    for( uint32_t bits = next.lines[ y ]; bits && in.ok(); bits &= bits - 1 ) {
+      if( ( nibble++ & 1 ) == 0 ) {
+        byte = in.u8();
+      }
+      else {
+        byte >>= 4;
+      }
+
+      next.colours[ y ] |= ( uint64_t ) ( byte & 0xF ) << ( std::countr_zero( bits ) * 4 );
+    }
+  }
+
+  if( !in.ok() ) {
+    return nullptr;
+  }
+
+  board = next;
+  return in.data;
+}
+
+const uint8_t* game::BoardStreamDecoder::decode_frame( const uint8_t* data, const uint8_t* end ) {
+  FrameReader in{ data, end, false, false };
+
+  const uint8_t header = in.u8();
+  if( in.incomplete ) {
+    return data;
+  }
+
+  if( header == BoardStreamEncoder::FRAME_RESYNC ) {
+    const uint8_t* next = decode_resync( in, m_board );
+
+    if( in.incomplete ) {
+      return data;
+    }
+
+    m_synced |= next != nullptr;
+    m_error |= next == nullptr;
+    return next;
+  }
+
+  if( !m_synced || header == 0 || ( ( header & 0x80 ) && header != BoardStreamEncoder::FRAME_IDLE ) ) {
+    m_error = true;
+    return nullptr;
+  }
+
+  StreamedBoard& board = m_board;
+
+  if( header == BoardStreamEncoder::FRAME_IDLE ) {
+    const uint64_t ticks = in.varint();
+    if( in.incomplete ) {
+      return data;
+    }
+
+    if( !in.ok() || ticks == 0 ) {
+      m_error = true;
+      return nullptr;
+    }
+
+    board.ticks += ticks;
+    return in.data;
+  }
+
+  //
+  // Read the whole frame before applying any of it, it may not all be here yet.
+  //
+  int64_t dx = 0;
+  int64_t dy = 0;
+  uint8_t shape = board.piece.type << 4 | board.piece.rotation;
+
+  int state = 0;
+  uint64_t cleared = 0;
+  uint64_t changed = 0;
+  uint32_t deltas[ BitBoard::MAX_HEIGHT ];
+
+  uint8_t preview[ PieceGenerator::MAX_PREVIEW ];
+  int64_t stats[ 3 ] = {};
+
+  const uint64_t all_lines = board.height == 64 ? ~0ull : ( 1ull << board.height ) - 1;
+  const uint32_t full_line = ( uint32_t ) ( ( 1ull << board.width ) - 1 );
+
+  if( header & BoardStreamEncoder::FRAME_PIECE_X ) {
+    dx = unzigzag( in.varint() );
+  }
+
+  if( header & BoardStreamEncoder::FRAME_PIECE_Y ) {
+    dy = unzigzag( in.varint() );
+  }
+
+  if( header & BoardStreamEncoder::FRAME_PIECE_SHAPE ) {
+    shape = in.u8();
+    in.invalid |= !game::valid_shape( shape >> 4, shape & 0xF );
+  }
+
+  if( header & BoardStreamEncoder::FRAME_LOCKED ) {
+    state = in.u8();
+    cleared = in.varint( all_lines );
+    changed = in.varint( all_lines );
+    in.invalid |= ( cleared & ~all_lines ) != 0 || ( changed & ~all_lines ) != 0 || state > 0xF;
+
+    for( uint64_t bits = changed; bits && in.ok(); bits &= bits - 1 ) {
+      deltas[ std::countr_zero( bits ) ] = ( uint32_t ) in.varint( full_line );
+    }
+  }
+
+  if( header & BoardStreamEncoder::FRAME_PREVIEW ) {
+    for( int n{}; n < board.preview_size; ++n ) {
+      preview[ n ] = in.u8();
+      in.invalid |= preview[ n ] >= NUM_TETROMINO;
+    }
+  }
+
+  if( header & BoardStreamEncoder::FRAME_STATS ) {
+    for( int64_t& stat : stats ) {
+      stat = unzigzag( in.varint() );
+    }
+  }
+
+  if( in.incomplete ) {
+    return data;
+  }
+
+  if( in.invalid ) {
+    m_error = true;
+    return nullptr;
+  }
+
+  //
+  // Apply it.
+  //
+  board.ticks += 1;
+  board.piece.x = ( int16_t ) ( board.piece.x + dx );
+  board.piece.y = ( int16_t ) ( board.piece.y + dy );
+  board.piece.type = shape >> 4;
+  board.piece.rotation = shape & 0xF;
+
+  if( header & BoardStreamEncoder::FRAME_LOCKED ) {
+    compact_lines( board, cleared );
+
+    for( uint64_t bits = changed; bits; bits &= bits - 1 ) {
+      const int y = std::countr_zero( bits );
+      apply_line( board, y, deltas[ y ], state );
+    }
+  }
+
+  if( header & BoardStreamEncoder::FRAME_PREVIEW ) {
+    std::copy( preview, preview + board.preview_size, board.preview );
+  }
+
+  board.score = ( int ) ( board.score + stats[ 0 ] );
+  board.lines_cleared = ( int ) ( board.lines_cleared + stats[ 1 ] );
+  board.level = ( int ) ( board.level + stats[ 2 ] );
+
+  if( header & BoardStreamEncoder::FRAME_GAME_OVER ) {
+    board.game_over = true;
+  }
+
+  return in.data;
+}
+
+size_t game::BoardStreamDecoder::decode( const uint8_t* data, const size_t size ) {
+  const uint8_t* end = data + size;
+  const uint8_t* in = data;
+
+  while( in < end ) {
+    const uint8_t* next = decode_frame( in, end );
+
+    // Invalid, or the rest of the frame is still to come.
+    if( next == nullptr || next == in ) {
+      break;
+    }
+
+    in = next;
+  }
+
+  return in - data;
+}
+
+template void game::BoardStreamEncoder::encode( const game::Board&, const game::StepResult&, const uint64_t );
+template void game::BoardStreamEncoder::encode( const game::TallBoard&, const game::StepResult&, const uint64_t );
+template void game::BoardStreamEncoder::encode( const game::PuzzleBoard&, const game::StepResult&, const uint64_t );
+template void game::BoardStreamEncoder::encode( const game::DynamicBoard&, const game::StepResult&, const uint64_t );
\ No newline at end of file
@@ -8,30 +8,215 @@
 #undef min
 #undef max
 
-game::Game::Game() : m_board( this ), m_music( TEXT( "Tetris.wav" ) ) {
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+// Where the replay of the last game played is written.
+static const char* REPLAY_PATH = "last_game.replay";
+
+game::Game::Game() : m_board( std::random_device{}() ), m_music( TEXT( "Tetris.wav" ) ) {
   m_draw_metrics = true;
   m_paused = false;
 
+  m_viewing = false;
+  m_view_playing = false;
+  m_view_speed = 1;
+  m_view_tick = 0;
+  m_view_jump = 0;
+
+  // Keep the searches short enough that the bot never holds up a frame.
+  m_autoplay = false;
+  m_autoplayer.settings().time_budget = 0.002;
+
+  m_replay.start( m_board );
+
   m_music.set_volume( 0.05F );
   m_music.play( true );
 }
 
 void game::Game::update( const app::Application& app, const double t, const double dt ) {
-  if( m_paused ) {
+  if( m_viewing && m_view_playing ) {
+    m_view_tick = m_view_replay.play( m_view_board, m_view_tick, m_view_speed );
+    m_view_board.update();
+
+    if( m_view_tick >= m_view_replay.size() ) {
+      m_view_playing = false;
+    }
+  }
+
+  if( m_paused || m_viewing ) {
     if( m_board.is_game_over() ) {
       m_paused = false;
     }
+    else {
+      m_replay.record( input_pause );
+    }
 
     return;
   }
 
-  m_board.physics( t, dt );
+  if( m_autoplay && m_board.is_game_over() ) {
+    m_board.reset( std::random_device{}() );
+    m_autoplayer.reset();
+    m_replay.start( m_board );
+  }
+
+  const uint8_t input = m_autoplay ? m_autoplayer.input( m_board ) : read_input();
+
+  if( !m_board.is_game_over() ) {
+    m_replay.record( input );
+  }
+
+  const StepResult result = m_board.step( input );
   m_board.update();
+
+  m_autoplayer.observe( result );
+
+  if( result.events & event_game_over ) {
+    m_replay.finish( m_board );
+    SeekableReplay::write( m_replay, REPLAY_PATH );
+  }
+
+  // Whenever we update the score, increase the frequency at which the music plays back.
+  if( result.events & event_lines_cleared ) {
+    const float frequency_modifer = 1.F + std::min( ( 0.25F / 19 ) * ( m_board.level() - 1 ), 0.25F );
+    m_music.set_frequency( frequency_modifer );
+  }
+}
+
+uint8_t game::Game::read_input() const {
+  uint8_t input = input_none;
+
+  if( ImGui::IsKeyDown( ImGuiKey_LeftArrow ) ) {
+    input |= input_left;
+  }
+
+  if( ImGui::IsKeyDown( ImGuiKey_RightArrow ) ) {
+    input |= input_right;
+  }
+
+  if( ImGui::IsKeyDown( ImGuiKey_R ) ) {
+    input |= input_rotate;
+  }
+
+  if( ImGui::IsKeyDown( ImGuiKey_S ) ) {
+    input |= input_soft_drop;
+  }
+
+  if( ImGui::IsKeyDown( ImGuiKey_Space ) ) {
+    input |= input_hard_drop;
+  }
+
+  return input;
+}
+
+bool game::Game::open_replay() {
+  const auto read = [ this ]() {
+    std::ifstream file( REPLAY_PATH, std::ios::binary );
+    m_view_data.assign( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+
+    return m_view_replay.open( m_view_data.data(), m_view_data.size() );
+  };
+
+  if( !read() ) {
+    // Replays saved before keyframes were added get rewritten with them.
+    Replay replay;
+    if( !replay.load( REPLAY_PATH ) || !SeekableReplay::write( replay, REPLAY_PATH ) || !read() ) {
+      return false;
+    }
+  }
+
+  m_view_board = m_view_replay.make_board();
+  m_view_tick = 0;
+  m_view_jump = 0;
+  m_view_playing = true;
+
+  return true;
+}
+
+void game::Game::seek_replay( const uint64_t tick ) {
+  m_view_tick = std::min( tick, m_view_replay.size() );
+  m_view_replay.seek( m_view_board, m_view_tick );
+}
+
+void game::Game::draw_replay_window() {
+  ImGui::SetNextWindowSize( { 420.F, 0.F }, ImGuiCond_FirstUseEver );
+
+  if( !ImGui::Begin( "Replay", &m_viewing ) ) {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text( "Tick %llu / %llu, keyframe every %d ticks", ( unsigned long long ) m_view_tick,
+    ( unsigned long long ) m_view_replay.size(), m_view_replay.keyframe_interval() );
+
+  ImGui::Text( "Score %d, lines %d, level %d", m_view_board.score(), m_view_board.lines_cleared(), m_view_board.level() );
+
+  // Scrubbing seeks on every change, each seek is a keyframe and less than an interval of ticks.
+  uint64_t tick = m_view_tick;
+  const uint64_t first_tick = 0;
+  const uint64_t last_tick = m_view_replay.size();
+
+  if( ImGui::SliderScalar( "Tick", ImGuiDataType_U64, &tick, &first_tick, &last_tick ) ) {
+    seek_replay( tick );
+  }
+
+  if( ImGui::Button( m_view_playing ? "Pause" : "Play" ) ) {
+    if( !m_view_playing && m_view_tick >= m_view_replay.size() ) {
+      seek_replay( 0 );
+    }
+
+    m_view_playing = !m_view_playing;
+  }
+
+  ImGui::SameLine();
+  if( ImGui::Button( "<" ) && m_view_tick > 0 ) {
+    m_view_playing = false;
+    seek_replay( m_view_tick - 1 );
+  }
+
+  ImGui::SameLine();
+  if( ImGui::Button( ">" ) ) {
+    m_view_playing = false;
+    m_view_tick = m_view_replay.play( m_view_board, m_view_tick, 1 );
+  }
+
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth( 120.F );
+  ImGui::SliderInt( "Speed", &m_view_speed, 1, 64, "%dx" );
+
+  ImGui::SetNextItemWidth( 160.F );
+  ImGui::InputScalar( "##jump", ImGuiDataType_U64, &m_view_jump );
+
+  ImGui::SameLine();
+  if( ImGui::Button( "Jump to tick" ) ) {
+    seek_replay( m_view_jump );
+  }
+
+  ImGui::SameLine();
+  if( ImGui::Button( "Close" ) ) {
+    m_viewing = false;
+  }
+
+  ImGui::End();
 }
 
 void game::Game::draw( const app::Application& app, const app::Window& window ) {
-  if( ImGui::IsKeyPressed( ImGuiKey_P ) ) {
-    m_paused = !m_paused;
+  if( ImGui::IsKeyPressed( ImGuiKey_V ) ) {
+    m_viewing = !m_viewing && open_replay();
+  }
+
+  if( !m_viewing ) {
+    if( ImGui::IsKeyPressed( ImGuiKey_P ) ) {
+      m_paused = !m_paused;
+    }
+
+    if( ImGui::IsKeyPressed( ImGuiKey_A ) ) {
+      m_autoplay = !m_autoplay;
+      m_autoplayer.reset();
+    }
   }
 
   ImDrawList* draw_list = ImGui::GetForegroundDrawList();
@@ -41,11 +226,20 @@ void game::Game::draw( const app::Application& app, const app::Window& window )
   const float window_center_y = ( window.height() / 2 );
 
   // Draw the board in the center of the window viewport.
-  m_board.draw(
-    window_center_x - ( m_board.width() / 2 ),
-    window_center_y - ( m_board.height() / 2 ) );
+  if( m_viewing ) {
+    m_view_board.draw(
+      window_center_x - ( m_view_board.width() / 2 ),
+      window_center_y - ( m_view_board.height() / 2 ) );
+
+    draw_replay_window();
+  }
+  else {
+    m_board.draw(
+      window_center_x - ( m_board.width() / 2 ),
+      window_center_y - ( m_board.height() / 2 ) );
+  }
 
-  if( m_paused ) {
+  if( m_paused && !m_viewing ) {
     const char* paused_str = "GAME PAUSED";
     const auto& paused_text_size = font->CalcTextSizeA( 32.F, 9999.F, 9999.F, paused_str );
 
@@ -53,7 +247,7 @@ void game::Game::draw( const app::Application& app, const app::Window& window )
     draw_list->AddText( { window_center_x - ( paused_text_size.x / 2.F ), window_center_y - ( paused_text_size.y / 2.F ) }, 0xFFFFFFFF, paused_str );
   }
 
-  if( m_board.is_game_over() ) {
+  if( m_board.is_game_over() && !m_viewing ) {
     const char* paused_str = "GAME OVER";
     const auto& paused_text_size = font->CalcTextSizeA( 32.F, 9999.F, 9999.F, paused_str );
 
@@ -63,7 +257,7 @@ void game::Game::draw( const app::Application& app, const app::Window& window )
 
   // Draw controls
   if( 1 ) {
-    const char* controls_str = "LEFT ARROW: Move Left\nRIGHT ARROW: Move Right\nR: Rotate\nS: Speed Up\nP: Pause";
+    const char* controls_str = "LEFT ARROW: Move Left\nRIGHT ARROW: Move Right\nR: Rotate\nS: Speed Up\nSPACE: Drop\nP: Pause\nA: Autoplay\nV: Watch Replay";
     draw_list->AddText( { 16.F, 96.F }, 0xFFFFFFFF, controls_str );
   }
 
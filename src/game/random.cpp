@@ -0,0 +1,170 @@
+#include <game/random.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+static uint32_t rotl( const uint32_t x, const int k ) {
+  return ( x << k ) | ( x >> ( 32 - k ) );
+}
+
+game::Random::Random( const uint64_t seed ) {
+  this->seed( seed );
+}
+
+void game::Random::seed( const uint64_t seed ) {
+  // https://prng.di.unimi.it/splitmix64.c
+  uint64_t x = seed;
+
+  for( int i{}; i < 4; i += 2 ) {
+    uint64_t z = ( x += 0x9E3779B97F4A7C15ull );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+    z = z ^ ( z >> 31 );
+
+    m_state[ i ] = ( uint32_t ) z;
+    m_state[ i + 1 ] = ( uint32_t ) ( z >> 32 );
+  }
+}
+
+uint32_t game::Random::next() {
+  // https://prng.di.unimi.it/xoshiro128starstar.c
+  const uint32_t result = rotl( m_state[ 1 ] * 5, 7 ) * 9;
+  const uint32_t t = m_state[ 1 ] << 9;
+
+  m_state[ 2 ] ^= m_state[ 0 ];
+  m_state[ 3 ] ^= m_state[ 1 ];
+  m_state[ 1 ] ^= m_state[ 2 ];
+  m_state[ 0 ] ^= m_state[ 3 ];
+
+  m_state[ 2 ] ^= t;
+
+  m_state[ 3 ] = rotl( m_state[ 3 ], 11 );
+
+  return result;
+}
+
+void game::Random::set_state( const uint32_t state[ 4 ] ) {
+  std::copy( state, state + 4, m_state );
+}
+
+uint32_t game::Random::next_below( const uint32_t bound ) {
+  // Lemire's multiply and shift, rejecting the few values that would bias the result.
+  //    https://arxiv.org/abs/1805.10941
+  uint64_t m = ( uint64_t ) next() * bound;
+  uint32_t low = ( uint32_t ) m;
+
+  if( low < bound ) {
+    const uint32_t threshold = ( 0u - bound ) % bound;
+
+    while( low < threshold ) {
+      m = ( uint64_t ) next() * bound;
+      low = ( uint32_t ) m;
+    }
+  }
+
+  return ( uint32_t ) ( m >> 32 );
+}
+
+game::PieceGenerator::PieceGenerator( const uint64_t seed, const RandomizerType type, const int preview_size ) :
+  m_type( type ),
+  m_preview_size( std::clamp( preview_size, 1, MAX_PREVIEW ) ) {
+  reset( seed );
+}
+
+void game::PieceGenerator::reset( const uint64_t seed ) {
+  m_seed = seed;
+  m_random.seed( seed );
+
+  // Zeroed even where the randomizer never uses them, snapshots copy the whole arrays.
+  std::fill( std::begin( m_bag ), std::end( m_bag ), 0 );
+  std::fill( std::begin( m_queue ), std::end( m_queue ), 0 );
+
+  m_bag_size = 0;
+  m_last = -1;
+
+  // Fill the queue ahead of time, it always holds preview_size entries.
+  m_queue_start = 0;
+  for( int i{}; i < m_preview_size; ++i ) {
+    m_queue[ i ] = ( uint8_t ) pick();
+  }
+}
+
+int game::PieceGenerator::pick() {
+  switch( m_type ) {
+    case randomizer_bag: {
+      if( m_bag_size == 0 ) {
+        for( size_t i{}; i < NUM_TETROMINO; ++i ) {
+          m_bag[ i ] = ( uint8_t ) i;
+        }
+
+        m_bag_size = NUM_TETROMINO;
+      }
+
+      // Draw a random tetromino out of the bag and fill its slot with the last one in the bag.
+      const int index = m_random.next_below( m_bag_size );
+      const int tetromino = m_bag[ index ];
+      m_bag[ index ] = m_bag[ --m_bag_size ];
+
+      return tetromino;
+    }
+
+    case randomizer_nes: {
+      int tetromino = m_random.next_below( NUM_TETROMINO + 1 );
+      if( tetromino == NUM_TETROMINO || tetromino == m_last ) {
+        tetromino = m_random.next_below( NUM_TETROMINO );
+      }
+
+      m_last = tetromino;
+      return tetromino;
+    }
+
+    case randomizer_uniform:
+    default:
+      return m_random.next_below( NUM_TETROMINO );
+  }
+}
+
+int game::PieceGenerator::next() {
+  const int tetromino = m_queue[ m_queue_start ];
+
+  // The slot just dealt becomes the back of the queue.
+  m_queue[ m_queue_start ] = ( uint8_t ) pick();
+  m_queue_start = ( m_queue_start + 1 ) % m_preview_size;
+
+  return tetromino;
+}
+
+int game::PieceGenerator::peek( const int n ) const {
+  const int index = std::clamp( n, 0, m_preview_size - 1 );
+  return m_queue[ ( m_queue_start + index ) % m_preview_size ];
+}
+
+static_assert( sizeof( game::GeneratorState::queue ) == game::PieceGenerator::MAX_PREVIEW );
+
+game::GeneratorState game::PieceGenerator::state() const {
+  GeneratorState state{};
+
+  std::copy( m_random.state(), m_random.state() + 4, state.random );
+  state.seed = m_seed;
+
+  std::copy( m_bag, m_bag + NUM_TETROMINO, state.bag );
+  state.bag_size = m_bag_size;
+  state.last = m_last;
+
+  std::copy( m_queue, m_queue + MAX_PREVIEW, state.queue );
+  state.queue_start = m_queue_start;
+
+  return state;
+}
+
+void game::PieceGenerator::restore( const GeneratorState& state ) {
+  m_random.set_state( state.random );
+  m_seed = state.seed;
+
+  std::copy( state.bag, state.bag + NUM_TETROMINO, m_bag );
+  m_bag_size = state.bag_size;
+  m_last = state.last;
+
+  std::copy( state.queue, state.queue + MAX_PREVIEW, m_queue );
+  m_queue_start = state.queue_start;
+}
\ No newline at end of file
@@ -0,0 +1,550 @@
+#include <game/replay.hpp>
+#include <game/bytes.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+// Size of everything before the inputs, see the layout in replay.hpp.
+static constexpr size_t HEADER_SIZE = 44;
+
+// Room for an hour of ticks up front, so recording doesn't reallocate in the middle of a game.
+static constexpr size_t RESERVE_TICKS = 60 * 60 * 60;
+
+game::Replay::Replay() :
+  m_seed( 0 ),
+  m_randomizer( randomizer_uniform ),
+  m_preview_size( 1 ),
+  m_finished( false ),
+  m_score( 0 ),
+  m_lines( 0 ),
+  m_hash( 0 ) {}
+
+void game::Replay::start( const Board& board ) {
+  m_seed = board.seed();
+  m_randomizer = board.randomizer();
+  m_preview_size = board.preview_size();
+
+  m_inputs.clear();
+  m_inputs.reserve( RESERVE_TICKS );
+
+  m_finished = false;
+  m_score = 0;
+  m_lines = 0;
+  m_hash = 0;
+}
+
+void game::Replay::finish( const Board& board ) {
+  m_finished = true;
+  m_score = board.score();
+  m_lines = board.lines_cleared();
+  m_hash = board.hash();
+}
+
+bool game::Replay::save( const char* path ) const {
+  std::vector< uint8_t > header;
+  header.reserve( HEADER_SIZE );
+
+  game::put_bytes( header, MAGIC, 4 );
+  game::put_bytes( header, VERSION, 4 );
+  game::put_bytes( header, m_seed, 8 );
+  game::put_bytes( header, ( uint64_t ) m_randomizer, 1 );
+  game::put_bytes( header, ( uint64_t ) m_preview_size, 1 );
+  game::put_bytes( header, 0, 2 );
+  game::put_bytes( header, m_inputs.size(), 8 );
+  game::put_bytes( header, ( uint32_t ) m_score, 4 );
+  game::put_bytes( header, ( uint32_t ) m_lines, 4 );
+  game::put_bytes( header, m_hash, 8 );
+
+  std::ofstream file( path, std::ios::binary | std::ios::trunc );
+  if( !file ) {
+    return false;
+  }
+
+  file.write( ( const char* ) header.data(), header.size() );
+  file.write( ( const char* ) m_inputs.data(), m_inputs.size() );
+
+  return ( bool ) file;
+}
+
+bool game::Replay::load( const char* path ) {
+  m_inputs.clear();
+  m_finished = false;
+
+  std::ifstream file( path, std::ios::binary );
+  if( !file ) {
+    return false;
+  }
+
+  const std::vector< uint8_t > data{ std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() };
+
+  if( data.size() < HEADER_SIZE ) {
+    return false;
+  }
+
+  const uint8_t* in = data.data();
+
+  const uint8_t* magic = in;
+  if( game::get_bytes( magic, 4 ) == SeekableReplay::MAGIC ) {
+    SeekableReplay seekable;
+    if( !seekable.open( data.data(), data.size() ) ) {
+      return false;
+    }
+
+    seekable.extract( *this );
+    return true;
+  }
+
+  if( game::get_bytes( in, 4 ) != MAGIC || game::get_bytes( in, 4 ) != VERSION ) {
+    return false;
+  }
+
+  const uint64_t seed = game::get_bytes( in, 8 );
+  const RandomizerType randomizer = ( RandomizerType ) game::get_bytes( in, 1 );
+  const int preview_size = ( int ) game::get_bytes( in, 1 );
+  game::get_bytes( in, 2 );
+
+  if( game::get_bytes( in, 8 ) != data.size() - HEADER_SIZE ) {
+    return false;
+  }
+
+  m_seed = seed;
+  m_randomizer = randomizer;
+  m_preview_size = preview_size;
+  m_score = ( int ) ( uint32_t ) game::get_bytes( in, 4 );
+  m_lines = ( int ) ( uint32_t ) game::get_bytes( in, 4 );
+  m_hash = game::get_bytes( in, 8 );
+  m_finished = true;
+
+  m_inputs.assign( data.begin() + HEADER_SIZE, data.end() );
+
+  return true;
+}
+
+//
+// Keyframes, see the layout in replay.hpp.
+//
+//    u64  tick the keyframe comes before
+//    u8   piece type, u8 rotation, i16 x, i16 y
+//    i32  rotate timer, i32 move timer, i32 gravity timer
+//    u8   first move, u8 hard drop held, u8 game over, u8 reserved
+//    u64  board ticks
+//    i32  level, i32 lines cleared, i32 score
+//    u32  random state x 4, u64 seed, u8 bag x 7, u8 bag size, i8 last, u8 queue x 7, u8 queue start
+//    reserved up to KEYFRAME_SIZE
+//    u8   block state of each cell, line by line
+//
+static void put_keyframe( std::vector< uint8_t >& out, const uint64_t tick, const game::BoardSnapshot& snapshot, const int width, const int height ) {
+  const size_t start = out.size();
+
+  game::put_bytes( out, tick, 8 );
+
+  game::put_bytes( out, snapshot.piece.type, 1 );
+  game::put_bytes( out, snapshot.piece.rotation, 1 );
+  game::put_bytes( out, ( uint16_t ) snapshot.piece.x, 2 );
+  game::put_bytes( out, ( uint16_t ) snapshot.piece.y, 2 );
+
+  game::put_bytes( out, ( uint32_t ) snapshot.rotate_timer, 4 );
+  game::put_bytes( out, ( uint32_t ) snapshot.move_timer, 4 );
+  game::put_bytes( out, ( uint32_t ) snapshot.gravity_timer, 4 );
+
+  game::put_bytes( out, snapshot.first_move, 1 );
+  game::put_bytes( out, snapshot.hard_drop_held, 1 );
+  game::put_bytes( out, snapshot.game_over, 1 );
+  game::put_bytes( out, 0, 1 );
+
+  game::put_bytes( out, snapshot.ticks, 8 );
+
+  game::put_bytes( out, ( uint32_t ) snapshot.level, 4 );
+  game::put_bytes( out, ( uint32_t ) snapshot.lines_cleared, 4 );
+  game::put_bytes( out, ( uint32_t ) snapshot.score, 4 );
+
+  const game::GeneratorState& generator = snapshot.generator;
+
+  for( const uint32_t word : generator.random ) {
+    game::put_bytes( out, word, 4 );
+  }
+
+  game::put_bytes( out, generator.seed, 8 );
+
+  for( const uint8_t tetromino : generator.bag ) {
+    game::put_bytes( out, tetromino, 1 );
+  }
+
+  game::put_bytes( out, ( uint8_t ) generator.bag_size, 1 );
+  game::put_bytes( out, ( uint8_t ) generator.last, 1 );
+
+  for( const uint8_t tetromino : generator.queue ) {
+    game::put_bytes( out, tetromino, 1 );
+  }
+
+  game::put_bytes( out, ( uint8_t ) generator.queue_start, 1 );
+
+  out.resize( start + game::SeekableReplay::KEYFRAME_SIZE );
+
+  for( int y{}; y < height; ++y ) {
+    out.insert( out.end(), snapshot.cells[ y ], snapshot.cells[ y ] + width );
+  }
+}
+
+// Returns false if anything read would be out of range for the board or the generator (the
+// file is corrupt), the snapshot is only safe to restore if it returns true.
+static bool get_keyframe( const uint8_t* in, game::BoardSnapshot& snapshot, const int width, const int height, const int preview_size ) {
+  const uint8_t* cells = in + game::SeekableReplay::KEYFRAME_SIZE;
+
+  // The tick is only there for tools reading the file.
+  game::get_bytes( in, 8 );
+
+  snapshot.piece.type = ( uint8_t ) game::get_bytes( in, 1 );
+  snapshot.piece.rotation = ( uint8_t ) game::get_bytes( in, 1 );
+  snapshot.piece.x = ( int16_t ) game::get_bytes( in, 2 );
+  snapshot.piece.y = ( int16_t ) game::get_bytes( in, 2 );
+
+  snapshot.rotate_timer = ( int32_t ) game::get_bytes( in, 4 );
+  snapshot.move_timer = ( int32_t ) game::get_bytes( in, 4 );
+  snapshot.gravity_timer = ( int32_t ) game::get_bytes( in, 4 );
+
+  snapshot.first_move = game::get_bytes( in, 1 ) != 0;
+  snapshot.hard_drop_held = game::get_bytes( in, 1 ) != 0;
+  snapshot.game_over = game::get_bytes( in, 1 ) != 0;
+  game::get_bytes( in, 1 );
+
+  snapshot.ticks = game::get_bytes( in, 8 );
+
+  snapshot.level = ( int32_t ) game::get_bytes( in, 4 );
+  snapshot.lines_cleared = ( int32_t ) game::get_bytes( in, 4 );
+  snapshot.score = ( int32_t ) game::get_bytes( in, 4 );
+
+  game::GeneratorState& generator = snapshot.generator;
+
+  for( uint32_t& word : generator.random ) {
+    word = ( uint32_t ) game::get_bytes( in, 4 );
+  }
+
+  generator.seed = game::get_bytes( in, 8 );
+
+  for( uint8_t& tetromino : generator.bag ) {
+    tetromino = ( uint8_t ) game::get_bytes( in, 1 );
+  }
+
+  generator.bag_size = ( int ) game::get_bytes( in, 1 );
+  generator.last = ( int8_t ) game::get_bytes( in, 1 );
+
+  for( uint8_t& tetromino : generator.queue ) {
+    tetromino = ( uint8_t ) game::get_bytes( in, 1 );
+  }
+
+  generator.queue_start = ( int ) game::get_bytes( in, 1 );
+
+  bool valid = game::valid_shape( snapshot.piece.type, snapshot.piece.rotation ) && snapshot.level >= 0;
+
+  // The tetromino has to be inside the board, bounded the same way collisions are (it can still
+  // overlap locked cells, the game is over then).
+  if( valid ) {
+    const game::ShapeRotation& rotation = snapshot.piece.shape();
+    const int x = snapshot.piece.x;
+    const int y = snapshot.piece.y;
+
+    valid = x + rotation.left >= 0 && x + rotation.width <= width && y + rotation.top >= 0 && y + rotation.height <= height;
+  }
+
+  valid &= generator.bag_size >= 0 && generator.bag_size <= ( int ) game::NUM_TETROMINO;
+  valid &= generator.last >= -1 && generator.last < ( int ) game::NUM_TETROMINO;
+  valid &= generator.queue_start >= 0 && generator.queue_start < preview_size;
+
+  for( int i{}; valid && i < generator.bag_size; ++i ) {
+    valid &= generator.bag[ i ] < game::NUM_TETROMINO;
+  }
+
+  for( int i{}; valid && i < preview_size; ++i ) {
+    valid &= generator.queue[ i ] < game::NUM_TETROMINO;
+  }
+
+  for( int y{}; y < height; ++y ) {
+    std::copy( cells + y * width, cells + ( y + 1 ) * width, snapshot.cells[ y ] );
+
+    for( int x{}; valid && x < width; ++x ) {
+      valid &= snapshot.cells[ y ][ x ] <= game::NUM_TETROMINO;
+    }
+  }
+
+  return valid;
+}
+
+game::SeekableReplay::SeekableReplay() :
+  m_data( nullptr ),
+  m_size( 0 ),
+  m_seed( 0 ),
+  m_randomizer( randomizer_uniform ),
+  m_preview_size( 1 ),
+  m_width( 0 ),
+  m_height( 0 ),
+  m_keyframe_interval( DEFAULT_KEYFRAME_INTERVAL ),
+  m_ticks( 0 ),
+  m_keyframes( 0 ),
+  m_index( nullptr ),
+  m_score( 0 ),
+  m_lines( 0 ),
+  m_hash( 0 ) {}
+
+bool game::SeekableReplay::write( const Replay& replay, const char* path, const int keyframe_interval ) {
+  const uint64_t interval = ( uint64_t ) std::max( 1, keyframe_interval );
+  const uint64_t keyframes = std::max< uint64_t >( 1, ( replay.size() + interval - 1 ) / interval );
+
+  ReplayPlayer player( replay );
+  const int width = player.board().rows();
+  const int height = player.board().columns();
+
+  std::vector< uint8_t > out;
+  std::vector< uint64_t > offsets;
+
+  out.reserve( HEADER_SIZE + keyframes * ( KEYFRAME_SIZE + width * height + 8 ) + replay.size() );
+  out.resize( HEADER_SIZE );
+
+  for( uint64_t keyframe{}; keyframe < keyframes; ++keyframe ) {
+    const uint64_t first = keyframe * interval;
+    const uint64_t last = std::min< uint64_t >( replay.size(), first + interval );
+
+    offsets.push_back( out.size() );
+    put_keyframe( out, first, player.board().snapshot(), width, height );
+
+    out.insert( out.end(), replay.inputs() + first, replay.inputs() + last );
+    player.run( last - first );
+  }
+
+  const uint64_t index_offset = out.size();
+  for( const uint64_t offset : offsets ) {
+    game::put_bytes( out, offset, 8 );
+  }
+
+  std::vector< uint8_t > header;
+  header.reserve( HEADER_SIZE );
+
+  game::put_bytes( header, MAGIC, 4 );
+  game::put_bytes( header, VERSION, 4 );
+  game::put_bytes( header, replay.seed(), 8 );
+  game::put_bytes( header, ( uint64_t ) replay.randomizer(), 1 );
+  game::put_bytes( header, ( uint64_t ) replay.preview_size(), 1 );
+  game::put_bytes( header, ( uint64_t ) width, 1 );
+  game::put_bytes( header, ( uint64_t ) height, 1 );
+  game::put_bytes( header, interval, 4 );
+  game::put_bytes( header, replay.size(), 8 );
+  game::put_bytes( header, keyframes, 8 );
+  game::put_bytes( header, index_offset, 8 );
+  game::put_bytes( header, ( uint32_t ) replay.score(), 4 );
+  game::put_bytes( header, ( uint32_t ) replay.lines(), 4 );
+  game::put_bytes( header, replay.hash(), 8 );
+
+  std::copy( header.begin(), header.end(), out.begin() );
+
+  std::ofstream file( path, std::ios::binary | std::ios::trunc );
+  if( !file ) {
+    return false;
+  }
+
+  file.write( ( const char* ) out.data(), out.size() );
+  return ( bool ) file;
+}
+
+bool game::SeekableReplay::open( const uint8_t* data, const size_t size ) {
+  m_data = nullptr;
+  m_size = 0;
+  m_ticks = 0;
+  m_keyframes = 0;
+
+  if( size < HEADER_SIZE ) {
+    return false;
+  }
+
+  const uint8_t* in = data;
+
+  if( game::get_bytes( in, 4 ) != MAGIC || game::get_bytes( in, 4 ) != VERSION ) {
+    return false;
+  }
+
+  m_seed = game::get_bytes( in, 8 );
+  m_randomizer = ( RandomizerType ) game::get_bytes( in, 1 );
+  m_preview_size = ( int ) game::get_bytes( in, 1 );
+  m_width = ( int ) game::get_bytes( in, 1 );
+  m_height = ( int ) game::get_bytes( in, 1 );
+  m_keyframe_interval = ( int ) game::get_bytes( in, 4 );
+
+  const uint64_t ticks = game::get_bytes( in, 8 );
+  const uint64_t keyframes = game::get_bytes( in, 8 );
+  const uint64_t index_offset = game::get_bytes( in, 8 );
+
+  m_score = ( int ) ( uint32_t ) game::get_bytes( in, 4 );
+  m_lines = ( int ) ( uint32_t ) game::get_bytes( in, 4 );
+  m_hash = game::get_bytes( in, 8 );
+
+  // Keyframes are only any use on a board of the same size.
+  const Board board = make_board();
+  if( m_width != board.rows() || m_height != board.columns() || m_keyframe_interval <= 0 ) {
+    return false;
+  }
+
+  const uint64_t interval = ( uint64_t ) m_keyframe_interval;
+  if( keyframes != std::max< uint64_t >( 1, ( ticks + interval - 1 ) / interval ) ) {
+    return false;
+  }
+
+  if( index_offset > size || ( size - index_offset ) / 8 < keyframes ) {
+    return false;
+  }
+
+  // Every chunk has to be inside the file and every keyframe safe to restore, checked once here
+  // so seeking never has to.
+  const uint64_t keyframe_size = KEYFRAME_SIZE + ( uint64_t ) m_width * m_height;
+
+  BoardSnapshot snapshot{};
+
+  for( uint64_t keyframe{}; keyframe < keyframes; ++keyframe ) {
+    const uint8_t* entry = data + index_offset + keyframe * 8;
+    const uint64_t offset = game::get_bytes( entry, 8 );
+    const uint64_t inputs = std::min( ticks - keyframe * interval, interval );
+
+    if( offset < HEADER_SIZE || offset > index_offset || index_offset - offset < keyframe_size + inputs ) {
+      return false;
+    }
+
+    if( !get_keyframe( data + offset, snapshot, m_width, m_height, board.preview_size() ) ) {
+      return false;
+    }
+  }
+
+  m_data = data;
+  m_size = size;
+  m_ticks = ticks;
+  m_keyframes = keyframes;
+  m_index = data + index_offset;
+
+  return true;
+}
+
+const uint8_t* game::SeekableReplay::chunk_inputs( const uint64_t tick ) const {
+  const uint64_t keyframe = std::min( tick / m_keyframe_interval, m_keyframes - 1 );
+
+  const uint8_t* entry = m_index + keyframe * 8;
+  return m_data + game::get_bytes( entry, 8 ) + KEYFRAME_SIZE + m_width * m_height;
+}
+
+void game::SeekableReplay::extract( Replay& replay ) const {
+  replay.m_seed = m_seed;
+  replay.m_randomizer = m_randomizer;
+  replay.m_preview_size = m_preview_size;
+
+  replay.m_inputs.resize( m_ticks );
+  for( uint64_t tick{}; tick < m_ticks; tick += m_keyframe_interval ) {
+    const uint64_t count = std::min< uint64_t >( m_keyframe_interval, m_ticks - tick );
+    std::copy( chunk_inputs( tick ), chunk_inputs( tick ) + count, replay.m_inputs.begin() + tick );
+  }
+
+  replay.m_finished = true;
+  replay.m_score = m_score;
+  replay.m_lines = m_lines;
+  replay.m_hash = m_hash;
+}
+
+game::Board game::SeekableReplay::make_board() const {
+  return Board{ m_seed, m_randomizer, m_preview_size };
+}
+
+void game::SeekableReplay::seek( Board& board, const uint64_t tick ) const {
+  const uint64_t target = std::min( tick, m_ticks );
+  const uint64_t keyframe = std::min( target / m_keyframe_interval, m_keyframes - 1 );
+
+  const uint8_t* entry = m_index + keyframe * 8;
+
+  BoardSnapshot snapshot{};
+  // Checked by open().
+  get_keyframe( m_data + game::get_bytes( entry, 8 ), snapshot, m_width, m_height, board.preview_size() );
+  board.restore( snapshot );
+
+  const uint64_t first = keyframe * m_keyframe_interval;
+  play( board, first, target - first );
+}
+
+const uint64_t game::SeekableReplay::play( Board& board, const uint64_t from, const uint64_t ticks ) const {
+  const uint64_t end = std::min( m_ticks, from + ticks );
+  uint64_t tick = from;
+
+  // A chunk at a time, within a chunk the inputs are contiguous.
+  while( tick < end ) {
+    const uint64_t chunk_end = std::min( end, ( tick / m_keyframe_interval + 1 ) * m_keyframe_interval );
+    const uint8_t* inputs = chunk_inputs( tick ) - ( tick / m_keyframe_interval ) * m_keyframe_interval;
+
+    while( tick < chunk_end ) {
+      const uint8_t input = inputs[ tick ];
+
+      uint64_t held = tick + 1;
+      while( held < chunk_end && inputs[ held ] == input ) {
+        ++held;
+      }
+
+      if( input & input_pause ) {
+        tick = held;
+        continue;
+      }
+
+      StepResult result;
+      tick += board.fast_forward( input, held - tick, result );
+    }
+  }
+
+  return tick;
+}
+
+game::ReplayPlayer::ReplayPlayer( const Replay& replay ) :
+  m_replay( replay ),
+  m_board( replay.seed(), replay.randomizer(), replay.preview_size() ),
+  m_tick( 0 ) {}
+
+void game::ReplayPlayer::restart() {
+  m_board.reset( m_replay.seed() );
+  m_tick = 0;
+}
+
+game::StepResult game::ReplayPlayer::step() {
+  if( is_finished() ) {
+    return {};
+  }
+
+  const uint8_t input = m_replay.input( m_tick++ );
+  if( input & input_pause ) {
+    return {};
+  }
+
+  return m_board.step( input );
+}
+
+const uint64_t game::ReplayPlayer::run( const uint64_t ticks ) {
+  const uint8_t* inputs = m_replay.inputs();
+  const size_t end = ( size_t ) std::min< uint64_t >( m_replay.size(), m_tick + ticks );
+  const size_t first = m_tick;
+
+  while( m_tick < end ) {
+    const uint8_t input = inputs[ m_tick ];
+
+    size_t held = m_tick + 1;
+    while( held < end && inputs[ held ] == input ) {
+      ++held;
+    }
+
+    if( input & input_pause ) {
+      m_tick = held;
+      continue;
+    }
+
+    StepResult result;
+    m_tick += ( size_t ) m_board.fast_forward( input, held - m_tick, result );
+  }
+
+  return m_tick - first;
+}
+
+const bool game::ReplayPlayer::matches() const {
+  return is_finished() && m_replay.is_finished() &&
+    m_board.score() == m_replay.score() &&
+    m_board.lines_cleared() == m_replay.lines() &&
+    m_board.hash() == m_replay.hash();
+}
\ No newline at end of file
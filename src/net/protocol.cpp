@@ -0,0 +1,146 @@
+#include <net/protocol.hpp>
+
+#include <game/bytes.hpp>
+
+// Size of each message type, 0 for unknown types.
+static size_t message_size( const uint8_t type ) {
+  switch( type ) {
+    case net::message_join: return 1 + 4 + 1;
+    case net::message_input: return 1 + 4 + 4 + 1 + 1;
+    case net::message_leave: return 1 + 4 + 1;
+    case net::message_welcome: return 1 + 4 + 4 + 8 + 1 + 1 + 1;
+    case net::message_state: return 1 + 4 + 1 + 4 + 1 + 1 + 1 + 4 + 2 + 1 + 1;
+    case net::message_result: return 1 + 4 + 1 + 4 + 4 + 2 + 1;
+    case net::message_full: return 1 + 4;
+    default: return 0;
+  }
+}
+
+size_t net::write_message( const Message& message, uint8_t* out ) {
+  uint8_t* start = out;
+
+  game::put_bytes( out, message.type, 1 );
+
+  switch( message.type ) {
+    case message_join:
+      game::put_bytes( out, message.tag, 4 );
+      game::put_bytes( out, message.mode, 1 );
+      break;
+
+    case message_input:
+      game::put_bytes( out, message.game, 4 );
+      game::put_bytes( out, message.sequence, 4 );
+      game::put_bytes( out, message.player, 1 );
+      game::put_bytes( out, message.input, 1 );
+      break;
+
+    case message_leave:
+      game::put_bytes( out, message.game, 4 );
+      game::put_bytes( out, message.player, 1 );
+      break;
+
+    case message_welcome:
+      game::put_bytes( out, message.tag, 4 );
+      game::put_bytes( out, message.game, 4 );
+      game::put_bytes( out, message.seed, 8 );
+      game::put_bytes( out, message.randomizer, 1 );
+      game::put_bytes( out, message.preview_size, 1 );
+      game::put_bytes( out, message.player, 1 );
+      break;
+
+    case message_state:
+      game::put_bytes( out, message.game, 4 );
+      game::put_bytes( out, message.player, 1 );
+      game::put_bytes( out, message.tick, 4 );
+      game::put_bytes( out, message.piece, 1 );
+      game::put_bytes( out, ( uint8_t ) message.x, 1 );
+      game::put_bytes( out, ( uint8_t ) message.y, 1 );
+      game::put_bytes( out, message.score, 4 );
+      game::put_bytes( out, message.lines, 2 );
+      game::put_bytes( out, message.level, 1 );
+      game::put_bytes( out, message.game_over, 1 );
+      break;
+
+    case message_result:
+      game::put_bytes( out, message.game, 4 );
+      game::put_bytes( out, message.player, 1 );
+      game::put_bytes( out, message.tick, 4 );
+      game::put_bytes( out, message.score, 4 );
+      game::put_bytes( out, message.lines, 2 );
+      game::put_bytes( out, message.won, 1 );
+      break;
+
+    case message_full:
+      game::put_bytes( out, message.tag, 4 );
+      break;
+  }
+
+  return out - start;
+}
+
+bool net::read_message( const uint8_t* data, const size_t size, Message& message ) {
+  if( size == 0 || size != message_size( data[ 0 ] ) ) {
+    return false;
+  }
+
+  const uint8_t* in = data;
+
+  message = {};
+  message.type = ( MessageType ) game::get_bytes( in, 1 );
+
+  switch( message.type ) {
+    case message_join:
+      message.tag = ( uint32_t ) game::get_bytes( in, 4 );
+      message.mode = ( uint8_t ) game::get_bytes( in, 1 );
+      return message.mode <= mode_versus;
+
+    case message_input:
+      message.game = ( uint32_t ) game::get_bytes( in, 4 );
+      message.sequence = ( uint32_t ) game::get_bytes( in, 4 );
+      message.player = ( uint8_t ) game::get_bytes( in, 1 );
+      message.input = ( uint8_t ) game::get_bytes( in, 1 );
+      return true;
+
+    case message_leave:
+      message.game = ( uint32_t ) game::get_bytes( in, 4 );
+      message.player = ( uint8_t ) game::get_bytes( in, 1 );
+      return true;
+
+    case message_welcome:
+      message.tag = ( uint32_t ) game::get_bytes( in, 4 );
+      message.game = ( uint32_t ) game::get_bytes( in, 4 );
+      message.seed = game::get_bytes( in, 8 );
+      message.randomizer = ( uint8_t ) game::get_bytes( in, 1 );
+      message.preview_size = ( uint8_t ) game::get_bytes( in, 1 );
+      message.player = ( uint8_t ) game::get_bytes( in, 1 );
+      return true;
+
+    case message_state:
+      message.game = ( uint32_t ) game::get_bytes( in, 4 );
+      message.player = ( uint8_t ) game::get_bytes( in, 1 );
+      message.tick = ( uint32_t ) game::get_bytes( in, 4 );
+      message.piece = ( uint8_t ) game::get_bytes( in, 1 );
+      message.x = ( int8_t ) game::get_bytes( in, 1 );
+      message.y = ( int8_t ) game::get_bytes( in, 1 );
+      message.score = ( uint32_t ) game::get_bytes( in, 4 );
+      message.lines = ( uint16_t ) game::get_bytes( in, 2 );
+      message.level = ( uint8_t ) game::get_bytes( in, 1 );
+      message.game_over = ( uint8_t ) game::get_bytes( in, 1 );
+      return true;
+
+    case message_result:
+      message.game = ( uint32_t ) game::get_bytes( in, 4 );
+      message.player = ( uint8_t ) game::get_bytes( in, 1 );
+      message.tick = ( uint32_t ) game::get_bytes( in, 4 );
+      message.score = ( uint32_t ) game::get_bytes( in, 4 );
+      message.lines = ( uint16_t ) game::get_bytes( in, 2 );
+      message.won = ( uint8_t ) game::get_bytes( in, 1 );
+      return true;
+
+    case message_full:
+      message.tag = ( uint32_t ) game::get_bytes( in, 4 );
+      return true;
+  }
+
+  return false;
+}
\ No newline at end of file
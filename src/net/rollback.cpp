@@ -0,0 +1,225 @@
+#include <net/rollback.hpp>
+
+#include <game/bytes.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+uint64_t net::RollbackSession::make_checksum( const game::Board boards[ 2 ] ) {
+  const uint64_t first = boards[ 0 ].hash() ^ ( uint64_t ) ( uint32_t ) boards[ 0 ].score() << 32;
+  const uint64_t second = boards[ 1 ].hash() ^ ( uint64_t ) ( uint32_t ) boards[ 1 ].score() << 32;
+
+  return first ^ ( second * 0x9E3779B97F4A7C15ull );
+}
+
+net::RollbackSession::RollbackSession( Transport& transport, const int local_player, const SessionSettings& settings ) :
+  m_transport( transport ),
+  m_settings( settings ),
+  m_local( local_player & 1 ),
+  m_boards{
+    game::Board{ settings.seed, settings.randomizer, settings.preview_size },
+    game::Board{ settings.seed, settings.randomizer, settings.preview_size } },
+  m_tick( 0 ),
+  m_local_result{},
+  m_acked( 0 ),
+  m_rollback_from( UINT64_MAX ),
+  m_compared( 0 ),
+  m_stats{} {
+  m_settings.max_rollback = std::max( 1, m_settings.max_rollback );
+  m_settings.max_batch = std::clamp( m_settings.max_batch, 1, 255 );
+
+  m_snapshots.resize( m_settings.max_rollback + 1 );
+}
+
+uint8_t net::RollbackSession::remote_input( const uint64_t tick ) const {
+  const std::vector< uint8_t >& inputs = m_inputs[ remote() ];
+
+  if( tick < inputs.size() ) {
+    return inputs[ tick ];
+  }
+
+  return inputs.empty() ? ( uint8_t ) game::input_none : inputs.back();
+}
+
+void net::RollbackSession::simulate( const uint64_t tick ) {
+  Snapshot& snapshot = m_snapshots[ tick % m_snapshots.size() ];
+  snapshot.boards[ 0 ] = m_boards[ 0 ];
+  snapshot.boards[ 1 ] = m_boards[ 1 ];
+
+  const uint8_t input = remote_input( tick );
+
+  if( tick < m_remote_used.size() ) {
+    m_remote_used[ tick ] = input;
+  }
+  else {
+    m_remote_used.push_back( input );
+  }
+
+  m_local_result = m_boards[ m_local ].step( m_inputs[ m_local ][ tick ] );
+  m_boards[ remote() ].step( input );
+}
+
+void net::RollbackSession::receive( const uint8_t* data, const size_t size ) {
+  if( size < HEADER_SIZE ) {
+    return;
+  }
+
+  const uint8_t* in = data;
+
+  if( game::get_bytes( in, 2 ) != MAGIC ) {
+    return;
+  }
+
+  const uint64_t acked = game::get_bytes( in, 4 );
+  const uint64_t start = game::get_bytes( in, 4 );
+  const size_t count = ( size_t ) game::get_bytes( in, 1 );
+  const uint64_t checksum_tick = game::get_bytes( in, 4 );
+  const uint64_t checksum = game::get_bytes( in, 8 );
+
+  if( size < HEADER_SIZE + count ) {
+    return;
+  }
+
+  ++m_stats.datagrams_received;
+
+  m_acked = std::clamp< uint64_t >( acked, m_acked, m_inputs[ m_local ].size() );
+
+  //
+  // New inputs carry on from the last one confirmed, anything before it has been seen already
+  // and anything after a gap can't be used yet (it's sent again until acknowledged).
+  //
+  std::vector< uint8_t >& inputs = m_inputs[ remote() ];
+
+  for( size_t i{}; i < count; ++i ) {
+    const uint64_t tick = start + i;
+    const uint8_t input = in[ i ];
+
+    if( tick < inputs.size() ) {
+      continue;
+    }
+
+    if( tick > inputs.size() ) {
+      break;
+    }
+
+    if( tick < m_tick && m_remote_used[ tick ] != input ) {
+      ++m_stats.mispredictions;
+      m_rollback_from = std::min( m_rollback_from, tick );
+    }
+
+    inputs.push_back( input );
+  }
+
+  // Checksums are only compared once, for ticks this side has confirmed as well.
+  if( checksum_tick != NO_CHECKSUM && checksum_tick >= m_compared && checksum_tick < m_checksums.size() ) {
+    m_stats.desyncs += m_checksums[ checksum_tick ] != checksum ? 1 : 0;
+    m_compared = checksum_tick + 1;
+  }
+}
+
+void net::RollbackSession::rollback() {
+  if( m_rollback_from >= m_tick ) {
+    m_rollback_from = UINT64_MAX;
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  const uint64_t from = m_rollback_from;
+  const Snapshot& snapshot = m_snapshots[ from % m_snapshots.size() ];
+
+  m_boards[ 0 ] = snapshot.boards[ 0 ];
+  m_boards[ 1 ] = snapshot.boards[ 1 ];
+
+  for( uint64_t tick = from; tick < m_tick; ++tick ) {
+    simulate( tick );
+  }
+
+  const uint64_t depth = m_tick - from;
+
+  ++m_stats.rollbacks;
+  m_stats.rollback_ticks += depth;
+  m_stats.max_rollback_depth = std::max( m_stats.max_rollback_depth, depth );
+  m_stats.resimulate_seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  m_rollback_from = UINT64_MAX;
+}
+
+void net::RollbackSession::confirm_checksums() {
+  const uint64_t confirmed = std::min< uint64_t >( m_inputs[ remote() ].size(), m_tick );
+
+  while( m_checksums.size() < confirmed ) {
+    // The boards after tick t are the current ones or the snapshot taken before tick t + 1.
+    const uint64_t next = m_checksums.size() + 1;
+    const game::Board* boards = next == m_tick ? m_boards : m_snapshots[ next % m_snapshots.size() ].boards;
+
+    m_checksums.push_back( make_checksum( boards ) );
+  }
+}
+
+void net::RollbackSession::send_inputs() {
+  const std::vector< uint8_t >& inputs = m_inputs[ m_local ];
+
+  const uint64_t start = m_acked;
+  const size_t count = ( size_t ) std::min< uint64_t >( inputs.size() - start, m_settings.max_batch );
+
+  uint8_t datagram[ HEADER_SIZE + 255 ];
+  uint8_t* out = datagram;
+
+  game::put_bytes( out, MAGIC, 2 );
+  game::put_bytes( out, m_inputs[ remote() ].size(), 4 );
+  game::put_bytes( out, start, 4 );
+  game::put_bytes( out, count, 1 );
+
+  if( m_checksums.empty() ) {
+    game::put_bytes( out, NO_CHECKSUM, 4 );
+    game::put_bytes( out, 0, 8 );
+  }
+  else {
+    game::put_bytes( out, m_checksums.size() - 1, 4 );
+    game::put_bytes( out, m_checksums.back(), 8 );
+  }
+
+  std::copy( inputs.begin() + start, inputs.begin() + start + count, out );
+  out += count;
+
+  m_transport.send( datagram, out - datagram );
+
+  ++m_stats.datagrams_sent;
+  m_stats.bytes_sent += out - datagram;
+}
+
+void net::RollbackSession::poll() {
+  uint8_t datagram[ MAX_DATAGRAM ];
+
+  for( ;; ) {
+    const size_t size = m_transport.receive( datagram, sizeof( datagram ) );
+    if( size == 0 ) {
+      break;
+    }
+
+    receive( datagram, size );
+  }
+
+  rollback();
+  confirm_checksums();
+}
+
+bool net::RollbackSession::advance( const uint8_t input ) {
+  if( m_tick >= m_inputs[ remote() ].size() + m_settings.max_rollback ) {
+    ++m_stats.stalls;
+    send_inputs();
+    return false;
+  }
+
+  m_inputs[ m_local ].push_back( input );
+
+  simulate( m_tick );
+  ++m_tick;
+  ++m_stats.ticks;
+
+  confirm_checksums();
+  send_inputs();
+
+  return true;
+}
\ No newline at end of file
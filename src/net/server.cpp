@@ -0,0 +1,1027 @@
+#include <net/server.hpp>
+
+#include <game/board.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+static constexpr long TICK_NANOSECONDS = 1000000000 / 60;
+
+// Datagrams read or sent per system call.
+static constexpr int BATCH = 64;
+
+// Bytes a TCP client can fall behind by before it's dropped.
+static constexpr size_t MAX_BUFFERED = 64 * 1024;
+
+static constexpr uint32_t NO_GAME = UINT32_MAX;
+
+// What an epoll event is for, connections keep their slot in the bits above.
+enum EventSource : uint64_t {
+  source_timer,
+  source_udp,
+  source_listener,
+  source_connection,
+};
+
+static double seconds_now() {
+  return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//
+// Sockets.
+//
+static int open_socket( const int type, const uint16_t port ) {
+  const int fd = socket( AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+  if( fd < 0 ) {
+    return -1;
+  }
+
+  // Every shard binds the same port, the kernel spreads clients over them.
+  const int one = 1;
+  setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+  setsockopt( fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof( one ) );
+
+  if( type == SOCK_DGRAM ) {
+    // Room for a burst of joins.
+    const int buffer = 4 << 20;
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof( buffer ) );
+    setsockopt( fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof( buffer ) );
+  }
+
+  sockaddr_in local{};
+  local.sin_family = AF_INET;
+  local.sin_port = htons( port );
+  local.sin_addr.s_addr = htonl( INADDR_ANY );
+
+  if( bind( fd, ( const sockaddr* ) &local, sizeof( local ) ) != 0 || ( type == SOCK_STREAM && listen( fd, 1024 ) != 0 ) ) {
+    close( fd );
+    return -1;
+  }
+
+  return fd;
+}
+
+//
+// A shard, everything here is only touched by the shard's own thread apart from the counters.
+//
+struct net::MatchServer::Shard {
+  // Where to send a player's messages.
+  struct Route {
+    // Connection slot, or -1 for the UDP address.
+    int connection;
+    sockaddr_in address;
+
+    const bool operator==( const Route& other ) const {
+      if( connection != other.connection ) {
+        return false;
+      }
+
+      return connection >= 0 || ( address.sin_port == other.address.sin_port && address.sin_addr.s_addr == other.address.sin_addr.s_addr );
+    }
+  };
+
+  struct Player {
+    Route route;
+    uint8_t input;
+    uint32_t sequence;
+    double heard;
+
+    // Index into its connection's games, TCP only.
+    int listed;
+  };
+
+  struct Match {
+    game::Board boards[ 2 ];
+    Player players[ 2 ];
+
+    // 0 while the slot is free.
+    int player_count;
+    uint8_t mode;
+    uint8_t generation;
+
+    // Index into the running list, -1 while waiting for an opponent.
+    int running;
+  };
+
+  struct Connection {
+    // -1 while the slot is free.
+    int fd;
+
+    std::vector< uint8_t > in;
+    std::vector< uint8_t > out;
+
+    // Games the connection's players are in, once for each player.
+    std::vector< uint32_t > games;
+
+    bool writing;
+    bool closing;
+    bool dirty;
+  };
+
+  struct Counters {
+    std::atomic< uint64_t > games;
+    std::atomic< uint64_t > players;
+    std::atomic< uint64_t > ticks;
+    std::atomic< uint64_t > game_ticks;
+    std::atomic< uint64_t > dropped_ticks;
+    std::atomic< uint64_t > tick_nanoseconds;
+    std::atomic< uint64_t > busy_nanoseconds;
+    std::atomic< uint64_t > games_started;
+    std::atomic< uint64_t > games_finished;
+    std::atomic< uint64_t > connections;
+    std::atomic< uint64_t > messages_received;
+    std::atomic< uint64_t > messages_sent;
+  };
+
+  const ServerSettings& settings;
+  const int index;
+
+  int epoll_fd;
+  int timer_fd;
+  int udp_fd;
+  int listener_fd;
+
+  std::vector< Match > matches;
+  std::vector< uint32_t > free_matches;
+
+  // Slots of the running matches, stepped every tick.
+  std::vector< uint32_t > running;
+
+  // A versus match waiting for its second player.
+  uint32_t waiting;
+
+  std::vector< Connection > connections;
+  std::vector< int > free_connections;
+  std::vector< int > dirty_connections;
+
+  // Datagrams waiting for the next sendmmsg.
+  uint8_t send_data[ BATCH ][ MAX_MESSAGE ];
+  sockaddr_in send_addresses[ BATCH ];
+  iovec send_vectors[ BATCH ];
+  mmsghdr send_headers[ BATCH ];
+  int send_count;
+
+  uint64_t tick;
+  double now;
+  game::Random random;
+
+  uint64_t player_count;
+  Counters counters;
+
+  Shard( const ServerSettings& settings, const int index ) :
+    settings( settings ),
+    index( index ),
+    epoll_fd( -1 ),
+    timer_fd( -1 ),
+    udp_fd( -1 ),
+    listener_fd( -1 ),
+    waiting( NO_GAME ),
+    send_count( 0 ),
+    tick( 0 ),
+    now( seconds_now() ),
+    random( ( uint64_t ) std::chrono::steady_clock::now().time_since_epoch().count() ^ ( ( uint64_t ) index << 56 ) ),
+    player_count( 0 ),
+    counters{} {}
+
+  ~Shard() {
+    for( Connection& connection : connections ) {
+      if( connection.fd >= 0 ) {
+        close( connection.fd );
+      }
+    }
+
+    for( const int fd : { epoll_fd, timer_fd, udp_fd, listener_fd } ) {
+      if( fd >= 0 ) {
+        close( fd );
+      }
+    }
+  }
+
+  bool open() {
+    epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+    timer_fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+    udp_fd = open_socket( SOCK_DGRAM, settings.port );
+    listener_fd = open_socket( SOCK_STREAM, settings.port );
+
+    if( epoll_fd < 0 || timer_fd < 0 || udp_fd < 0 || listener_fd < 0 ) {
+      return false;
+    }
+
+    const itimerspec interval{ { 0, TICK_NANOSECONDS }, { 0, TICK_NANOSECONDS } };
+    timerfd_settime( timer_fd, 0, &interval, nullptr );
+
+    watch( timer_fd, EPOLLIN, source_timer );
+    watch( udp_fd, EPOLLIN, source_udp );
+    watch( listener_fd, EPOLLIN, source_listener );
+
+    for( int i{}; i < BATCH; ++i ) {
+      send_vectors[ i ] = { send_data[ i ], 0 };
+    }
+
+    return true;
+  }
+
+  void watch( const int fd, const uint32_t events, const uint64_t source ) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = source;
+    epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &event );
+  }
+
+  //
+  // Sending, datagrams are batched and connections buffered until flush().
+  //
+  void flush_datagrams() {
+    int sent = 0;
+
+    while( sent < send_count ) {
+      const int count = sendmmsg( udp_fd, send_headers + sent, send_count - sent, MSG_DONTWAIT );
+
+      // A full socket buffer loses the rest, like any datagram.
+      if( count <= 0 ) {
+        break;
+      }
+
+      sent += count;
+    }
+
+    send_count = 0;
+  }
+
+  void write_connection( const int slot ) {
+    Connection& connection = connections[ slot ];
+
+    size_t written = 0;
+
+    while( written < connection.out.size() ) {
+      const ssize_t count = ::send( connection.fd, connection.out.data() + written, connection.out.size() - written, MSG_NOSIGNAL | MSG_DONTWAIT );
+
+      if( count <= 0 ) {
+        if( count < 0 && errno != EAGAIN && errno != EWOULDBLOCK ) {
+          connection.closing = true;
+        }
+
+        break;
+      }
+
+      written += count;
+    }
+
+    connection.out.erase( connection.out.begin(), connection.out.begin() + written );
+
+    // Only wait for the socket to drain while there's something left to write.
+    const bool writing = !connection.out.empty() && !connection.closing;
+
+    if( writing != connection.writing ) {
+      epoll_event event{};
+      event.events = ( uint32_t ) EPOLLIN | ( writing ? ( uint32_t ) EPOLLOUT : 0u );
+      event.data.u64 = source_connection | ( uint64_t ) slot << 8;
+      epoll_ctl( epoll_fd, EPOLL_CTL_MOD, connection.fd, &event );
+
+      connection.writing = writing;
+    }
+  }
+
+  void flush() {
+    flush_datagrams();
+
+    // Closing a connection can finish games that send to others, so go until nothing is left.
+    while( !dirty_connections.empty() ) {
+      const int slot = dirty_connections.back();
+      dirty_connections.pop_back();
+
+      Connection& connection = connections[ slot ];
+      connection.dirty = false;
+
+      if( connection.fd < 0 ) {
+        continue;
+      }
+
+      if( !connection.closing ) {
+        write_connection( slot );
+      }
+
+      if( connection.closing ) {
+        close_connection( slot );
+      }
+    }
+
+    flush_datagrams();
+  }
+
+  void mark_dirty( const int slot ) {
+    if( !connections[ slot ].dirty ) {
+      connections[ slot ].dirty = true;
+      dirty_connections.push_back( slot );
+    }
+  }
+
+  void send( const Route& route, const Message& message ) {
+    counters.messages_sent.fetch_add( 1, std::memory_order_relaxed );
+
+    if( route.connection < 0 ) {
+      const int i = send_count++;
+
+      send_addresses[ i ] = route.address;
+      send_vectors[ i ].iov_len = write_message( message, send_data[ i ] );
+
+      send_headers[ i ] = {};
+      send_headers[ i ].msg_hdr.msg_name = &send_addresses[ i ];
+      send_headers[ i ].msg_hdr.msg_namelen = sizeof( sockaddr_in );
+      send_headers[ i ].msg_hdr.msg_iov = &send_vectors[ i ];
+      send_headers[ i ].msg_hdr.msg_iovlen = 1;
+
+      if( send_count == BATCH ) {
+        flush_datagrams();
+      }
+
+      return;
+    }
+
+    Connection& connection = connections[ route.connection ];
+
+    if( connection.fd < 0 || connection.closing ) {
+      return;
+    }
+
+    uint8_t data[ 2 + MAX_MESSAGE ];
+    const size_t size = write_message( message, data + 2 );
+    data[ 0 ] = ( uint8_t ) size;
+    data[ 1 ] = ( uint8_t ) ( size >> 8 );
+
+    connection.out.insert( connection.out.end(), data, data + 2 + size );
+
+    // Rather than buffer without end for a client that isn't reading.
+    if( connection.out.size() > MAX_BUFFERED ) {
+      connection.closing = true;
+    }
+
+    mark_dirty( route.connection );
+  }
+
+  //
+  // Matches.
+  //
+  Match* find( const uint32_t id ) {
+    const uint32_t slot = id & 0xFFFF;
+
+    if( ( int ) ( id >> 24 ) != index || slot >= matches.size() ) {
+      return nullptr;
+    }
+
+    Match& match = matches[ slot ];
+
+    if( match.player_count == 0 || match.generation != ( uint8_t ) ( id >> 16 ) ) {
+      return nullptr;
+    }
+
+    return &match;
+  }
+
+  const uint32_t match_id( const uint32_t slot ) const {
+    return ( uint32_t ) index << 24 | ( uint32_t ) matches[ slot ].generation << 16 | slot;
+  }
+
+  // Returns the slot of a new match, or NO_GAME if the shard is full.
+  uint32_t allocate( const uint8_t mode ) {
+    uint32_t slot;
+
+    if( !free_matches.empty() ) {
+      slot = free_matches.back();
+      free_matches.pop_back();
+    }
+    else if( matches.size() < ( size_t ) settings.max_games ) {
+      slot = ( uint32_t ) matches.size();
+      matches.emplace_back();
+      matches.back().generation = 0;
+    }
+    else {
+      return NO_GAME;
+    }
+
+    Match& match = matches[ slot ];
+    match.mode = mode;
+    match.player_count = 0;
+    match.running = -1;
+
+    const uint64_t seed = ( uint64_t ) random.next() << 32 | random.next();
+
+    for( game::Board& board : match.boards ) {
+      board = game::Board{ seed, settings.randomizer, settings.preview_size };
+    }
+
+    counters.games.fetch_add( 1, std::memory_order_relaxed );
+
+    return slot;
+  }
+
+  // Takes a player's entry out of its connection's games, swapping the last entry into its place.
+  void unlist( const uint32_t slot, const int player ) {
+    const int connection = matches[ slot ].players[ player ].route.connection;
+    const int listed = matches[ slot ].players[ player ].listed;
+
+    if( connection < 0 ) {
+      return;
+    }
+
+    std::vector< uint32_t >& games = connections[ connection ].games;
+
+    // Already gone if the connection is closing.
+    if( ( size_t ) listed >= games.size() || games[ listed ] != match_id( slot ) ) {
+      return;
+    }
+
+    const int last = ( int ) games.size() - 1;
+    games[ listed ] = games[ last ];
+    games.pop_back();
+
+    if( listed == last ) {
+      return;
+    }
+
+    // Both players of a match can be on the same connection, the one moved is the one listed last.
+    Match* moved = find( games[ listed ] );
+
+    for( int other{}; moved != nullptr && other < moved->player_count; ++other ) {
+      if( moved->players[ other ].route.connection == connection && moved->players[ other ].listed == last ) {
+        moved->players[ other ].listed = listed;
+      }
+    }
+  }
+
+  void release( const uint32_t slot ) {
+    Match& match = matches[ slot ];
+
+    for( int player{}; player < match.player_count; ++player ) {
+      unlist( slot, player );
+    }
+
+    // Swap the last running match into this one's place.
+    if( match.running >= 0 ) {
+      const uint32_t last = running.back();
+      running[ match.running ] = last;
+      matches[ last ].running = match.running;
+      running.pop_back();
+    }
+
+    if( waiting == slot ) {
+      waiting = NO_GAME;
+    }
+
+    player_count -= match.player_count;
+
+    match.player_count = 0;
+    match.running = -1;
+    ++match.generation;
+
+    free_matches.push_back( slot );
+
+    counters.games.fetch_sub( 1, std::memory_order_relaxed );
+    counters.games_finished.fetch_add( 1, std::memory_order_relaxed );
+  }
+
+  void start( const uint32_t slot ) {
+    matches[ slot ].running = ( int ) running.size();
+    running.push_back( slot );
+
+    counters.games_started.fetch_add( 1, std::memory_order_relaxed );
+  }
+
+  void welcome( const uint32_t slot, const int player, const uint32_t tag ) {
+    const Match& match = matches[ slot ];
+
+    Message message{};
+    message.type = message_welcome;
+    message.tag = tag;
+    message.game = match_id( slot );
+    message.seed = match.boards[ 0 ].seed();
+    message.randomizer = ( uint8_t ) settings.randomizer;
+    message.preview_size = ( uint8_t ) settings.preview_size;
+    message.player = ( uint8_t ) player;
+
+    send( match.players[ player ].route, message );
+  }
+
+  void send_state( const uint32_t slot ) {
+    const Match& match = matches[ slot ];
+
+    // Every player sees every board.
+    for( int board{}; board < match.player_count; ++board ) {
+      const game::Board& state = match.boards[ board ];
+
+      Message message{};
+      message.type = message_state;
+      message.game = match_id( slot );
+      message.player = ( uint8_t ) board;
+      message.tick = ( uint32_t ) state.ticks();
+      message.piece = ( uint8_t ) ( state.tetromino() << 4 | state.rotation() );
+      message.x = ( int8_t ) state.position_x();
+      message.y = ( int8_t ) state.position_y();
+      message.score = ( uint32_t ) state.score();
+      message.lines = ( uint16_t ) state.lines_cleared();
+      message.level = ( uint8_t ) state.level();
+      message.game_over = state.is_game_over() ? 1 : 0;
+
+      for( int player{}; player < match.player_count; ++player ) {
+        send( match.players[ player ].route, message );
+      }
+    }
+  }
+
+  // Ends a match, loser is the player who lost a versus match, -1 for a draw or marathon.
+  void finish( const uint32_t slot, const int loser ) {
+    const Match& match = matches[ slot ];
+
+    for( int player{}; player < match.player_count; ++player ) {
+      const game::Board& board = match.boards[ player ];
+
+      Message message{};
+      message.type = message_result;
+      message.game = match_id( slot );
+      message.player = ( uint8_t ) player;
+      message.tick = ( uint32_t ) board.ticks();
+      message.score = ( uint32_t ) board.score();
+      message.lines = ( uint16_t ) board.lines_cleared();
+      message.won = match.mode == mode_versus && match.player_count == 2 && loser >= 0 && loser != player ? 1 : 0;
+
+      for( int to{}; to < match.player_count; ++to ) {
+        send( match.players[ to ].route, message );
+      }
+    }
+
+    release( slot );
+  }
+
+  void join( const Route& route, const Message& message ) {
+    uint32_t slot = NO_GAME;
+    int player = 0;
+
+    if( message.mode == mode_versus && waiting != NO_GAME ) {
+      slot = waiting;
+      player = 1;
+      waiting = NO_GAME;
+    }
+    else {
+      slot = allocate( message.mode );
+    }
+
+    if( slot == NO_GAME ) {
+      Message full{};
+      full.type = message_full;
+      full.tag = message.tag;
+      send( route, full );
+      return;
+    }
+
+    Match& match = matches[ slot ];
+    match.players[ player ] = { route, game::input_none, 0, now, -1 };
+    match.player_count = player + 1;
+    ++player_count;
+
+    if( route.connection >= 0 ) {
+      std::vector< uint32_t >& games = connections[ route.connection ].games;
+
+      match.players[ player ].listed = ( int ) games.size();
+      games.push_back( match_id( slot ) );
+    }
+
+    welcome( slot, player, message.tag );
+
+    if( message.mode == mode_versus && player == 0 ) {
+      waiting = slot;
+    }
+    else {
+      start( slot );
+    }
+  }
+
+  // A player leaves a match, if they're in it and it's them asking (both players of a versus
+  // match can share a route).
+  void leave( const uint32_t id, const Route& route, const int player ) {
+    Match* match = find( id );
+    if( match == nullptr || player >= match->player_count || !( match->players[ player ].route == route ) ) {
+      return;
+    }
+
+    finish( id & 0xFFFF, match->player_count == 2 ? player : -1 );
+  }
+
+  void receive( const Route& route, const Message& message ) {
+    counters.messages_received.fetch_add( 1, std::memory_order_relaxed );
+
+    switch( message.type ) {
+      case message_join:
+        join( route, message );
+        break;
+
+      case message_input: {
+        Match* match = find( message.game );
+        if( match == nullptr ) {
+          break;
+        }
+
+        if( message.player >= match->player_count ) {
+          break;
+        }
+
+        Player& state = match->players[ message.player ];
+
+        if( !( state.route == route ) ) {
+          break;
+        }
+
+        // Anything heard keeps the player alive, only newer inputs replace the one held.
+        state.heard = now;
+
+        if( message.sequence > state.sequence ) {
+          state.sequence = message.sequence;
+          state.input = message.input & ~game::input_pause;
+        }
+
+        break;
+      }
+
+      case message_leave:
+        leave( message.game, route, message.player );
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  //
+  // Ticks.
+  //
+  void step() {
+    const auto start = std::chrono::steady_clock::now();
+
+    const uint64_t interval = ( uint64_t ) std::max( 1, settings.state_interval );
+
+    // Backwards, so a finished match has the last one (already stepped) swapped into its place.
+    for( size_t i = running.size(); i-- > 0; ) {
+      const uint32_t slot = running[ i ];
+      Match& match = matches[ slot ];
+
+      int over = 0;
+
+      for( int player{}; player < match.player_count; ++player ) {
+        match.boards[ player ].step( match.players[ player ].input );
+        over += match.boards[ player ].is_game_over() ? 1 << player : 0;
+      }
+
+      if( over != 0 ) {
+        // In versus the one who topped out loses, both at once is a draw.
+        finish( slot, over == 1 ? 0 : over == 2 ? 1 : -1 );
+      }
+      else if( ( tick + slot ) % interval == 0 ) {
+        send_state( slot );
+      }
+    }
+
+    counters.game_ticks.fetch_add( running.size(), std::memory_order_relaxed );
+
+    ++tick;
+
+    // Once a second, drop the players that have gone quiet.
+    if( tick % 60 == 0 ) {
+      expire();
+    }
+
+    counters.ticks.fetch_add( 1, std::memory_order_relaxed );
+    counters.tick_nanoseconds.fetch_add( ( uint64_t ) std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count(),
+      std::memory_order_relaxed );
+  }
+
+  void expire() {
+    const double cutoff = now - settings.timeout;
+
+    for( uint32_t slot{}; slot < matches.size(); ++slot ) {
+      Match& match = matches[ slot ];
+
+      for( int player{}; player < match.player_count; ++player ) {
+        if( match.players[ player ].heard < cutoff ) {
+          finish( slot, match.player_count == 2 ? player : -1 );
+          break;
+        }
+      }
+    }
+  }
+
+  void on_timer() {
+    uint64_t expirations = 0;
+    if( read( timer_fd, &expirations, sizeof( expirations ) ) != sizeof( expirations ) ) {
+      return;
+    }
+
+    const uint64_t ticks = std::min< uint64_t >( expirations, ( uint64_t ) std::max( 1, settings.max_catch_up ) );
+
+    counters.dropped_ticks.fetch_add( expirations - ticks, std::memory_order_relaxed );
+
+    for( uint64_t i{}; i < ticks; ++i ) {
+      step();
+    }
+  }
+
+  //
+  // Receiving.
+  //
+  void on_datagrams() {
+    uint8_t data[ BATCH ][ MAX_MESSAGE + 1 ];
+    sockaddr_in addresses[ BATCH ];
+    iovec vectors[ BATCH ];
+    mmsghdr headers[ BATCH ];
+
+    for( ;; ) {
+      for( int i{}; i < BATCH; ++i ) {
+        vectors[ i ] = { data[ i ], sizeof( data[ i ] ) };
+
+        headers[ i ] = {};
+        headers[ i ].msg_hdr.msg_name = &addresses[ i ];
+        headers[ i ].msg_hdr.msg_namelen = sizeof( sockaddr_in );
+        headers[ i ].msg_hdr.msg_iov = &vectors[ i ];
+        headers[ i ].msg_hdr.msg_iovlen = 1;
+      }
+
+      const int count = recvmmsg( udp_fd, headers, BATCH, MSG_DONTWAIT, nullptr );
+      if( count <= 0 ) {
+        break;
+      }
+
+      for( int i{}; i < count; ++i ) {
+        Message message;
+        if( !read_message( data[ i ], headers[ i ].msg_len, message ) ) {
+          continue;
+        }
+
+        Route route{};
+        route.connection = -1;
+        route.address = addresses[ i ];
+
+        receive( route, message );
+      }
+
+      if( count < BATCH ) {
+        break;
+      }
+    }
+  }
+
+  void on_listener() {
+    for( ;; ) {
+      const int fd = accept4( listener_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+      if( fd < 0 ) {
+        break;
+      }
+
+      const int one = 1;
+      setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+
+      int slot;
+
+      if( !free_connections.empty() ) {
+        slot = free_connections.back();
+        free_connections.pop_back();
+      }
+      else {
+        slot = ( int ) connections.size();
+        connections.emplace_back();
+      }
+
+      Connection& connection = connections[ slot ];
+      connection.fd = fd;
+      connection.in.clear();
+      connection.out.clear();
+      connection.games.clear();
+      connection.writing = false;
+      connection.closing = false;
+      connection.dirty = false;
+
+      watch( fd, EPOLLIN, source_connection | ( uint64_t ) slot << 8 );
+
+      counters.connections.fetch_add( 1, std::memory_order_relaxed );
+    }
+  }
+
+  void on_connection( const int slot, const uint32_t events ) {
+    Connection& connection = connections[ slot ];
+
+    if( connection.fd < 0 ) {
+      return;
+    }
+
+    if( events & EPOLLOUT ) {
+      mark_dirty( slot );
+    }
+
+    if( !( events & ( EPOLLIN | EPOLLERR | EPOLLHUP ) ) ) {
+      return;
+    }
+
+    for( ;; ) {
+      uint8_t buffer[ 4096 ];
+
+      const ssize_t count = recv( connection.fd, buffer, sizeof( buffer ), MSG_DONTWAIT );
+
+      if( count > 0 ) {
+        connection.in.insert( connection.in.end(), buffer, buffer + count );
+        continue;
+      }
+
+      if( count == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK ) ) {
+        connection.closing = true;
+      }
+
+      break;
+    }
+
+    // Each message is preceded by its size.
+    Route route{};
+    route.connection = slot;
+
+    size_t offset = 0;
+
+    while( connection.in.size() - offset >= 2 ) {
+      const size_t size = connection.in[ offset ] | ( size_t ) connection.in[ offset + 1 ] << 8;
+
+      if( size == 0 || size > MAX_MESSAGE ) {
+        connection.closing = true;
+        break;
+      }
+
+      if( connection.in.size() - offset < 2 + size ) {
+        break;
+      }
+
+      Message message;
+      if( read_message( connection.in.data() + offset + 2, size, message ) ) {
+        receive( route, message );
+      }
+
+      offset += 2 + size;
+    }
+
+    connection.in.erase( connection.in.begin(), connection.in.begin() + offset );
+
+    if( connection.closing ) {
+      mark_dirty( slot );
+    }
+  }
+
+  void close_connection( const int slot ) {
+    Connection& connection = connections[ slot ];
+
+    epoll_ctl( epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr );
+    ::close( connection.fd );
+
+    connection.fd = -1;
+
+    // Nothing more can be sent to it, its players leave their games.
+    Route route{};
+    route.connection = slot;
+
+    const std::vector< uint32_t > games = std::move( connection.games );
+
+    for( const uint32_t id : games ) {
+      const Match* match = find( id );
+      if( match == nullptr ) {
+        continue;
+      }
+
+      for( int player{}; player < match->player_count; ++player ) {
+        if( match->players[ player ].route == route ) {
+          leave( id, route, player );
+          break;
+        }
+      }
+    }
+
+    connection.in.clear();
+    connection.out.clear();
+    connection.games.clear();
+
+    free_connections.push_back( slot );
+  }
+
+  //
+  // The shard's thread.
+  //
+  void run( const std::atomic< bool >& running_flag ) {
+    epoll_event events[ BATCH ];
+
+    while( running_flag.load( std::memory_order_relaxed ) ) {
+      const int count = epoll_wait( epoll_fd, events, BATCH, 100 );
+
+      const auto start = std::chrono::steady_clock::now();
+      now = seconds_now();
+
+      for( int i{}; i < count; ++i ) {
+        const uint64_t source = events[ i ].data.u64;
+
+        switch( source & 0xFF ) {
+          case source_timer: on_timer(); break;
+          case source_udp: on_datagrams(); break;
+          case source_listener: on_listener(); break;
+          case source_connection: on_connection( ( int ) ( source >> 8 ), events[ i ].events ); break;
+        }
+      }
+
+      flush();
+
+      counters.players.store( player_count, std::memory_order_relaxed );
+      counters.busy_nanoseconds.fetch_add( ( uint64_t ) std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count(),
+        std::memory_order_relaxed );
+    }
+  }
+};
+
+net::MatchServer::MatchServer( const ServerSettings& settings ) :
+  m_settings( settings ),
+  m_running( false ) {
+  if( m_settings.shards <= 0 ) {
+    m_settings.shards = ( int ) std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  m_settings.shards = std::min( m_settings.shards, 256 );
+  m_settings.max_games = std::clamp( m_settings.max_games, 1, 65536 );
+
+  for( int shard{}; shard < m_settings.shards; ++shard ) {
+    m_shards.push_back( std::make_unique< Shard >( m_settings, shard ) );
+  }
+}
+
+net::MatchServer::~MatchServer() {
+  stop();
+}
+
+bool net::MatchServer::start() {
+  if( m_running ) {
+    return true;
+  }
+
+  for( auto& shard : m_shards ) {
+    if( !shard->open() ) {
+      return false;
+    }
+  }
+
+  m_running = true;
+
+  const int cores = ( int ) std::max( 1u, std::thread::hardware_concurrency() );
+
+  for( int shard{}; shard < ( int ) m_shards.size(); ++shard ) {
+    m_threads.emplace_back( [ this, shard, cores ]() {
+      if( m_settings.pin_shards ) {
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        CPU_SET( shard % cores, &set );
+        pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+      }
+
+      m_shards[ shard ]->run( m_running );
+    } );
+  }
+
+  return true;
+}
+
+void net::MatchServer::stop() {
+  m_running = false;
+
+  for( std::thread& thread : m_threads ) {
+    thread.join();
+  }
+
+  m_threads.clear();
+}
+
+net::ShardStats net::MatchServer::stats( const int shard ) const {
+  const Shard::Counters& counters = m_shards[ shard ]->counters;
+
+  ShardStats stats{};
+  stats.games = counters.games.load( std::memory_order_relaxed );
+  stats.players = counters.players.load( std::memory_order_relaxed );
+  stats.ticks = counters.ticks.load( std::memory_order_relaxed );
+  stats.game_ticks = counters.game_ticks.load( std::memory_order_relaxed );
+  stats.dropped_ticks = counters.dropped_ticks.load( std::memory_order_relaxed );
+  stats.tick_seconds = counters.tick_nanoseconds.load( std::memory_order_relaxed ) * 1e-9;
+  stats.busy_seconds = counters.busy_nanoseconds.load( std::memory_order_relaxed ) * 1e-9;
+  stats.games_started = counters.games_started.load( std::memory_order_relaxed );
+  stats.games_finished = counters.games_finished.load( std::memory_order_relaxed );
+  stats.connections = counters.connections.load( std::memory_order_relaxed );
+  stats.messages_received = counters.messages_received.load( std::memory_order_relaxed );
+  stats.messages_sent = counters.messages_sent.load( std::memory_order_relaxed );
+
+  return stats;
+}
\ No newline at end of file
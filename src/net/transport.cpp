@@ -0,0 +1,165 @@
+#include <net/transport.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//
+// LocalTransport
+//
+net::LocalTransport::LocalTransport() : m_peer( nullptr ) {}
+
+void net::LocalTransport::connect( LocalTransport& a, LocalTransport& b ) {
+  a.m_peer = &b;
+  b.m_peer = &a;
+}
+
+void net::LocalTransport::send( const uint8_t* data, const size_t size ) {
+  if( m_peer != nullptr ) {
+    m_peer->m_inbox.emplace_back( data, data + std::min( size, MAX_DATAGRAM ) );
+  }
+}
+
+size_t net::LocalTransport::receive( uint8_t* buffer, const size_t capacity ) {
+  if( m_inbox.empty() ) {
+    return 0;
+  }
+
+  // Like a datagram socket, whatever doesn't fit is lost.
+  const std::vector< uint8_t >& datagram = m_inbox.front();
+  const size_t size = std::min( datagram.size(), capacity );
+
+  memcpy( buffer, datagram.data(), size );
+  m_inbox.pop_front();
+
+  return size;
+}
+
+//
+// UdpTransport
+//
+net::UdpTransport::UdpTransport( const uint16_t local_port, const char* remote_host, const uint16_t remote_port ) :
+  m_socket( -1 ),
+  m_remote_address( 0 ),
+  m_remote_port( htons( remote_port ) ) {
+  in_addr remote{};
+  if( inet_pton( AF_INET, remote_host, &remote ) != 1 ) {
+    return;
+  }
+
+  m_remote_address = remote.s_addr;
+
+  const int fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( fd < 0 ) {
+    return;
+  }
+
+  sockaddr_in local{};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl( INADDR_ANY );
+  local.sin_port = htons( local_port );
+
+  if( bind( fd, ( const sockaddr* ) &local, sizeof( local ) ) != 0 || fcntl( fd, F_SETFL, fcntl( fd, F_GETFL, 0 ) | O_NONBLOCK ) != 0 ) {
+    close( fd );
+    return;
+  }
+
+  m_socket = fd;
+}
+
+net::UdpTransport::~UdpTransport() {
+  if( m_socket >= 0 ) {
+    close( m_socket );
+  }
+}
+
+void net::UdpTransport::send( const uint8_t* data, const size_t size ) {
+  if( m_socket < 0 ) {
+    return;
+  }
+
+  sockaddr_in remote{};
+  remote.sin_family = AF_INET;
+  remote.sin_addr.s_addr = m_remote_address;
+  remote.sin_port = m_remote_port;
+
+  // A full socket buffer is just another lost datagram.
+  sendto( m_socket, data, std::min( size, MAX_DATAGRAM ), 0, ( const sockaddr* ) &remote, sizeof( remote ) );
+}
+
+size_t net::UdpTransport::receive( uint8_t* buffer, const size_t capacity ) {
+  if( m_socket < 0 ) {
+    return 0;
+  }
+
+  for( ;; ) {
+    sockaddr_in from{};
+    socklen_t from_size = sizeof( from );
+
+    const ssize_t size = recvfrom( m_socket, buffer, capacity, 0, ( sockaddr* ) &from, &from_size );
+    if( size <= 0 ) {
+      return 0;
+    }
+
+    if( from.sin_addr.s_addr == m_remote_address && from.sin_port == m_remote_port ) {
+      return ( size_t ) size;
+    }
+  }
+}
+
+//
+// ConditionedTransport
+//
+net::ConditionedTransport::ConditionedTransport( Transport& inner, const LinkConditions& conditions, const uint64_t seed ) :
+  m_inner( inner ),
+  m_conditions( conditions ),
+  m_random( seed ),
+  m_time( 0.0 ),
+  m_sent( 0 ),
+  m_dropped( 0 ) {}
+
+void net::ConditionedTransport::release() {
+  // Oldest release time first, so jittered datagrams overtake each other the way they would.
+  std::stable_sort( m_pending.begin(), m_pending.end(), []( const Pending& a, const Pending& b ) {
+    return a.release < b.release;
+  } );
+
+  size_t released = 0;
+  while( released < m_pending.size() && m_pending[ released ].release <= m_time ) {
+    m_inner.send( m_pending[ released ].data.data(), m_pending[ released ].data.size() );
+    ++released;
+  }
+
+  m_pending.erase( m_pending.begin(), m_pending.begin() + released );
+}
+
+void net::ConditionedTransport::set_time( const double time ) {
+  m_time = time;
+  release();
+}
+
+void net::ConditionedTransport::send( const uint8_t* data, const size_t size ) {
+  ++m_sent;
+
+  const double loss_roll = m_random.next() / 4294967296.0;
+  const double jitter_roll = m_random.next() / 4294967296.0;
+
+  if( loss_roll < m_conditions.loss ) {
+    ++m_dropped;
+    return;
+  }
+
+  const double delay = std::max( 0.0, m_conditions.latency + ( jitter_roll * 2.0 - 1.0 ) * m_conditions.jitter );
+
+  m_pending.push_back( { m_time + delay, std::vector< uint8_t >( data, data + std::min( size, MAX_DATAGRAM ) ) } );
+  release();
+}
+
+size_t net::ConditionedTransport::receive( uint8_t* buffer, const size_t capacity ) {
+  return m_inner.receive( buffer, capacity );
+}
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include <sim/batch.hpp>
+#include <game/rules.hpp>
+#include <game/shape.hpp>
+
+#include <bit>
+#include <cstring>
+
+#if defined( __AVX2__ )
+#define BATCH_AVX2
+#endif
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define BATCH_SSE2
+#endif
+
+#if defined( BATCH_AVX2 ) || defined( BATCH_SSE2 )
+#include <immintrin.h>
+#endif
+
+//
+// Flattened copy of the shape tables so they can be indexed (and gathered) with
+// ( type * 4 + rotation ) * 4 + column.
+//
+struct ShapeLines {
+  uint32_t lines[ game::NUM_TETROMINO * 4 * 4 ];
+  int32_t next_rotation[ game::NUM_TETROMINO * 4 ];
+};
+
+static constexpr ShapeLines make_shape_lines() {
+  ShapeLines table{};
+
+  for( size_t type{}; type < game::NUM_TETROMINO; ++type ) {
+    const game::Tetromino& tetromino = game::TETROMINO_TABLE[ type ];
+    const size_t num_rotations = tetromino.num_rotations();
+
+    for( size_t rotation{}; rotation < 4; ++rotation ) {
+      const game::ShapeRotation& shape = tetromino.rotation( rotation % num_rotations );
+
+      for( int column{}; column < 4; ++column ) {
+        table.lines[ ( type * 4 + rotation ) * 4 + column ] = shape.lines[ column ];
+      }
+
+      table.next_rotation[ type * 4 + rotation ] = ( int32_t ) ( ( rotation + 1 ) % num_rotations );
+    }
+  }
+
+  return table;
+}
+
+static constexpr ShapeLines SHAPE_LINES = make_shape_lines();
+
+// An empty line, only the wall bits either side of the playfield are set.
+static constexpr uint32_t EMPTY_LINE = ( ( 1u << sim::BoardBatch::WALL ) - 1 ) | ( ~0u << ( sim::BoardBatch::WIDTH + sim::BoardBatch::WALL ) );
+
+// A completed line, or the floor.
+static constexpr uint32_t FULL_LINE = ~0u;
+
+sim::BoardBatch::BoardBatch( const size_t size, const uint64_t seed, const game::RandomizerType randomizer ) :
+  m_size( size ),
+  m_capacity( ( size + LANES - 1 ) / LANES * LANES ),
+  m_lines( m_capacity * LINE_STRIDE ),
+  m_type( m_capacity ),
+  m_rotation( m_capacity ),
+  m_x( m_capacity ),
+  m_y( m_capacity ),
+  m_gravity_timer( m_capacity ),
+  m_gravity_frames( m_capacity ),
+  m_move_timer( m_capacity ),
+  m_first_move( m_capacity ),
+  m_rotate_timer( m_capacity ),
+  m_hard_drop_held( m_capacity ),
+  m_game_over( m_capacity ),
+  m_level( m_capacity ),
+  m_lines_cleared( m_capacity ),
+  m_score( m_capacity ),
+  m_events( m_capacity ),
+  m_cleared_lines( m_capacity ),
+  m_generators( m_capacity, game::PieceGenerator( 0, randomizer ) ) {
+  for( size_t board{}; board < m_capacity; ++board ) {
+    reset( board, seed + board );
+  }
+
+  // Padding boards only exist to fill out the last block, keep them out of the simulation.
+  for( size_t board = m_size; board < m_capacity; ++board ) {
+    m_game_over[ board ] = 1;
+  }
+}
+
+void sim::BoardBatch::reset( const size_t board, const uint64_t seed ) {
+  uint32_t* lines = &m_lines[ board * LINE_STRIDE ];
+  for( int y{}; y < LINE_STRIDE; ++y ) {
+    lines[ y ] = y < HEIGHT ? EMPTY_LINE : FULL_LINE;
+  }
+
+  m_gravity_timer[ board ] = 0;
+  m_gravity_frames[ board ] = game::gravity_frames( 0 );
+  m_move_timer[ board ] = 0;
+  m_first_move[ board ] = 1;
+  m_rotate_timer[ board ] = 0;
+  m_hard_drop_held[ board ] = 0;
+
+  m_game_over[ board ] = 0;
+  m_level[ board ] = 0;
+  m_lines_cleared[ board ] = 0;
+  m_score[ board ] = 0;
+
+  m_events[ board ] = 0;
+  m_cleared_lines[ board ] = 0;
+
+  m_generators[ board ].reset( seed );
+  spawn( board );
+}
+
+const uint32_t sim::BoardBatch::line( const size_t board, const int y ) const {
+  if( y < 0 || y >= HEIGHT ) {
+    return 0;
+  }
+
+  return ( m_lines[ board * LINE_STRIDE + y ] >> WALL ) & ( ( 1u << WIDTH ) - 1 );
+}
+
+const int sim::BoardBatch::get_state( const size_t board, const int x, const int y ) const {
+  if( x < 0 || x >= WIDTH ) {
+    return 0;
+  }
+
+  return ( line( board, y ) >> x ) & 1;
+}
+
+bool sim::BoardBatch::collides( const size_t board, const int type, const int rotation, const int x, const int y ) const {
+  const uint32_t* shape = &SHAPE_LINES.lines[ ( type * 4 + rotation ) * 4 ];
+  const uint32_t* lines = &m_lines[ board * LINE_STRIDE + y ];
+
+  for( int column{}; column < 4; ++column ) {
+    if( ( shape[ column ] << ( x + WALL ) ) & lines[ column ] ) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void sim::BoardBatch::spawn( const size_t board ) {
+  m_type[ board ] = m_generators[ board ].next();
+  m_rotation[ board ] = 0;
+  m_x[ board ] = WIDTH / 2;
+  m_y[ board ] = 0;
+
+  // GAME OVER!!
+  if( collides( board, m_type[ board ], 0, m_x[ board ], m_y[ board ] ) ) {
+    m_game_over[ board ] = 1;
+    m_events[ board ] |= game::event_game_over;
+    return;
+  }
+
+  m_events[ board ] |= game::event_spawned;
+}
+
+void sim::BoardBatch::lock( const size_t board ) {
+  uint32_t* lines = &m_lines[ board * LINE_STRIDE ];
+
+  const int x = m_x[ board ];
+  const int y = m_y[ board ];
+  const uint32_t* shape = &SHAPE_LINES.lines[ ( m_type[ board ] * 4 + m_rotation[ board ] ) * 4 ];
+
+  for( int column{}; column < 4; ++column ) {
+    lines[ y + column ] |= shape[ column ] << ( x + WALL );
+  }
+
+  m_events[ board ] |= game::event_locked;
+  m_gravity_timer[ board ] = 0;
+
+  // Only the 4 lines the tetromino landed on can have been completed.
+  uint32_t full = 0;
+
+#if defined( BATCH_SSE2 )
+  const __m128i landed = _mm_loadu_si128( ( const __m128i* ) &lines[ y ] );
+  full = ( uint32_t ) _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( landed, _mm_set1_epi32( -1 ) ) ) );
+#else
+  for( int column{}; column < 4; ++column ) {
+    if( lines[ y + column ] == FULL_LINE ) {
+      full |= 1u << column;
+    }
+  }
+#endif
+
+  // The floor reads as full too, ignore it.
+  if( y + 4 > HEIGHT ) {
+    full &= ( 1u << ( HEIGHT - y ) ) - 1;
+  }
+
+  if( full ) {
+    const uint32_t cleared = full << y;
+
+    // Compact everything above the lowest cleared line downwards.
+    int destination = y + 3 < HEIGHT - 1 ? y + 3 : HEIGHT - 1;
+    for( int source = destination; source >= 0; --source ) {
+      if( cleared & ( 1u << source ) ) {
+        continue;
+      }
+
+      lines[ destination-- ] = lines[ source ];
+    }
+
+    while( destination >= 0 ) {
+      lines[ destination-- ] = EMPTY_LINE;
+    }
+
+    const int num_lines = std::popcount( full );
+    const int level = m_level[ board ];
+
+    m_score[ board ] += game::line_clear_score( num_lines, level );
+    m_lines_cleared[ board ] += num_lines;
+    m_level[ board ] = game::level_for_lines( m_lines_cleared[ board ] );
+
+    m_events[ board ] |= game::event_lines_cleared;
+    m_cleared_lines[ board ] = cleared;
+
+    if( m_level[ board ] != level ) {
+      m_gravity_frames[ board ] = game::gravity_frames( m_level[ board ] );
+      m_events[ board ] |= game::event_level_up;
+    }
+  }
+
+  spawn( board );
+}
+
+void sim::BoardBatch::drop( const size_t board, const bool hard_drop, const bool speed_up ) {
+  const int type = m_type[ board ];
+
+  int distance = 0;
+  while( !collides( board, type, m_rotation[ board ], m_x[ board ], m_y[ board ] + distance + 1 ) ) {
+    ++distance;
+  }
+
+  m_gravity_timer[ board ] = 0;
+
+  if( distance > 0 ) {
+    m_y[ board ] += distance;
+    m_score[ board ] += distance * ( hard_drop ? game::HARD_DROP_POINTS : speed_up ? game::SOFT_DROP_POINTS : 0 );
+    m_events[ board ] |= game::event_dropped;
+  }
+
+  if( hard_drop || distance == 0 ) {
+    lock( board );
+  }
+}
+
+void sim::BoardBatch::step_board( const size_t board, const uint8_t input ) {
+  m_events[ board ] = 0;
+  m_cleared_lines[ board ] = 0;
+
+  if( m_game_over[ board ] ) {
+    return;
+  }
+
+  const int type = m_type[ board ];
+
+  //
+  // Rotation.
+  //
+  if( m_rotate_timer[ board ] > 0 ) {
+    --m_rotate_timer[ board ];
+  }
+  else if( input & game::input_rotate ) {
+    const int rotation = SHAPE_LINES.next_rotation[ type * 4 + m_rotation[ board ] ];
+
+    if( !collides( board, type, rotation, m_x[ board ], m_y[ board ] ) ) {
+      m_rotation[ board ] = rotation;
+      m_rotate_timer[ board ] = game::ROTATE_FRAMES - 1;
+      m_events[ board ] |= game::event_rotated;
+    }
+  }
+
+  //
+  // Movement.
+  //
+  const bool left = input & game::input_left;
+  const bool right = input & game::input_right;
+
+  if( !( left || right ) ) {
+    m_move_timer[ board ] = 0;
+    m_first_move[ board ] = 1;
+  }
+  else {
+    if( m_move_timer[ board ] > 0 ) {
+      --m_move_timer[ board ];
+    }
+
+    if( m_move_timer[ board ] == 0 ) {
+      const int side = left ? -1 : 1;
+
+      if( !collides( board, type, m_rotation[ board ], m_x[ board ] + side, m_y[ board ] ) ) {
+        m_x[ board ] += side;
+        m_events[ board ] |= game::event_moved;
+      }
+
+      m_move_timer[ board ] = m_first_move[ board ] ? game::DAS_FRAMES : game::ARR_FRAMES;
+      m_first_move[ board ] = 0;
+    }
+  }
+
+  //
+  // Gravity.
+  //
+  const bool hard_drop = ( input & game::input_hard_drop ) && !m_hard_drop_held[ board ];
+  m_hard_drop_held[ board ] = ( input & game::input_hard_drop ) ? 1 : 0;
+
+  const bool speed_up = input & game::input_soft_drop;
+  const int frames = game::drop_frames( m_gravity_frames[ board ], speed_up );
+
+  if( hard_drop ) {
+    drop( board, true, speed_up );
+    return;
+  }
+
+  if( ++m_gravity_timer[ board ] >= frames ) {
+    if( frames == 0 ) {
+      drop( board, false, speed_up );
+      return;
+    }
+
+    m_gravity_timer[ board ] = 0;
+
+    if( collides( board, type, m_rotation[ board ], m_x[ board ], m_y[ board ] + 1 ) ) {
+      lock( board );
+      return;
+    }
+
+    ++m_y[ board ];
+    m_events[ board ] |= game::event_dropped;
+
+    if( speed_up ) {
+      m_score[ board ] += game::SOFT_DROP_POINTS;
+    }
+  }
+}
+
+#if defined( BATCH_AVX2 )
+
+static __m256i load( const int32_t* values ) {
+  return _mm256_loadu_si256( ( const __m256i* ) values );
+}
+
+static void store( int32_t* values, const __m256i value ) {
+  _mm256_storeu_si256( ( __m256i* ) values, value );
+}
+
+static __m256i input_flag( const __m256i input, const int flag ) {
+  const __m256i bit = _mm256_set1_epi32( flag );
+  return _mm256_cmpeq_epi32( _mm256_and_si256( input, bit ), bit );
+}
+
+// Returns all bits set in the lanes where the tetromino placed at x, y overlaps a filled cell, wall or the floor.
+static __m256i collides8( const uint32_t* lines, const __m256i line_start, const __m256i type, const __m256i rotation, const __m256i x, const __m256i y ) {
+  const __m256i shape = _mm256_slli_epi32( _mm256_add_epi32( _mm256_slli_epi32( type, 2 ), rotation ), 2 );
+  const __m256i shift = _mm256_add_epi32( x, _mm256_set1_epi32( sim::BoardBatch::WALL ) );
+  const __m256i row = _mm256_add_epi32( line_start, y );
+
+  __m256i hit = _mm256_setzero_si256();
+
+  for( int column{}; column < 4; ++column ) {
+    const __m256i offset = _mm256_set1_epi32( column );
+    const __m256i cells = _mm256_i32gather_epi32( ( const int* ) SHAPE_LINES.lines, _mm256_add_epi32( shape, offset ), 4 );
+    const __m256i line = _mm256_i32gather_epi32( ( const int* ) lines, _mm256_add_epi32( row, offset ), 4 );
+
+    hit = _mm256_or_si256( hit, _mm256_and_si256( _mm256_sllv_epi32( cells, shift ), line ) );
+  }
+
+  return _mm256_xor_si256( _mm256_cmpeq_epi32( hit, _mm256_setzero_si256() ), _mm256_set1_epi32( -1 ) );
+}
+
+void sim::BoardBatch::step_block( const size_t first, const uint8_t* inputs ) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32( 1 );
+
+  const __m256i input = _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* ) inputs ) );
+  const __m256i alive = _mm256_cmpeq_epi32( load( &m_game_over[ first ] ), zero );
+  const __m256i line_start = _mm256_mullo_epi32(
+    _mm256_add_epi32( _mm256_set1_epi32( ( int ) first ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) ),
+    _mm256_set1_epi32( LINE_STRIDE )
+  );
+
+  const __m256i type = load( &m_type[ first ] );
+  __m256i rotation = load( &m_rotation[ first ] );
+  __m256i x = load( &m_x[ first ] );
+  __m256i y = load( &m_y[ first ] );
+  __m256i score = load( &m_score[ first ] );
+  __m256i events = zero;
+
+  //
+  // Rotation.
+  //
+  __m256i rotate_timer = load( &m_rotate_timer[ first ] );
+  const __m256i cooling = _mm256_cmpgt_epi32( rotate_timer, zero );
+  rotate_timer = _mm256_sub_epi32( rotate_timer, _mm256_and_si256( cooling, one ) );
+
+  const __m256i rotate = _mm256_andnot_si256( cooling, _mm256_and_si256( alive, input_flag( input, game::input_rotate ) ) );
+  if( !_mm256_testz_si256( rotate, rotate ) ) {
+    const __m256i next = _mm256_i32gather_epi32( SHAPE_LINES.next_rotation, _mm256_add_epi32( _mm256_slli_epi32( type, 2 ), rotation ), 4 );
+    const __m256i rotated = _mm256_andnot_si256( collides8( m_lines.data(), line_start, type, next, x, y ), rotate );
+
+    rotation = _mm256_blendv_epi8( rotation, next, rotated );
+    rotate_timer = _mm256_blendv_epi8( rotate_timer, _mm256_set1_epi32( game::ROTATE_FRAMES - 1 ), rotated );
+    events = _mm256_or_si256( events, _mm256_and_si256( rotated, _mm256_set1_epi32( game::event_rotated ) ) );
+  }
+
+  //
+  // Movement.
+  //
+  const __m256i left = input_flag( input, game::input_left );
+  const __m256i held = _mm256_or_si256( left, input_flag( input, game::input_right ) );
+
+  // Releasing both keys resets the auto shift.
+  __m256i move_timer = _mm256_and_si256( load( &m_move_timer[ first ] ), held );
+  __m256i first_move = _mm256_blendv_epi8( one, load( &m_first_move[ first ] ), held );
+
+  move_timer = _mm256_sub_epi32( move_timer, _mm256_and_si256( _mm256_cmpgt_epi32( move_timer, zero ), one ) );
+
+  const __m256i move = _mm256_and_si256( _mm256_and_si256( alive, held ), _mm256_cmpeq_epi32( move_timer, zero ) );
+  if( !_mm256_testz_si256( move, move ) ) {
+    const __m256i moved_x = _mm256_add_epi32( x, _mm256_blendv_epi8( one, _mm256_set1_epi32( -1 ), left ) );
+    const __m256i moved = _mm256_andnot_si256( collides8( m_lines.data(), line_start, type, rotation, moved_x, y ), move );
+
+    x = _mm256_blendv_epi8( x, moved_x, moved );
+    events = _mm256_or_si256( events, _mm256_and_si256( moved, _mm256_set1_epi32( game::event_moved ) ) );
+
+    const __m256i delay = _mm256_blendv_epi8( _mm256_set1_epi32( game::ARR_FRAMES ), _mm256_set1_epi32( game::DAS_FRAMES ), _mm256_cmpeq_epi32( first_move, one ) );
+    move_timer = _mm256_blendv_epi8( move_timer, delay, move );
+    first_move = _mm256_andnot_si256( move, first_move );
+  }
+
+  //
+  // Gravity.
+  //
+  const __m256i hard_held = input_flag( input, game::input_hard_drop );
+  const __m256i hard_drop = _mm256_and_si256( _mm256_and_si256( alive, hard_held ), _mm256_cmpeq_epi32( load( &m_hard_drop_held[ first ] ), zero ) );
+
+  const __m256i speed_up = input_flag( input, game::input_soft_drop );
+  const __m256i gravity = load( &m_gravity_frames[ first ] );
+  const __m256i frames = _mm256_blendv_epi8( gravity, _mm256_min_epi32( gravity, _mm256_set1_epi32( game::SOFT_DROP_FRAMES ) ), speed_up );
+
+  // Hard drops and 20G can fall any distance, those lanes are left for drop() below.
+  const __m256i falling = _mm256_or_si256( hard_drop, _mm256_and_si256( alive, _mm256_cmpeq_epi32( frames, zero ) ) );
+
+  __m256i gravity_timer = _mm256_add_epi32( load( &m_gravity_timer[ first ] ), one );
+  const __m256i due = _mm256_andnot_si256( falling, _mm256_and_si256( alive, _mm256_cmpgt_epi32( gravity_timer, _mm256_sub_epi32( frames, one ) ) ) );
+  gravity_timer = _mm256_andnot_si256( due, gravity_timer );
+
+  int locked = 0;
+
+  if( !_mm256_testz_si256( due, due ) ) {
+    const __m256i landed = collides8( m_lines.data(), line_start, type, rotation, x, _mm256_add_epi32( y, one ) );
+    const __m256i dropped = _mm256_andnot_si256( landed, due );
+
+    // Comparisons produce -1 for true, subtracting them adds 1.
+    y = _mm256_sub_epi32( y, dropped );
+    score = _mm256_add_epi32( score, _mm256_and_si256( _mm256_and_si256( dropped, speed_up ), _mm256_set1_epi32( game::SOFT_DROP_POINTS ) ) );
+    events = _mm256_or_si256( events, _mm256_and_si256( dropped, _mm256_set1_epi32( game::event_dropped ) ) );
+
+    locked = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_and_si256( due, landed ) ) );
+  }
+
+  // Boards that are already over keep their state untouched.
+  const auto keep = [ & ]( int32_t* values, const __m256i value ) {
+    store( values, _mm256_blendv_epi8( load( values ), value, alive ) );
+  };
+
+  keep( &m_rotation[ first ], rotation );
+  keep( &m_x[ first ], x );
+  keep( &m_y[ first ], y );
+  keep( &m_score[ first ], score );
+  keep( &m_rotate_timer[ first ], rotate_timer );
+  keep( &m_move_timer[ first ], move_timer );
+  keep( &m_first_move[ first ], first_move );
+  keep( &m_gravity_timer[ first ], gravity_timer );
+  keep( &m_hard_drop_held[ first ], _mm256_and_si256( hard_held, one ) );
+
+  store( ( int32_t* ) &m_events[ first ], events );
+  store( ( int32_t* ) &m_cleared_lines[ first ], zero );
+
+  while( locked ) {
+    const int lane = std::countr_zero( ( uint32_t ) locked );
+    locked &= locked - 1;
+
+    lock( first + lane );
+  }
+
+  int fall = _mm256_movemask_ps( _mm256_castsi256_ps( falling ) );
+  const int hard = _mm256_movemask_ps( _mm256_castsi256_ps( hard_drop ) );
+  const int soft = _mm256_movemask_ps( _mm256_castsi256_ps( speed_up ) );
+
+  while( fall ) {
+    const int lane = std::countr_zero( ( uint32_t ) fall );
+    fall &= fall - 1;
+
+    drop( first + lane, ( hard >> lane ) & 1, ( soft >> lane ) & 1 );
+  }
+}
+
+#else
+
+void sim::BoardBatch::step_block( const size_t first, const uint8_t* inputs ) {
+  for( int lane{}; lane < LANES; ++lane ) {
+    step_board( first + lane, inputs[ lane ] );
+  }
+}
+
+#endif
+
+void sim::BoardBatch::step( const uint8_t* inputs ) {
+  size_t board = 0;
+
+  for( ; board + LANES <= m_size; board += LANES ) {
+    step_block( board, &inputs[ board ] );
+  }
+
+  // The last block is only partially filled, pad its inputs out.
+  if( board < m_size ) {
+    uint8_t tail[ LANES ] = {};
+    memcpy( tail, &inputs[ board ], m_size - board );
+
+    step_block( board, tail );
+  }
+}
\ No newline at end of file
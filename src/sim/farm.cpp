@@ -0,0 +1,209 @@
+#include <sim/farm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Salt used to derive a game's input stream from its seed so it differs from the tetromino stream.
+static constexpr uint64_t INPUT_STREAM = 0xD1B54A32D192ED03ull;
+
+//
+// A range of seeds still to be played.
+//
+struct SeedRange {
+  uint64_t begin;
+  uint64_t end;
+};
+
+//
+// Per worker queue of seed ranges, the owner works from the back while thieves take from the
+// front where the biggest (oldest) ranges are.
+//
+class WorkQueue {
+private:
+  std::mutex m_mutex;
+  std::deque< SeedRange > m_ranges;
+
+public:
+  void push( const SeedRange& range ) {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_ranges.push_back( range );
+  }
+
+  bool pop( SeedRange& range ) {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if( m_ranges.empty() ) {
+      return false;
+    }
+
+    range = m_ranges.back();
+    m_ranges.pop_back();
+    return true;
+  }
+
+  bool steal( SeedRange& range ) {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if( m_ranges.empty() ) {
+      return false;
+    }
+
+    range = m_ranges.front();
+    m_ranges.pop_front();
+    return true;
+  }
+};
+
+uint8_t sim::random_input( const game::Board&, const uint8_t previous, game::Random& random ) {
+  const uint32_t value = random.next();
+  if( ( value & 7 ) != 0 ) {
+    return previous;
+  }
+
+  return ( uint8_t ) ( ( value >> 8 ) & ( game::input_left | game::input_right | game::input_rotate | game::input_soft_drop ) );
+}
+
+sim::GameFarm::GameFarm( const FarmSettings& settings, InputPolicy policy ) :
+  m_settings( settings ),
+  m_policy( std::move( policy ) ) {
+  if( m_settings.num_threads <= 0 ) {
+    m_settings.num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  m_settings.grain = std::max< uint64_t >( 1, m_settings.grain );
+}
+
+sim::GameResult sim::GameFarm::play( game::Board& board, const uint64_t seed ) const {
+  board.reset( seed );
+
+  game::Random random( seed ^ INPUT_STREAM );
+  uint8_t input = game::input_none;
+
+  GameResult result{};
+  result.seed = seed;
+
+  while( !board.is_game_over() && result.ticks < m_settings.max_ticks ) {
+    input = m_policy( board, input, random );
+
+    board.step( input );
+    board.update();
+
+    ++result.ticks;
+  }
+
+  result.score = board.score();
+  result.lines = board.lines_cleared();
+  result.level = board.level();
+
+  return result;
+}
+
+sim::FarmReport sim::GameFarm::run() const {
+  const int num_threads = m_settings.num_threads;
+  const uint64_t num_games = m_settings.num_games;
+
+  FarmReport report{};
+  report.games.resize( num_games );
+  report.workers.resize( num_threads );
+
+  std::vector< WorkQueue > queues( num_threads );
+  std::atomic< uint64_t > remaining{ num_games };
+
+  // Deal an even share of the seeds to every worker up front, stealing evens out the rest.
+  for( int i{}; i < num_threads; ++i ) {
+    const uint64_t begin = num_games * i / num_threads;
+    const uint64_t end = num_games * ( i + 1 ) / num_threads;
+
+    if( begin != end ) {
+      queues[ i ].push( { begin, end } );
+    }
+  }
+
+  const auto worker = [ & ]( const int id ) {
+    game::Board board{ m_settings.first_seed, m_settings.randomizer };
+    WorkerReport& stats = report.workers[ id ];
+
+    while( remaining.load( std::memory_order_acquire ) > 0 ) {
+      SeedRange range;
+
+      if( !queues[ id ].pop( range ) ) {
+        bool stolen = false;
+
+        for( int i = 1; i < num_threads && !stolen; ++i ) {
+          stolen = queues[ ( id + i ) % num_threads ].steal( range );
+        }
+
+        if( !stolen ) {
+          std::this_thread::yield();
+          continue;
+        }
+
+        ++stats.steals;
+      }
+
+      // Keep splitting the range, leaving the upper halves behind for anyone idle to steal.
+      while( range.end - range.begin > m_settings.grain ) {
+        const uint64_t middle = range.begin + ( range.end - range.begin ) / 2;
+        queues[ id ].push( { middle, range.end } );
+        range.end = middle;
+      }
+
+      for( uint64_t game = range.begin; game < range.end; ++game ) {
+        const GameResult result = play( board, m_settings.first_seed + game );
+        report.games[ game ] = result;
+
+        ++stats.games;
+        stats.ticks += result.ticks;
+      }
+
+      remaining.fetch_sub( range.end - range.begin, std::memory_order_release );
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector< std::thread > threads;
+  for( int i = 1; i < num_threads; ++i ) {
+    threads.emplace_back( worker, i );
+  }
+
+  worker( 0 );
+
+  for( std::thread& thread : threads ) {
+    thread.join();
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  report.seconds = std::chrono::duration< double >( end - start ).count();
+
+  //
+  // Aggregate in seed order so the totals and digest don't depend on the scheduling.
+  //
+  report.digest = 0xCBF29CE484222325ull;
+  report.max_score = -1;
+
+  const auto hash = [ & ]( const uint64_t value ) {
+    report.digest = ( report.digest ^ value ) * 0x100000001B3ull;
+  };
+
+  for( const GameResult& game : report.games ) {
+    report.total_ticks += game.ticks;
+    report.total_score += game.score;
+    report.total_lines += game.lines;
+
+    if( game.score > report.max_score ) {
+      report.max_score = game.score;
+      report.max_score_seed = game.seed;
+    }
+
+    hash( game.seed );
+    hash( game.ticks );
+    hash( ( uint64_t ) game.score );
+    hash( ( uint64_t ) game.lines );
+    hash( ( uint64_t ) game.level );
+  }
+
+  return report;
+}
\ No newline at end of file
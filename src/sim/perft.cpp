@@ -0,0 +1,147 @@
+#include <sim/perft.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Leaf hashes are sorted and deduplicated whenever this many have been collected.
+static constexpr size_t COMPACT_THRESHOLD = 1 << 20;
+
+static void compact( std::vector< uint64_t >& hashes ) {
+  std::sort( hashes.begin(), hashes.end() );
+  hashes.erase( std::unique( hashes.begin(), hashes.end() ), hashes.end() );
+}
+
+//
+// Depth first walk with one board and placement list per level, so nothing is allocated once
+// the first branch has been walked.
+//
+class PerftWalker {
+private:
+  std::vector< game::Board > m_boards;
+  std::vector< game::PlacementList > m_placements;
+
+public:
+  uint64_t m_nodes = 0;
+  uint64_t m_leaves = 0;
+  std::vector< uint64_t > m_hashes;
+
+public:
+  PerftWalker( const game::Board& board, const int depth ) :
+    m_boards( depth + 1, board ),
+    m_placements( depth + 1 ) {}
+
+  void walk( const game::Board& board, const int level, const int depth ) {
+    if( level == depth ) {
+      ++m_leaves;
+      m_hashes.push_back( board.board_hash() );
+
+      if( m_hashes.size() >= COMPACT_THRESHOLD ) {
+        compact( m_hashes );
+      }
+
+      return;
+    }
+
+    game::PlacementList& placements = m_placements[ level ];
+    board.find_placements( placements );
+
+    game::Board& child = m_boards[ level + 1 ];
+
+    for( const game::Placement& placement : placements ) {
+      child = board;
+      child.place( placement );
+      ++m_nodes;
+
+      if( !child.is_game_over() ) {
+        walk( child, level + 1, depth );
+      }
+    }
+  }
+};
+
+sim::PerftResult sim::perft( const game::Board& board, const int depth, const int num_threads ) {
+  const auto start = std::chrono::steady_clock::now();
+
+  PerftResult result{};
+  std::vector< uint64_t > hashes;
+
+  if( num_threads <= 1 || depth < 3 ) {
+    PerftWalker walker( board, depth );
+    walker.walk( board, 0, depth );
+
+    result.nodes = walker.m_nodes;
+    result.leaves = walker.m_leaves;
+    hashes = std::move( walker.m_hashes );
+  }
+  else {
+    //
+    // Expand the first two levels here, every board two placements in is a task.
+    //
+    std::vector< game::Board > tasks;
+
+    game::PlacementList first;
+    game::PlacementList second;
+    board.find_placements( first );
+
+    for( const game::Placement& a : first ) {
+      game::Board child = board;
+      child.place( a );
+      ++result.nodes;
+
+      if( child.is_game_over() ) {
+        continue;
+      }
+
+      child.find_placements( second );
+
+      for( const game::Placement& b : second ) {
+        game::Board grandchild = child;
+        grandchild.place( b );
+        ++result.nodes;
+
+        if( !grandchild.is_game_over() ) {
+          tasks.push_back( std::move( grandchild ) );
+        }
+      }
+    }
+
+    std::atomic< size_t > next_task{ 0 };
+    std::vector< PerftWalker > walkers( num_threads, PerftWalker( board, depth ) );
+
+    const auto worker = [ & ]( const int id ) {
+      PerftWalker& walker = walkers[ id ];
+
+      for( size_t task = next_task++; task < tasks.size(); task = next_task++ ) {
+        walker.walk( tasks[ task ], 2, depth );
+      }
+    };
+
+    std::vector< std::thread > threads;
+    for( int i = 1; i < num_threads; ++i ) {
+      threads.emplace_back( worker, i );
+    }
+
+    worker( 0 );
+
+    for( std::thread& thread : threads ) {
+      thread.join();
+    }
+
+    for( PerftWalker& walker : walkers ) {
+      result.nodes += walker.m_nodes;
+      result.leaves += walker.m_leaves;
+      hashes.insert( hashes.end(), walker.m_hashes.begin(), walker.m_hashes.end() );
+    }
+  }
+
+  compact( hashes );
+  result.distinct = hashes.size();
+
+  const auto end = std::chrono::steady_clock::now();
+  result.seconds = std::chrono::duration< double >( end - start ).count();
+
+  return result;
+}
\ No newline at end of file
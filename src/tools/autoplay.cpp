@@ -0,0 +1,105 @@
+#include <bot/autoplayer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+
+//
+// Soak test and throughput benchmark for bot::Autoplayer.
+//
+//    usage: autoplay [games] [seed] [beam_width] [depth] [max_pieces] [steer|place] [table_mb]
+//
+// steer (the default) plays every game through Board::step one tick at a time with the inputs
+// the autoplayer produces, exactly like it plays in the window. place skips the ticks and locks
+// each chosen placement straight away with Board::place, which measures the search on its own.
+// A table size above 0 caches board scores in a transposition table and reports how it did.
+//
+
+int main( int argc, char* argv[] ) {
+  const uint64_t games = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 10;
+  const uint64_t seed = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 0;
+  const int beam_width = argc > 3 ? atoi( argv[ 3 ] ) : 8;
+  const int depth = argc > 4 ? atoi( argv[ 4 ] ) : 2;
+  const uint64_t max_pieces = argc > 5 ? strtoull( argv[ 5 ], nullptr, 10 ) : 10000;
+  const bool place = argc > 6 && strcmp( argv[ 6 ], "place" ) == 0;
+  const size_t table_mb = argc > 7 ? strtoull( argv[ 7 ], nullptr, 10 ) : 0;
+
+  bot::SearchSettings settings;
+  settings.beam_width = beam_width;
+  settings.depth = depth;
+
+  bot::Autoplayer autoplayer{ settings };
+
+  std::unique_ptr< bot::TranspositionTable > table;
+  if( table_mb > 0 ) {
+    table = std::make_unique< bot::TranspositionTable >( table_mb );
+    autoplayer.set_table( table.get() );
+  }
+  game::Board board{ seed, game::randomizer_bag };
+
+  uint64_t total_pieces = 0;
+  uint64_t total_ticks = 0;
+  uint64_t total_lines = 0;
+  uint64_t total_score = 0;
+  uint64_t topped_out = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for( uint64_t game{}; game < games; ++game ) {
+    board.reset( seed + game );
+    autoplayer.reset();
+
+    uint64_t pieces = 0;
+
+    while( !board.is_game_over() && pieces < max_pieces ) {
+      if( place ) {
+        game::Placement placement;
+        if( !autoplayer.best_placement( board, placement ) ) {
+          break;
+        }
+
+        board.place( placement );
+        ++pieces;
+        continue;
+      }
+
+      const game::StepResult result = board.step( autoplayer.input( board ) );
+      autoplayer.observe( result );
+
+      ++total_ticks;
+
+      if( result.events & game::event_locked ) {
+        ++pieces;
+      }
+    }
+
+    total_pieces += pieces;
+    total_lines += board.lines_cleared();
+    total_score += board.score();
+
+    if( board.is_game_over() ) {
+      ++topped_out;
+    }
+
+    printf( "game %llu: %llu pieces, %d lines, score %d%s\n", ( unsigned long long ) game, ( unsigned long long ) pieces,
+      board.lines_cleared(), board.score(), board.is_game_over() ? " (topped out)" : "" );
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration< double >( end - start ).count();
+
+  printf( "games: %llu (%llu topped out)\n", ( unsigned long long ) games, ( unsigned long long ) topped_out );
+  printf( "pieces: %llu, lines: %llu, average score: %.2f\n", ( unsigned long long ) total_pieces, ( unsigned long long ) total_lines, ( double ) total_score / games );
+  printf( "ticks: %llu, replans: %llu\n", ( unsigned long long ) total_ticks, ( unsigned long long ) autoplayer.replans() );
+  printf( "time: %.3fs (%.0f pieces/s, %.1f us per search)\n", seconds, total_pieces / seconds, 1e6 * autoplayer.search_time() / autoplayer.searches() );
+
+  if( table ) {
+    const bot::TranspositionStats& stats = autoplayer.table_stats();
+    printf( "table: %zu entries, %llu probes, %.1f%% hits, %.1f ns per probe\n", table->capacity(),
+      ( unsigned long long ) stats.probes, 100.0 * stats.hit_rate(), stats.average_probe_ns() );
+  }
+
+  return 0;
+}
\ No newline at end of file
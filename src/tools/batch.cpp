@@ -0,0 +1,149 @@
+#include <sim/batch.hpp>
+#include <game/board.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//
+// Throughput benchmark for sim::BoardBatch.
+//
+//    usage: batch [boards] [ticks] [seed]
+//
+// Every board gets a pseudo random input which is held for 8 ticks at a time, boards that
+// top out are restarted straight away so the whole batch stays busy.
+//
+// Before the benchmark the first few boards are checked against game::Board, played with the
+// same seeds and inputs (hard drops included) and compared cell for cell every tick, exits with
+// 1 if they ever differ.
+//
+
+static uint32_t xorshift( uint32_t& random ) {
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+
+  return random;
+}
+
+// Returns the number of ticks a board in the batch and its game::Board differed on.
+static uint64_t check( const size_t boards, const uint64_t ticks, const uint64_t seed ) {
+  sim::BoardBatch batch{ boards, seed };
+  std::vector< game::Board > reference;
+  std::vector< uint8_t > inputs( boards );
+
+  for( size_t board{}; board < boards; ++board ) {
+    reference.emplace_back( seed + board );
+  }
+
+  uint32_t random = 0x2545F491;
+  uint64_t games = 0;
+  uint64_t mismatches = 0;
+
+  for( uint64_t tick{}; tick < ticks; ++tick ) {
+    if( ( tick & 7 ) == 0 ) {
+      for( size_t board{}; board < boards; ++board ) {
+        const uint32_t value = xorshift( random );
+
+        inputs[ board ] = value & ( game::input_left | game::input_right | game::input_rotate | game::input_soft_drop );
+        if( ( ( value >> 8 ) & 7 ) == 0 ) {
+          inputs[ board ] |= game::input_hard_drop;
+        }
+      }
+    }
+
+    batch.step( inputs.data() );
+
+    for( size_t board{}; board < boards; ++board ) {
+      game::Board& other = reference[ board ];
+      const game::StepResult result = other.step( inputs[ board ] );
+
+      bool same = batch.events( board ) == result.events &&
+        batch.cleared_lines( board ) == result.cleared_lines &&
+        batch.tetromino( board ) == other.tetromino() &&
+        batch.rotation( board ) == other.rotation() &&
+        batch.position_x( board ) == other.position_x() &&
+        batch.position_y( board ) == other.position_y() &&
+        batch.score( board ) == other.score() &&
+        batch.level( board ) == other.level() &&
+        batch.lines_cleared( board ) == other.lines_cleared() &&
+        batch.is_game_over( board ) == other.is_game_over();
+
+      for( int y{}; y < sim::BoardBatch::HEIGHT && same; ++y ) {
+        same = batch.line( board, y ) == other.line( y );
+      }
+
+      if( !same && mismatches++ < 10 ) {
+        printf( "check: board %zu differs on tick %llu\n", board, ( unsigned long long ) tick );
+      }
+
+      if( result.events & game::event_game_over ) {
+        const uint64_t next = seed + boards + games++;
+
+        batch.reset( board, next );
+        other.reset( next );
+      }
+    }
+  }
+
+  printf( "check: %zu boards, %llu ticks, %llu games, %llu mismatches\n", boards, ( unsigned long long ) ticks,
+    ( unsigned long long ) games, ( unsigned long long ) mismatches );
+
+  return mismatches;
+}
+
+int main( int argc, char* argv[] ) {
+  const size_t boards = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 4096;
+  const uint64_t ticks = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 10000;
+  const uint64_t seed = argc > 3 ? strtoull( argv[ 3 ], nullptr, 10 ) : 0;
+
+  if( check( std::min< size_t >( boards, 64 ), std::min< uint64_t >( ticks, 20000 ), seed ) != 0 ) {
+    return 1;
+  }
+
+  sim::BoardBatch batch{ boards, seed };
+  std::vector< uint8_t > inputs( boards );
+
+  uint32_t random = 0x9E3779B9;
+
+  uint64_t games = 0;
+  uint64_t total_score = 0;
+  uint64_t total_lines = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for( uint64_t tick{}; tick < ticks; ++tick ) {
+    if( ( tick & 7 ) == 0 ) {
+      for( size_t board{}; board < boards; ++board ) {
+        inputs[ board ] = xorshift( random ) & ( game::input_left | game::input_right | game::input_rotate | game::input_soft_drop );
+      }
+    }
+
+    batch.step( inputs.data() );
+
+    for( size_t board{}; board < boards; ++board ) {
+      if( batch.events( board ) & game::event_game_over ) {
+        ++games;
+        total_score += batch.score( board );
+        total_lines += batch.lines_cleared( board );
+
+        batch.reset( board, seed + boards + games );
+      }
+    }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration< double >( end - start ).count();
+  const double board_ticks = ( double ) boards * ticks;
+
+  printf( "boards: %zu\n", boards );
+  printf( "ticks: %llu\n", ( unsigned long long ) ticks );
+  printf( "games: %llu\n", ( unsigned long long ) games );
+  printf( "average score: %.2f\n", games ? ( double ) total_score / games : 0.0 );
+  printf( "average lines: %.2f\n", games ? ( double ) total_lines / games : 0.0 );
+  printf( "time: %.3fs (%.0f board-ticks/s)\n", seconds, board_ticks / seconds );
+
+  return 0;
+}
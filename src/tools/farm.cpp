@@ -0,0 +1,41 @@
+#include <sim/farm.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+//
+// Plays a range of seeded games across every core with sim::GameFarm.
+//
+//    usage: farm [games] [threads] [first_seed] [max_ticks]
+//
+// The digest only depends on the seeds played, running with a different number of threads
+// must print the same one.
+//
+
+int main( int argc, char* argv[] ) {
+  sim::FarmSettings settings;
+  settings.num_games = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 1000;
+  settings.num_threads = argc > 2 ? atoi( argv[ 2 ] ) : 0;
+  settings.first_seed = argc > 3 ? strtoull( argv[ 3 ], nullptr, 10 ) : 0;
+  settings.max_ticks = argc > 4 ? strtoull( argv[ 4 ], nullptr, 10 ) : settings.max_ticks;
+
+  const sim::GameFarm farm{ settings };
+  const sim::FarmReport report = farm.run();
+
+  const double games = ( double ) report.games.size();
+
+  printf( "games: %zu (seeds %llu - %llu)\n", report.games.size(), ( unsigned long long ) settings.first_seed, ( unsigned long long ) ( settings.first_seed + settings.num_games - 1 ) );
+  printf( "ticks: %llu\n", ( unsigned long long ) report.total_ticks );
+  printf( "average score: %.2f\n", games ? report.total_score / games : 0.0 );
+  printf( "average lines: %.2f\n", games ? report.total_lines / games : 0.0 );
+  printf( "best score: %d (seed %llu)\n", report.max_score, ( unsigned long long ) report.max_score_seed );
+  printf( "digest: %016llx\n", ( unsigned long long ) report.digest );
+  printf( "time: %.3fs (%.0f ticks/s, %.0f games/s)\n", report.seconds, report.total_ticks / report.seconds, games / report.seconds );
+
+  for( size_t i{}; i < report.workers.size(); ++i ) {
+    const sim::WorkerReport& worker = report.workers[ i ];
+    printf( "  thread %zu: %llu games, %llu ticks, %llu steals\n", i, ( unsigned long long ) worker.games, ( unsigned long long ) worker.ticks, ( unsigned long long ) worker.steals );
+  }
+
+  return 0;
+}
\ No newline at end of file
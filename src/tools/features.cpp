@@ -0,0 +1,129 @@
+#include <bot/features.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//
+// Checks bot::extract_features_batch against the scalar bot::extract_features and benchmarks both.
+//
+//    usage: features [boards] [seed] [repeats]
+//
+// Half the boards come from games of random placements, so they look like boards a search
+// scores, the other half are random noise to get at the edge cases (holes under overhangs, full
+// lines, empty columns). Exits with 1 if any board's features differ.
+//
+
+static bool same( const bot::Features& a, const bot::Features& b, const int width ) {
+  for( int x{}; x < width; ++x ) {
+    if( a.column_heights[ x ] != b.column_heights[ x ] ) {
+      return false;
+    }
+  }
+
+  return a.aggregate_height == b.aggregate_height &&
+    a.holes == b.holes &&
+    a.bumpiness == b.bumpiness &&
+    a.wells == b.wells &&
+    a.row_transitions == b.row_transitions &&
+    a.column_transitions == b.column_transitions;
+}
+
+int main( int argc, char* argv[] ) {
+  const size_t count = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 10000;
+  const uint64_t seed = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 0;
+  const int repeats = argc > 3 ? atoi( argv[ 3 ] ) : 100;
+
+  game::Board board{ seed, game::randomizer_bag };
+  game::Random random{ seed };
+  game::PlacementList placements;
+
+  const int width = board.rows();
+  const int height = board.columns();
+
+  std::vector< uint32_t > lines( count * height );
+
+  for( size_t i{}; i < count; ++i ) {
+    uint32_t* out = lines.data() + i * height;
+
+    if( i % 2 == 0 ) {
+      board.find_placements( placements );
+
+      if( board.is_game_over() || placements.empty() ) {
+        board.reset( seed + i );
+        board.find_placements( placements );
+      }
+
+      board.place( placements[ random.next_below( ( uint32_t ) placements.size() ) ] );
+
+      for( int y{}; y < height; ++y ) {
+        out[ y ] = board.line( y );
+      }
+    }
+    else {
+      // Emptier towards the top.
+      for( int y{}; y < height; ++y ) {
+        out[ y ] = random.next() & random.next() & ( y < height / 2 ? random.next() : ~0u ) & ( ( 1u << width ) - 1 );
+      }
+    }
+  }
+
+  //
+  // Check.
+  //
+  std::vector< bot::Features > scalar( count );
+  std::vector< bot::Features > batch( count );
+
+  for( size_t i{}; i < count; ++i ) {
+    scalar[ i ] = bot::extract_features( lines.data() + i * height, width, height );
+  }
+
+  bot::extract_features_batch( lines.data(), width, height, count, batch.data() );
+
+  size_t mismatches = 0;
+
+  for( size_t i{}; i < count; ++i ) {
+    if( !same( scalar[ i ], batch[ i ], width ) ) {
+      if( mismatches++ < 10 ) {
+        printf( "board %zu: scalar %d %d %d %d %d %d, batch %d %d %d %d %d %d\n", i,
+          scalar[ i ].aggregate_height, scalar[ i ].holes, scalar[ i ].bumpiness, scalar[ i ].wells, scalar[ i ].row_transitions, scalar[ i ].column_transitions,
+          batch[ i ].aggregate_height, batch[ i ].holes, batch[ i ].bumpiness, batch[ i ].wells, batch[ i ].row_transitions, batch[ i ].column_transitions );
+      }
+    }
+  }
+
+  printf( "%zu boards, %zu mismatches\n", count, mismatches );
+
+  //
+  // Benchmark.
+  //
+  int checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for( int repeat{}; repeat < repeats; ++repeat ) {
+    for( size_t i{}; i < count; ++i ) {
+      checksum += bot::extract_features( lines.data() + i * height, width, height ).holes;
+    }
+  }
+
+  const double scalar_seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  start = std::chrono::steady_clock::now();
+
+  for( int repeat{}; repeat < repeats; ++repeat ) {
+    bot::extract_features_batch( lines.data(), width, height, count, batch.data() );
+    checksum += batch[ repeat % count ].holes;
+  }
+
+  const double batch_seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  const double total = ( double ) count * repeats;
+
+  printf( "scalar: %.0f boards/s\n", total / scalar_seconds );
+  printf( "batch: %.0f boards/s (%.2fx)\n", total / batch_seconds, scalar_seconds / batch_seconds );
+  printf( "checksum: %d\n", checksum );
+
+  return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,564 @@
+#include <game/input.hpp>
+#include <game/random.hpp>
+#include <net/protocol.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//
+// Plays lots of games at once against a match server on loopback (see the match_server tool),
+// Linux only.
+//
+//    usage: loadgen [games] [seconds] [udp|tcp] [versus_percent] [port] [sockets]
+//
+// The games are spread over a few sockets (UDP) or connections (TCP) rather than one each, the
+// server tells them apart by game id. Every game joins (versus_percent of them as versus, paired
+// with each other), then changes its input every few ticks, mostly to nothing, and joins again
+// whenever its game finishes. Joins are spread over the first second and sent again if they go
+// unanswered.
+//
+// Before any of that, one versus match is joined as both players over one socket to check each
+// board only follows its own player's input. Every second it prints the games joined, the state
+// messages received, the games finished and how long joins took to be answered. The tool exits
+// with 1 if the check fails, fewer than nine in ten of the games were playing at the end or no
+// states were received.
+//
+
+static constexpr int TICKS_PER_SECOND = 60;
+
+struct ClientGame {
+  int socket;
+  uint8_t mode;
+
+  // Set once welcomed.
+  bool joined;
+  uint32_t game;
+  uint8_t player;
+
+  // When the last join went out, 0 for not yet.
+  double join_sent;
+
+  uint32_t sequence;
+  uint8_t input;
+  int hold;
+};
+
+struct Socket {
+  int fd;
+  std::vector< uint8_t > in;
+  std::vector< uint8_t > out;
+};
+
+struct Counters {
+  uint64_t joins;
+  uint64_t welcomes;
+  uint64_t full;
+  uint64_t states;
+  uint64_t results;
+  uint64_t sent;
+  double join_seconds;
+};
+
+static double seconds_now() {
+  return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static int open_socket( const bool tcp, const uint16_t port ) {
+  const int fd = socket( AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0 );
+  if( fd < 0 ) {
+    return -1;
+  }
+
+  sockaddr_in server{};
+  server.sin_family = AF_INET;
+  server.sin_port = htons( port );
+  server.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+  if( tcp ) {
+    const int one = 1;
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+  }
+  else {
+    const int buffer = 4 << 20;
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof( buffer ) );
+  }
+
+  // Connected even for UDP, so only the server's datagrams arrive.
+  if( connect( fd, ( const sockaddr* ) &server, sizeof( server ) ) != 0 ) {
+    close( fd );
+    return -1;
+  }
+
+  return fd;
+}
+
+// Sends a message straight away over UDP, queues it to go out on the next flush over TCP.
+static void send_message( const bool tcp, Socket& socket, const net::Message& message ) {
+  uint8_t data[ 2 + net::MAX_MESSAGE ];
+  const size_t size = net::write_message( message, data + 2 );
+
+  if( !tcp ) {
+    ::send( socket.fd, data + 2, size, MSG_DONTWAIT );
+    return;
+  }
+
+  data[ 0 ] = ( uint8_t ) size;
+  data[ 1 ] = ( uint8_t ) ( size >> 8 );
+  socket.out.insert( socket.out.end(), data, data + 2 + size );
+}
+
+static void flush_socket( Socket& socket ) {
+  size_t written = 0;
+
+  while( written < socket.out.size() ) {
+    const ssize_t count = ::send( socket.fd, socket.out.data() + written, socket.out.size() - written, MSG_DONTWAIT | MSG_NOSIGNAL );
+    if( count <= 0 ) {
+      break;
+    }
+
+    written += count;
+  }
+
+  socket.out.erase( socket.out.begin(), socket.out.begin() + written );
+}
+
+// Hands every whole message waiting on the socket to handle.
+template< typename Handler >
+static void receive_messages( const bool tcp, Socket& socket, Handler&& handle ) {
+  uint8_t buffer[ 65536 ];
+
+  for( ;; ) {
+    const ssize_t count = recv( socket.fd, buffer, sizeof( buffer ), MSG_DONTWAIT );
+    if( count <= 0 ) {
+      break;
+    }
+
+    net::Message message;
+
+    if( !tcp ) {
+      if( net::read_message( buffer, count, message ) ) {
+        handle( message );
+      }
+
+      continue;
+    }
+
+    socket.in.insert( socket.in.end(), buffer, buffer + count );
+  }
+
+  size_t offset = 0;
+
+  while( socket.in.size() - offset >= 2 ) {
+    const size_t size = socket.in[ offset ] | ( size_t ) socket.in[ offset + 1 ] << 8;
+    if( socket.in.size() - offset < 2 + size ) {
+      break;
+    }
+
+    net::Message message;
+    if( net::read_message( socket.in.data() + offset + 2, size, message ) ) {
+      handle( message );
+    }
+
+    offset += 2 + size;
+  }
+
+  socket.in.erase( socket.in.begin(), socket.in.begin() + offset );
+}
+
+class LoadGenerator {
+private:
+  bool m_tcp;
+  std::vector< Socket > m_sockets;
+  std::vector< ClientGame > m_games;
+  game::Random m_random;
+  Counters m_counters;
+
+  void send( const int socket, const net::Message& message ) {
+    send_message( m_tcp, m_sockets[ socket ], message );
+    ++m_counters.sent;
+  }
+
+  void flush() {
+    if( !m_tcp ) {
+      return;
+    }
+
+    for( Socket& socket : m_sockets ) {
+      flush_socket( socket );
+    }
+  }
+
+  void join( const uint32_t index, const double now ) {
+    ClientGame& game = m_games[ index ];
+
+    net::Message message{};
+    message.type = net::message_join;
+    message.tag = index;
+    message.mode = game.mode;
+
+    send( game.socket, message );
+
+    game.join_sent = now;
+    ++m_counters.joins;
+  }
+
+  void receive( const net::Message& message, const double now ) {
+    switch( message.type ) {
+      case net::message_welcome: {
+        if( message.tag >= m_games.size() ) {
+          break;
+        }
+
+        ClientGame& game = m_games[ message.tag ];
+
+        // A join sent again whose first answer made it after all, don't keep both games.
+        if( game.joined ) {
+          if( message.game != game.game ) {
+            net::Message leave{};
+            leave.type = net::message_leave;
+            leave.game = message.game;
+            leave.player = message.player;
+            send( game.socket, leave );
+          }
+
+          break;
+        }
+
+        game.joined = true;
+        game.game = message.game;
+        game.player = message.player;
+        game.sequence = 0;
+        game.input = game::input_none;
+        game.hold = 0;
+
+        ++m_counters.welcomes;
+        m_counters.join_seconds += now - game.join_sent;
+        break;
+      }
+
+      case net::message_full:
+        // Tried again once the join times out.
+        ++m_counters.full;
+        break;
+
+      case net::message_state:
+        ++m_counters.states;
+        break;
+
+      case net::message_result: {
+        // Both players of a versus match can be ours.
+        for( ClientGame& game : m_games ) {
+          if( game.joined && game.game == message.game ) {
+            game.joined = false;
+            game.join_sent = 0.0;
+            ++m_counters.results;
+          }
+        }
+
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  void receive_all( const double now ) {
+    for( Socket& socket : m_sockets ) {
+      receive_messages( m_tcp, socket, [ & ]( const net::Message& message ) { receive( message, now ); } );
+    }
+  }
+
+  // Mostly nothing, now and then a move, a rotation or a drop.
+  uint8_t pick_input() {
+    const uint32_t roll = m_random.next_below( 100 );
+
+    if( roll < 60 ) return game::input_none;
+    if( roll < 70 ) return game::input_left;
+    if( roll < 80 ) return game::input_right;
+    if( roll < 90 ) return game::input_rotate;
+    if( roll < 97 ) return game::input_soft_drop;
+    return game::input_hard_drop;
+  }
+
+public:
+  LoadGenerator( const bool tcp, const std::vector< int >& fds, const int games, const int versus_percent ) :
+    m_tcp( tcp ),
+    m_random( 1234 ),
+    m_counters{} {
+    for( const int fd : fds ) {
+      m_sockets.push_back( { fd, {}, {} } );
+    }
+
+    m_games.resize( games );
+
+    for( int i{}; i < games; ++i ) {
+      ClientGame& game = m_games[ i ];
+      game = {};
+      game.socket = i % ( int ) m_sockets.size();
+      game.mode = ( int ) m_random.next_below( 100 ) < versus_percent ? net::mode_versus : net::mode_marathon;
+    }
+  }
+
+  ~LoadGenerator() {
+    for( const Socket& socket : m_sockets ) {
+      close( socket.fd );
+    }
+  }
+
+  void tick( const double now ) {
+    receive_all( now );
+
+    // Joins are spread over a second, and sent again after one goes unanswered.
+    int joins = 0;
+    const int max_joins = std::max( 1, ( int ) m_games.size() / TICKS_PER_SECOND );
+
+    for( uint32_t index{}; index < m_games.size(); ++index ) {
+      ClientGame& game = m_games[ index ];
+
+      if( !game.joined ) {
+        if( joins < max_joins && ( game.join_sent == 0.0 || now - game.join_sent > 1.0 ) ) {
+          join( index, now );
+          ++joins;
+        }
+
+        continue;
+      }
+
+      // Every change (and every hold running out) sends the input, which keeps the game alive.
+      if( --game.hold > 0 ) {
+        continue;
+      }
+
+      game.input = pick_input();
+      game.hold = 4 + ( int ) m_random.next_below( 16 );
+
+      net::Message message{};
+      message.type = net::message_input;
+      message.game = game.game;
+      message.sequence = ++game.sequence;
+      message.player = game.player;
+      message.input = game.input;
+
+      send( game.socket, message );
+    }
+
+    flush();
+  }
+
+  // Leaves every game, so the server doesn't wait for them to time out.
+  void leave_all() {
+    for( ClientGame& game : m_games ) {
+      if( game.joined ) {
+        net::Message message{};
+        message.type = net::message_leave;
+        message.game = game.game;
+        message.player = game.player;
+        send( game.socket, message );
+      }
+    }
+
+    flush();
+  }
+
+  const int playing() const {
+    return ( int ) std::count_if( m_games.begin(), m_games.end(), []( const ClientGame& game ) { return game.joined; } );
+  }
+
+  const Counters& counters() const {
+    return m_counters;
+  }
+};
+
+// Joins one versus match as both of its players over a single socket, holds left for one of them
+// and nothing for the other for a second, then has the other leave. Passes if only the first
+// board moved and the one who left lost, i.e. the server went by the player named in each message
+// rather than where it came from.
+static bool check_players( const bool tcp, const uint16_t port ) {
+  const int fd = open_socket( tcp, port );
+  if( fd < 0 ) {
+    return false;
+  }
+
+  Socket socket{ fd, {}, {} };
+
+  // Indexed by tag, 0 holds left and 1 leaves.
+  bool welcomed[ 2 ]{};
+  uint32_t game[ 2 ]{};
+  uint8_t player[ 2 ]{};
+
+  // Indexed by player.
+  bool seen[ 2 ]{};
+  int spawn_x[ 2 ]{};
+  int x[ 2 ]{};
+  int won[ 2 ] = { -1, -1 };
+
+  const auto handle = [ & ]( const net::Message& message ) {
+    if( message.type == net::message_welcome && message.tag < 2 ) {
+      welcomed[ message.tag ] = true;
+      game[ message.tag ] = message.game;
+      player[ message.tag ] = message.player;
+      return;
+    }
+
+    if( !welcomed[ 0 ] || message.game != game[ 0 ] || message.player > 1 ) {
+      return;
+    }
+
+    if( message.type == net::message_state ) {
+      if( !seen[ message.player ] ) {
+        seen[ message.player ] = true;
+        spawn_x[ message.player ] = message.x;
+      }
+
+      x[ message.player ] = message.x;
+    }
+    else if( message.type == net::message_result ) {
+      won[ message.player ] = message.won;
+    }
+  };
+
+  for( uint32_t tag{}; tag < 2; ++tag ) {
+    net::Message join{};
+    join.type = net::message_join;
+    join.tag = tag;
+    join.mode = net::mode_versus;
+    send_message( tcp, socket, join );
+  }
+
+  uint32_t sequence = 0;
+  int held = 0;
+  bool left = false;
+
+  // Three seconds at most, a second of it holding.
+  for( int tick{}; tick < 3 * TICKS_PER_SECOND && won[ 0 ] < 0; ++tick ) {
+    flush_socket( socket );
+    std::this_thread::sleep_for( std::chrono::nanoseconds( 1000000000 / TICKS_PER_SECOND ) );
+    receive_messages( tcp, socket, handle );
+
+    if( !welcomed[ 0 ] || !welcomed[ 1 ] ) {
+      continue;
+    }
+
+    if( game[ 0 ] != game[ 1 ] ) {
+      printf( "player check: the two joins weren't paired with each other\n" );
+      break;
+    }
+
+    if( held < TICKS_PER_SECOND ) {
+      ++sequence;
+
+      for( int tag{}; tag < 2; ++tag ) {
+        net::Message input{};
+        input.type = net::message_input;
+        input.game = game[ tag ];
+        input.sequence = sequence;
+        input.player = player[ tag ];
+        input.input = tag == 0 ? game::input_left : game::input_none;
+        send_message( tcp, socket, input );
+      }
+
+      ++held;
+    }
+    else if( !left ) {
+      net::Message leave{};
+      leave.type = net::message_leave;
+      leave.game = game[ 1 ];
+      leave.player = player[ 1 ];
+      send_message( tcp, socket, leave );
+
+      left = true;
+    }
+  }
+
+  flush_socket( socket );
+  close( fd );
+
+  const int holding = player[ 0 ];
+  const int idle = player[ 1 ];
+
+  const bool moved = seen[ holding ] && x[ holding ] < spawn_x[ holding ];
+  const bool stayed = seen[ idle ] && x[ idle ] == spawn_x[ idle ];
+  const bool forfeit = won[ holding ] == 1 && won[ idle ] == 0;
+
+  printf( "player check: holding left moved x %d -> %d, idle stayed %d -> %d, %s\n", spawn_x[ holding ], x[ holding ],
+    spawn_x[ idle ], x[ idle ], forfeit ? "the one who left lost" : "no result for the one who left" );
+
+  return moved && stayed && forfeit;
+}
+
+int main( int argc, char* argv[] ) {
+  const int games = argc > 1 ? std::max( 1, atoi( argv[ 1 ] ) ) : 2000;
+  const int seconds = argc > 2 ? atoi( argv[ 2 ] ) : 10;
+  const bool tcp = argc > 3 && strcmp( argv[ 3 ], "tcp" ) == 0;
+  const int versus_percent = argc > 4 ? atoi( argv[ 4 ] ) : 50;
+  const uint16_t port = ( uint16_t ) ( argc > 5 ? atoi( argv[ 5 ] ) : 47100 );
+  const int socket_count = argc > 6 ? std::max( 1, atoi( argv[ 6 ] ) ) : 16;
+
+  if( !check_players( tcp, port ) ) {
+    return 1;
+  }
+
+  std::vector< int > fds;
+
+  for( int i{}; i < socket_count; ++i ) {
+    const int fd = open_socket( tcp, port );
+    if( fd < 0 ) {
+      printf( "couldn't connect to port %d: %s\n", port, strerror( errno ) );
+      return 1;
+    }
+
+    fds.push_back( fd );
+  }
+
+  LoadGenerator generator{ tcp, fds, games, versus_percent };
+
+  printf( "%d games (%d%% versus) over %d %s sockets to port %d\n", games, versus_percent, socket_count, tcp ? "tcp" : "udp", port );
+
+  const auto start = std::chrono::steady_clock::now();
+  const std::chrono::nanoseconds tick_length{ 1000000000 / TICKS_PER_SECOND };
+
+  Counters last{};
+
+  for( int tick = 1; tick <= seconds * TICKS_PER_SECOND; ++tick ) {
+    generator.tick( seconds_now() );
+
+    if( tick % TICKS_PER_SECOND == 0 ) {
+      const Counters& counters = generator.counters();
+      const uint64_t welcomes = counters.welcomes - last.welcomes;
+
+      printf( "%4d s: %d playing, %llu joins, %llu welcomed (%.1f ms), %llu full, %llu states, %llu results, %llu messages sent\n",
+        tick / TICKS_PER_SECOND, generator.playing(), ( unsigned long long ) ( counters.joins - last.joins ), ( unsigned long long ) welcomes,
+        welcomes ? ( counters.join_seconds - last.join_seconds ) * 1e3 / welcomes : 0.0, ( unsigned long long ) ( counters.full - last.full ),
+        ( unsigned long long ) ( counters.states - last.states ), ( unsigned long long ) ( counters.results - last.results ),
+        ( unsigned long long ) ( counters.sent - last.sent ) );
+
+      fflush( stdout );
+      last = counters;
+    }
+
+    std::this_thread::sleep_until( start + tick_length * tick );
+  }
+
+  const int playing = generator.playing();
+  const Counters& counters = generator.counters();
+
+  generator.leave_all();
+
+  printf( "%d of %d games playing at the end, %llu states and %llu results received\n", playing, games,
+    ( unsigned long long ) counters.states, ( unsigned long long ) counters.results );
+
+  return playing * 10 >= games * 9 && counters.states > 0 ? 0 : 1;
+}
\ No newline at end of file
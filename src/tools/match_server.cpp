@@ -0,0 +1,101 @@
+#include <net/server.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//
+// Runs a net::MatchServer and reports on it once a second, Linux only.
+//
+//    usage: match_server [port] [shards] [seconds] [state_interval]
+//
+// shards 0 runs one on every hardware thread, seconds 0 runs until interrupted. Every second it
+// prints the games and players hosted, how many games were stepped, how long a game tick took
+// and how busy each shard was, and from those how many games one core could keep at 60 ticks a
+// second. See the loadgen tool for something to connect to it.
+//
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt( int ) {
+  interrupted = 1;
+}
+
+int main( int argc, char* argv[] ) {
+  net::ServerSettings settings;
+  settings.port = ( uint16_t ) ( argc > 1 ? atoi( argv[ 1 ] ) : 47100 );
+  settings.shards = argc > 2 ? atoi( argv[ 2 ] ) : 0;
+  settings.state_interval = argc > 4 ? atoi( argv[ 4 ] ) : 6;
+
+  const int seconds = argc > 3 ? atoi( argv[ 3 ] ) : 0;
+
+  net::MatchServer server{ settings };
+
+  if( !server.start() ) {
+    printf( "couldn't listen on port %d\n", settings.port );
+    return 1;
+  }
+
+  signal( SIGINT, on_interrupt );
+  signal( SIGTERM, on_interrupt );
+
+  printf( "listening on udp and tcp port %d, %d shards\n", settings.port, server.shards() );
+
+  std::vector< net::ShardStats > last( server.shards() );
+
+  for( int shard{}; shard < server.shards(); ++shard ) {
+    last[ shard ] = server.stats( shard );
+  }
+
+  auto then = std::chrono::steady_clock::now();
+
+  for( int second = 1; !interrupted && ( seconds == 0 || second <= seconds ); ++second ) {
+    std::this_thread::sleep_until( then + std::chrono::seconds( 1 ) );
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration< double >( now - then ).count();
+    then = now;
+
+    net::ShardStats total{};
+    double busiest = 0.0;
+
+    for( int shard{}; shard < server.shards(); ++shard ) {
+      const net::ShardStats stats = server.stats( shard );
+      const net::ShardStats& before = last[ shard ];
+
+      total.games += stats.games;
+      total.players += stats.players;
+      total.game_ticks += stats.game_ticks - before.game_ticks;
+      total.dropped_ticks += stats.dropped_ticks - before.dropped_ticks;
+      total.tick_seconds += stats.tick_seconds - before.tick_seconds;
+      total.busy_seconds += stats.busy_seconds - before.busy_seconds;
+      total.games_finished += stats.games_finished - before.games_finished;
+      total.messages_received += stats.messages_received - before.messages_received;
+      total.messages_sent += stats.messages_sent - before.messages_sent;
+
+      busiest = std::max( busiest, ( stats.busy_seconds - before.busy_seconds ) / elapsed );
+
+      last[ shard ] = stats;
+    }
+
+    // The games a fully busy core could host, networking included.
+    const double games_per_core = total.busy_seconds > 0.0 ? total.game_ticks / total.busy_seconds / 60.0 : 0.0;
+
+    printf( "%4d s: %llu games, %llu players, %.0f game ticks/s, %.0f ns per game tick, busiest shard %.1f%%, %llu ticks dropped, "
+      "%.0f messages/s in, %.0f out, %llu finished, ~%.0f games per core\n",
+      second, ( unsigned long long ) total.games, ( unsigned long long ) total.players, total.game_ticks / elapsed,
+      total.game_ticks ? total.tick_seconds * 1e9 / total.game_ticks : 0.0, busiest * 100.0,
+      ( unsigned long long ) total.dropped_ticks, total.messages_received / elapsed, total.messages_sent / elapsed,
+      ( unsigned long long ) total.games_finished, games_per_core );
+
+    fflush( stdout );
+  }
+
+  server.stop();
+
+  return 0;
+}
\ No newline at end of file
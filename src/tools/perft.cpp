@@ -0,0 +1,107 @@
+#include <sim/perft.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+//
+// Placement generation counts and speed, see sim::perft.
+//
+//    usage: perft [threads]
+//           perft <seed> <depth> [threads] [uniform|bag|nes]
+//
+// With no arguments (or just a thread count) every case in the table below is run once on a
+// single thread and once on all threads and checked against the stored counts, any mismatch
+// means placement generation (collision tests, rotations, locking, line clears) has changed.
+//
+
+struct PerftCase {
+  uint64_t seed;
+  game::RandomizerType randomizer;
+  int depth;
+
+  uint64_t nodes;
+  uint64_t leaves;
+  uint64_t distinct;
+};
+
+static const PerftCase GOLDEN[] = {
+  { 0, game::randomizer_bag, 4, 394248, 383074, 378095 },
+  { 1, game::randomizer_bag, 4, 195589, 189911, 189871 },
+  { 2, game::randomizer_uniform, 4, 55525, 49936, 46515 },
+  { 3, game::randomizer_nes, 4, 389764, 368779, 327603 },
+  { 4, game::randomizer_uniform, 3, 5635, 5320, 5320 },
+};
+
+static const char* randomizer_name( const game::RandomizerType randomizer ) {
+  switch( randomizer ) {
+    case game::randomizer_bag:
+      return "bag";
+    case game::randomizer_nes:
+      return "nes";
+    default:
+      return "uniform";
+  }
+}
+
+static void print_result( const sim::PerftResult& result, const int threads ) {
+  printf( "  %2d thread(s): nodes %llu, leaves %llu, distinct %llu, %.3fs (%.0f nodes/s)\n", threads,
+    ( unsigned long long ) result.nodes, ( unsigned long long ) result.leaves, ( unsigned long long ) result.distinct,
+    result.seconds, result.nodes / result.seconds );
+}
+
+int main( int argc, char* argv[] ) {
+  const int hardware_threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+  if( argc > 2 ) {
+    const uint64_t seed = strtoull( argv[ 1 ], nullptr, 10 );
+    const int depth = atoi( argv[ 2 ] );
+    const int threads = argc > 3 ? atoi( argv[ 3 ] ) : hardware_threads;
+
+    game::RandomizerType randomizer = game::randomizer_uniform;
+    if( argc > 4 && strcmp( argv[ 4 ], "bag" ) == 0 ) {
+      randomizer = game::randomizer_bag;
+    }
+    else if( argc > 4 && strcmp( argv[ 4 ], "nes" ) == 0 ) {
+      randomizer = game::randomizer_nes;
+    }
+
+    printf( "seed %llu, %s, depth %d\n", ( unsigned long long ) seed, randomizer_name( randomizer ), depth );
+    print_result( sim::perft( game::Board{ seed, randomizer }, depth, threads ), threads );
+    return 0;
+  }
+
+  const int threads = argc > 1 ? atoi( argv[ 1 ] ) : hardware_threads;
+
+  int failures = 0;
+  uint64_t total_nodes[ 2 ] = {};
+  double total_seconds[ 2 ] = {};
+
+  for( const PerftCase& test : GOLDEN ) {
+    printf( "seed %llu, %s, depth %d\n", ( unsigned long long ) test.seed, randomizer_name( test.randomizer ), test.depth );
+
+    const int thread_counts[ 2 ] = { 1, threads };
+
+    for( int i{}; i < 2; ++i ) {
+      const sim::PerftResult result = sim::perft( game::Board{ test.seed, test.randomizer }, test.depth, thread_counts[ i ] );
+      print_result( result, thread_counts[ i ] );
+
+      total_nodes[ i ] += result.nodes;
+      total_seconds[ i ] += result.seconds;
+
+      if( result.nodes != test.nodes || result.leaves != test.leaves || result.distinct != test.distinct ) {
+        printf( "  FAILED, expected nodes %llu, leaves %llu, distinct %llu\n",
+          ( unsigned long long ) test.nodes, ( unsigned long long ) test.leaves, ( unsigned long long ) test.distinct );
+        ++failures;
+      }
+    }
+  }
+
+  printf( "total: %.0f nodes/s on 1 thread, %.0f nodes/s on %d threads\n",
+    total_nodes[ 0 ] / total_seconds[ 0 ], total_nodes[ 1 ] / total_seconds[ 1 ], threads );
+  printf( failures ? "%d check(s) FAILED\n" : "all checks passed\n", failures );
+
+  return failures ? 1 : 0;
+}
\ No newline at end of file
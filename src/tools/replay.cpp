@@ -0,0 +1,396 @@
+#include <bot/autoplayer.hpp>
+#include <game/replay.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//
+// Records and plays back replays (see game::Replay) without a window.
+//
+//    usage: replay play <file> [repeats]
+//           replay record <file> [max_ticks] [seed] [uniform|bag|nes]
+//           replay index <file> <out> [keyframe_interval]
+//           replay seek <file> <tick> [seeks]
+//
+// play runs the replay to the end as fast as it can (repeats times, for timing), prints where
+// the game ended up and exits with 1 if that's not where the recording ended, e.g. a replay
+// saved by the game on another build.
+//
+// record has the autoplayer play a game, with the odd pause thrown in, until it tops out or runs
+// for max_ticks, and saves it. It's a weak setting of the bot, so a game runs through line
+// clears, level changes and plenty of bag refills before it ends.
+//
+// index rewrites a replay as a game::SeekableReplay with a keyframe every keyframe_interval ticks.
+//
+// seek maps a seekable replay into memory, jumps to tick and prints the board there, then times
+// seeks to random ticks (seeks of them) and checks a few of them against playing the replay from
+// the start. Last it corrupts copies of a few keyframes one field at a time and checks none of
+// them open. It exits with 1 if any seek differs or any corrupt copy opens.
+//
+
+static int play( const char* path, const int repeats ) {
+  game::Replay replay;
+  if( !replay.load( path ) ) {
+    printf( "couldn't read %s\n", path );
+    return 1;
+  }
+
+  game::ReplayPlayer player( replay );
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for( int repeat{}; repeat < repeats; ++repeat ) {
+    player.restart();
+    player.run( replay.size() );
+  }
+
+  const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  const game::Board& board = player.board();
+
+  printf( "seed: %llu\n", ( unsigned long long ) replay.seed() );
+  printf( "ticks: %zu (%llu played)\n", replay.size(), ( unsigned long long ) board.ticks() );
+  printf( "score: %d (recorded %d)\n", board.score(), replay.score() );
+  printf( "lines: %d (recorded %d)\n", board.lines_cleared(), replay.lines() );
+  printf( "hash: %016llx (recorded %016llx)\n", ( unsigned long long ) board.hash(), ( unsigned long long ) replay.hash() );
+  printf( "time: %.3fs (%.0f ticks/s)\n", seconds, ( double ) replay.size() * repeats / seconds );
+
+  if( !player.matches() ) {
+    printf( "playback doesn't match the recording\n" );
+    return 1;
+  }
+
+  printf( "playback matches the recording\n" );
+  return 0;
+}
+
+static int record( const char* path, const uint64_t max_ticks, const uint64_t seed, const game::RandomizerType randomizer ) {
+  game::Board board{ seed, randomizer, 3 };
+
+  game::Replay replay;
+  replay.start( board );
+
+  // A weak bot, so games clear lines and go up levels but still end.
+  bot::SearchSettings settings;
+  settings.beam_width = 2;
+  settings.depth = 1;
+
+  bot::Autoplayer autoplayer{ settings };
+
+  uint32_t random = 0x9E3779B9 ^ ( uint32_t ) seed;
+  uint64_t paused = 0;
+
+  for( uint64_t tick{}; tick < max_ticks && !board.is_game_over(); ++tick ) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+
+    // Now and then a pause of up to half a second.
+    if( paused == 0 && random % 2048 == 0 ) {
+      paused = ( random >> 16 ) % 30 + 1;
+    }
+
+    if( paused > 0 ) {
+      --paused;
+      replay.record( game::input_pause );
+      continue;
+    }
+
+    const uint8_t input = autoplayer.input( board );
+    replay.record( input );
+    autoplayer.observe( board.step( input ) );
+  }
+
+  replay.finish( board );
+
+  if( !replay.save( path ) ) {
+    printf( "couldn't write %s\n", path );
+    return 1;
+  }
+
+  printf( "recorded %zu ticks, score %d, lines %d\n", replay.size(), board.score(), board.lines_cleared() );
+  return 0;
+}
+
+static int index_file( const char* path, const char* out, const int keyframe_interval ) {
+  game::Replay replay;
+  if( !replay.load( path ) ) {
+    printf( "couldn't read %s\n", path );
+    return 1;
+  }
+
+  if( !game::SeekableReplay::write( replay, out, keyframe_interval ) ) {
+    printf( "couldn't write %s\n", out );
+    return 1;
+  }
+
+  printf( "indexed %zu ticks, a keyframe every %d\n", replay.size(), keyframe_interval );
+  return 0;
+}
+
+//
+// A read only view of a whole file, mapped where the platform allows and read into memory where
+// it doesn't.
+//
+class MappedFile {
+private:
+  const uint8_t* m_data;
+  size_t m_size;
+  std::vector< uint8_t > m_buffer;
+  bool m_mapped;
+
+public:
+  MappedFile( const char* path ) :
+    m_data( nullptr ),
+    m_size( 0 ),
+    m_mapped( false ) {
+#if defined( __unix__ ) || defined( __APPLE__ )
+    const int fd = ::open( path, O_RDONLY );
+    if( fd >= 0 ) {
+      struct stat info;
+      if( fstat( fd, &info ) == 0 && info.st_size > 0 ) {
+        void* mapping = mmap( nullptr, ( size_t ) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( mapping != MAP_FAILED ) {
+          m_data = ( const uint8_t* ) mapping;
+          m_size = ( size_t ) info.st_size;
+          m_mapped = true;
+        }
+      }
+
+      close( fd );
+    }
+#endif
+
+    if( !m_mapped ) {
+      std::ifstream file( path, std::ios::binary );
+      m_buffer.assign( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+
+      m_data = m_buffer.data();
+      m_size = m_buffer.size();
+    }
+  }
+
+  ~MappedFile() {
+#if defined( __unix__ ) || defined( __APPLE__ )
+    if( m_mapped ) {
+      munmap( ( void* ) m_data, m_size );
+    }
+#endif
+  }
+
+  MappedFile( const MappedFile& ) = delete;
+  MappedFile& operator=( const MappedFile& ) = delete;
+
+  const uint8_t* data() const {
+    return m_data;
+  }
+
+  const size_t size() const {
+    return m_size;
+  }
+
+  const bool is_mapped() const {
+    return m_mapped;
+  }
+};
+
+static bool same_board( const game::Board& a, const game::Board& b ) {
+  return a.hash() == b.hash() && a.ticks() == b.ticks() && a.score() == b.score() &&
+    a.lines_cleared() == b.lines_cleared() && a.level() == b.level();
+}
+
+//
+// A field of a keyframe set to something out of range, offsets are from the start of the keyframe
+// (see the layout in replay.cpp).
+//
+struct Corruption {
+  const char* name;
+  std::vector< std::pair< size_t, uint8_t > > bytes;
+};
+
+static const std::vector< Corruption > CORRUPTIONS = {
+  { "tetromino", { { 8, 7 } } },
+  { "rotation", { { 9, 4 } } },
+  { "x past the right", { { 10, 0x20 }, { 11, 0x4E } } },
+  { "x past the left", { { 10, 0x00 }, { 11, 0x80 } } },
+  { "y past the bottom", { { 12, 0x20 }, { 13, 0x4E } } },
+  { "y above the top", { { 12, 0xF0 }, { 13, 0xFF } } },
+  { "level", { { 38, 0xFF }, { 39, 0xFF }, { 40, 0xFF }, { 41, 0xFF } } },
+  { "bag entry", { { 74, 7 }, { 81, 1 } } },
+  { "bag size", { { 81, 8 } } },
+  { "last tetromino", { { 82, 7 } } },
+  { "queue entry", { { 83, 7 } } },
+  { "queue start", { { 90, 7 } } },
+  { "cell", { { game::SeekableReplay::KEYFRAME_SIZE, 8 } } },
+};
+
+// Corrupts copies of the file at the first, middle and last keyframes, returns how many of them
+// open() took anyway (it should take none).
+static int check_corruptions( const uint8_t* data, const size_t size, const uint64_t keyframes ) {
+  const auto get = [ & ]( const size_t offset ) {
+    uint64_t value = 0;
+    for( int i{}; i < 8; ++i ) {
+      value |= ( uint64_t ) data[ offset + i ] << ( i * 8 );
+    }
+
+    return value;
+  };
+
+  // The index offset is the last field of the header before the results.
+  const uint64_t index = get( 40 );
+
+  int accepted = 0;
+  int tried = 0;
+
+  for( const uint64_t keyframe : { ( uint64_t ) 0, keyframes / 2, keyframes - 1 } ) {
+    const uint64_t offset = get( index + keyframe * 8 );
+
+    for( const Corruption& corruption : CORRUPTIONS ) {
+      std::vector< uint8_t > copy( data, data + size );
+
+      for( const auto& [ at, value ] : corruption.bytes ) {
+        copy[ offset + at ] = value;
+      }
+
+      game::SeekableReplay corrupt;
+      if( corrupt.open( copy.data(), copy.size() ) ) {
+        printf( "keyframe %llu with a bad %s was accepted\n", ( unsigned long long ) keyframe, corruption.name );
+        ++accepted;
+      }
+
+      ++tried;
+    }
+  }
+
+  printf( "corrupt keyframes: %d of %d rejected\n", tried - accepted, tried );
+  return accepted;
+}
+
+static int seek( const char* path, const uint64_t tick, const int seeks ) {
+  const MappedFile file( path );
+
+  game::SeekableReplay replay;
+  if( !replay.open( file.data(), file.size() ) ) {
+    printf( "couldn't read %s as a seekable replay\n", path );
+    return 1;
+  }
+
+  game::Board board = replay.make_board();
+  replay.seek( board, tick );
+
+  printf( "%s: %llu ticks, %llu keyframes every %d ticks\n", file.is_mapped() ? "mapped" : "read",
+    ( unsigned long long ) replay.size(), ( unsigned long long ) replay.keyframes(), replay.keyframe_interval() );
+
+  printf( "tick %llu: %llu board ticks, score %d, lines %d, level %d, hash %016llx\n",
+    ( unsigned long long ) std::min( tick, replay.size() ), ( unsigned long long ) board.ticks(),
+    board.score(), board.lines_cleared(), board.level(), ( unsigned long long ) board.hash() );
+
+  //
+  // Random seeks, timed.
+  //
+  uint32_t random = 0x9E3779B9;
+  uint64_t checksum = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for( int i{}; i < seeks; ++i ) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+
+    replay.seek( board, random % ( replay.size() + 1 ) );
+    checksum ^= board.hash();
+  }
+
+  const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  if( seeks > 0 ) {
+    printf( "seeks: %d in %.3fs (%.1f us each, checksum %016llx)\n", seeks, seconds, seconds * 1e6 / seeks, ( unsigned long long ) checksum );
+  }
+
+  //
+  // Checks, against playing every tick from the start.
+  //
+  game::Board linear = replay.make_board();
+  game::Board sought = replay.make_board();
+
+  uint64_t played = 0;
+  int mismatches = 0;
+
+  for( int check{}; check <= 64; ++check ) {
+    const uint64_t target = replay.size() * check / 64;
+
+    played = replay.play( linear, played, target - played );
+    replay.seek( sought, target );
+
+    if( !same_board( linear, sought ) ) {
+      printf( "tick %llu doesn't match playing from the start\n", ( unsigned long long ) target );
+      ++mismatches;
+    }
+  }
+
+  if( linear.hash() != replay.hash() || linear.score() != replay.score() || linear.lines_cleared() != replay.lines() ) {
+    printf( "playback doesn't match the recording\n" );
+    return 1;
+  }
+
+  printf( "%d mismatches\n", mismatches );
+
+  const int accepted = check_corruptions( file.data(), file.size(), replay.keyframes() );
+
+  return mismatches == 0 && accepted == 0 ? 0 : 1;
+}
+
+int main( int argc, char* argv[] ) {
+  const bool known = argc >= 3 && ( strcmp( argv[ 1 ], "play" ) == 0 || strcmp( argv[ 1 ], "record" ) == 0 ||
+    ( argc >= 4 && ( strcmp( argv[ 1 ], "index" ) == 0 || strcmp( argv[ 1 ], "seek" ) == 0 ) ) );
+
+  if( !known ) {
+    printf( "usage: replay play <file> [repeats]\n" );
+    printf( "       replay record <file> [max_ticks] [seed] [uniform|bag|nes]\n" );
+    printf( "       replay index <file> <out> [keyframe_interval]\n" );
+    printf( "       replay seek <file> <tick> [seeks]\n" );
+    return 1;
+  }
+
+  if( strcmp( argv[ 1 ], "play" ) == 0 ) {
+    return play( argv[ 2 ], argc > 3 ? std::max( 1, atoi( argv[ 3 ] ) ) : 1 );
+  }
+
+  if( strcmp( argv[ 1 ], "index" ) == 0 ) {
+    return index_file( argv[ 2 ], argv[ 3 ], argc > 4 ? std::max( 1, atoi( argv[ 4 ] ) ) : game::SeekableReplay::DEFAULT_KEYFRAME_INTERVAL );
+  }
+
+  if( strcmp( argv[ 1 ], "seek" ) == 0 ) {
+    return seek( argv[ 2 ], strtoull( argv[ 3 ], nullptr, 10 ), argc > 4 ? std::max( 0, atoi( argv[ 4 ] ) ) : 10000 );
+  }
+
+  const uint64_t max_ticks = argc > 3 ? strtoull( argv[ 3 ], nullptr, 10 ) : 1000000;
+  const uint64_t seed = argc > 4 ? strtoull( argv[ 4 ], nullptr, 10 ) : 0;
+
+  game::RandomizerType randomizer = game::randomizer_uniform;
+  if( argc > 5 ) {
+    if( strcmp( argv[ 5 ], "bag" ) == 0 ) {
+      randomizer = game::randomizer_bag;
+    }
+    else if( strcmp( argv[ 5 ], "nes" ) == 0 ) {
+      randomizer = game::randomizer_nes;
+    }
+  }
+
+  return record( argv[ 2 ], max_ticks, seed, randomizer );
+}
\ No newline at end of file
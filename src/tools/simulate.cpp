@@ -0,0 +1,153 @@
+#include <game/board.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//
+// Headless fast-forward of the board rules, no window, ImGui or audio involved.
+//
+//    usage: simulate [ticks] [seed] [uniform|bag|nes] [step|skip] [max_hold] [size] [idle_percent]
+//
+// Inputs are generated from a fixed xorshift sequence and held for 1 to max_hold ticks at a
+// time (16 by default) so pieces actually get moved around, rotated and soft dropped.
+// idle_percent of the holds (80 by default) are no keys at all, like a player waiting for the
+// piece to fall, which is where skipping ticks pays off. 0 holds some key down all the time.
+//
+// step calls Board::step for every tick, skip (the default) hands each held input to
+// Board::fast_forward which jumps over the ticks where nothing happens. Both play exactly the
+// same games so they print the same results, only the time differs.
+//
+// size is the board size as WxH, 10x20 (the default), 10x40 and 4x20 play on the boards fixed
+// at those sizes at compile time, anything else plays on a game::DynamicBoard.
+//
+
+struct Totals {
+  uint64_t games;
+  uint64_t score;
+  uint64_t lines;
+  uint64_t steps;
+};
+
+template< typename BoardType >
+Totals play( BoardType& board, const uint64_t ticks, const bool skip, const uint32_t max_hold, const uint32_t idle_percent ) {
+  uint32_t random = 0x9E3779B9;
+  uint8_t input = game::input_none;
+  uint64_t hold = 0;
+
+  const auto next = [ & ]() {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+  };
+
+  Totals totals{};
+
+  for( uint64_t tick{}; tick < ticks; ) {
+    if( hold == 0 ) {
+      const uint32_t keys = next();
+      const bool idle = next() % 100 < idle_percent;
+
+      input = idle ? ( uint8_t ) game::input_none : ( uint8_t ) ( keys & ( game::input_left | game::input_right | game::input_rotate | game::input_soft_drop ) );
+      hold = ( keys >> 8 ) % max_hold + 1;
+    }
+
+    game::StepResult result;
+    uint64_t advanced = 1;
+
+    if( skip ) {
+      advanced = board.fast_forward( input, std::min( hold, ticks - tick ), result );
+    }
+    else {
+      result = board.step( input );
+    }
+
+    tick += advanced;
+    hold -= advanced;
+    ++totals.steps;
+
+    if( result.events & game::event_game_over ) {
+      ++totals.games;
+      totals.score += board.score();
+      totals.lines += board.lines_cleared();
+
+      board.reset();
+    }
+  }
+
+  return totals;
+}
+
+int main( int argc, char* argv[] ) {
+  const uint64_t ticks = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 10000000;
+  const uint64_t seed = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 0;
+
+  game::RandomizerType randomizer = game::randomizer_uniform;
+  if( argc > 3 ) {
+    if( strcmp( argv[ 3 ], "bag" ) == 0 ) {
+      randomizer = game::randomizer_bag;
+    }
+    else if( strcmp( argv[ 3 ], "nes" ) == 0 ) {
+      randomizer = game::randomizer_nes;
+    }
+  }
+
+  const bool skip = !( argc > 4 && strcmp( argv[ 4 ], "step" ) == 0 );
+  const uint32_t max_hold = argc > 5 ? std::max( 1, atoi( argv[ 5 ] ) ) : 16;
+
+  int width = 10;
+  int height = 20;
+  if( argc > 6 && sscanf( argv[ 6 ], "%dx%d", &width, &height ) != 2 ) {
+    printf( "size should be WxH\n" );
+    return 1;
+  }
+
+  const uint32_t idle_percent = argc > 7 ? ( uint32_t ) std::clamp( atoi( argv[ 7 ] ), 0, 100 ) : 80;
+
+  if( width < 4 || width > game::BitBoard::MAX_WIDTH || height < 4 || height > game::BitBoard::MAX_HEIGHT ) {
+    printf( "sizes go from 4x4 up to %dx%d\n", game::BitBoard::MAX_WIDTH, game::BitBoard::MAX_HEIGHT );
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  Totals totals;
+  bool dynamic = false;
+
+  if( width == 10 && height == 20 ) {
+    game::Board board{ seed, randomizer };
+    totals = play( board, ticks, skip, max_hold, idle_percent );
+  }
+  else if( width == 10 && height == 40 ) {
+    game::TallBoard board{ seed, randomizer };
+    totals = play( board, ticks, skip, max_hold, idle_percent );
+  }
+  else if( width == 4 && height == 20 ) {
+    game::PuzzleBoard board{ seed, randomizer };
+    totals = play( board, ticks, skip, max_hold, idle_percent );
+  }
+  else {
+    game::DynamicBoard board{ width, height, seed, randomizer };
+    totals = play( board, ticks, skip, max_hold, idle_percent );
+    dynamic = true;
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration< double >( end - start ).count();
+
+  const uint64_t games = totals.games;
+
+  printf( "board: %dx%d%s\n", width, height, dynamic ? " (dynamic)" : "" );
+  printf( "inputs: held up to %u ticks, %u%% idle\n", max_hold, idle_percent );
+  printf( "ticks: %llu\n", ( unsigned long long ) ticks );
+  printf( "games: %llu\n", ( unsigned long long ) games );
+  printf( "average score: %.2f\n", games ? ( double ) totals.score / games : 0.0 );
+  printf( "average lines: %.2f\n", games ? ( double ) totals.lines / games : 0.0 );
+  printf( "steps: %llu (%.2f ticks per step)\n", ( unsigned long long ) totals.steps, ( double ) ticks / totals.steps );
+  printf( "time: %.3fs (%.0f ticks/s)\n", seconds, ticks / seconds );
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include <bot/autoplayer.hpp>
+#include <game/board_stream.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//
+// Checks and benchmarks the delta encoded board stream (see game::BoardStreamEncoder).
+//
+//    usage: stream [games] [seed] [resync_interval] [repeats]
+//
+// The autoplayer plays games one tick at a time and every tick is encoded into one stream, a
+// new game starting with a resync. While encoding, a decoder follows the stream and the board
+// it rebuilds is compared against the real one after every frame, and a second decoder joins
+// each game from its last resync and is compared at the end. The tool exits with 1 on any
+// difference.
+//
+// Then the recorded inputs are played again (repeats times) to time stepping the boards with
+// and without encoding, and the stream is decoded to time the decoder. Throughput is given
+// against the 200 bytes a tick a full 10 x 20 grid snapshot would take.
+//
+
+static constexpr double SNAPSHOT_BYTES = 10 * 20;
+
+static bool same( const game::StreamedBoard& streamed, const game::Board& board ) {
+  if( streamed.width != board.rows() || streamed.height != board.columns() || streamed.ticks != board.ticks() ) {
+    return false;
+  }
+
+  const game::PieceState& piece = board.piece();
+  if( streamed.piece.type != piece.type || streamed.piece.rotation != piece.rotation || streamed.piece.x != piece.x || streamed.piece.y != piece.y ) {
+    return false;
+  }
+
+  if( streamed.score != board.score() || streamed.lines_cleared != board.lines_cleared() || streamed.level != board.level() ||
+    streamed.game_over != board.is_game_over() ) {
+    return false;
+  }
+
+  for( int n{}; n < streamed.preview_size; ++n ) {
+    if( streamed.preview[ n ] != board.preview( n ) ) {
+      return false;
+    }
+  }
+
+  for( int y{}; y < board.columns(); ++y ) {
+    if( streamed.lines[ y ] != board.line( y ) ) {
+      return false;
+    }
+
+    for( int x{}; x < board.rows(); ++x ) {
+      if( streamed.get( x, y ) != board.get_state( x, y ) ) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+int main( int argc, char* argv[] ) {
+  using namespace std::chrono;
+
+  const uint64_t games = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 10;
+  const uint64_t seed = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 0;
+  const int resync_interval = argc > 3 ? atoi( argv[ 3 ] ) : game::BoardStreamEncoder::DEFAULT_RESYNC_INTERVAL;
+  const int repeats = argc > 4 ? std::max( 1, atoi( argv[ 4 ] ) ) : 20;
+
+  //
+  // Play and check.
+  //
+  bot::SearchSettings settings;
+  settings.beam_width = 4;
+
+  bot::Autoplayer autoplayer{ settings };
+  game::BoardStreamEncoder encoder{ resync_interval };
+  game::BoardStreamDecoder follower;
+
+  std::vector< std::vector< uint8_t > > inputs( games );
+
+  size_t decoded = 0;
+  uint64_t total_ticks = 0;
+  uint64_t frames = 0;
+  uint64_t mismatches = 0;
+
+  for( uint64_t game{}; game < games; ++game ) {
+    game::Board board{ seed + game, game::randomizer_bag, 3 };
+    autoplayer.reset();
+
+    while( !board.is_game_over() ) {
+      const uint8_t input = autoplayer.input( board );
+      inputs[ game ].push_back( input );
+
+      const game::StepResult result = board.step( input );
+      autoplayer.observe( result );
+
+      encoder.encode( board, result );
+
+      // Only whole frames are compared, pending idle ticks haven't been written yet.
+      const size_t used = follower.decode( encoder.data().data() + decoded, encoder.data().size() - decoded );
+      if( used > 0 ) {
+        decoded += used;
+        ++frames;
+        mismatches += same( follower.board(), board ) ? 0 : 1;
+      }
+    }
+
+    // Both decoders have to end up on the final board, the joining one from the last resync.
+    encoder.flush();
+    decoded += follower.decode( encoder.data().data() + decoded, encoder.data().size() - decoded );
+
+    game::BoardStreamDecoder joiner;
+    const size_t from = encoder.resync_offset();
+    joiner.decode( encoder.data().data() + from, encoder.data().size() - from );
+
+    mismatches += same( follower.board(), board ) ? 0 : 1;
+    mismatches += same( joiner.board(), board ) ? 0 : 1;
+    mismatches += follower.error() || joiner.error() ? 1 : 0;
+
+    total_ticks += board.ticks();
+  }
+
+  const std::vector< uint8_t > stream = encoder.data();
+
+  //
+  // Time stepping on its own and with encoding, the lowest of the repeats.
+  //
+  double step_seconds = 1e9;
+  double encode_seconds = 1e9;
+
+  for( int repeat{}; repeat < repeats; ++repeat ) {
+    uint64_t checksum = 0;
+
+    auto start = steady_clock::now();
+
+    for( uint64_t game{}; game < games; ++game ) {
+      game::Board board{ seed + game, game::randomizer_bag, 3 };
+      for( const uint8_t input : inputs[ game ] ) {
+        checksum += board.step( input ).events;
+      }
+
+      checksum += board.hash();
+    }
+
+    step_seconds = std::min( step_seconds, duration< double >( steady_clock::now() - start ).count() );
+
+    encoder.clear();
+    start = steady_clock::now();
+
+    for( uint64_t game{}; game < games; ++game ) {
+      game::Board board{ seed + game, game::randomizer_bag, 3 };
+      for( const uint8_t input : inputs[ game ] ) {
+        encoder.encode( board, board.step( input ) );
+      }
+    }
+
+    encoder.flush();
+    encode_seconds = std::min( encode_seconds, duration< double >( steady_clock::now() - start ).count() );
+
+    // Keeps the step loop from being optimised out.
+    if( checksum == 0 ) {
+      printf( "nothing happened\n" );
+    }
+  }
+
+  if( encoder.data() != stream ) {
+    printf( "encoding again gave a different stream\n" );
+    ++mismatches;
+  }
+
+  //
+  // Time decoding.
+  //
+  double decode_seconds = 1e9;
+  uint64_t decoded_ticks = 0;
+
+  for( int repeat{}; repeat < repeats; ++repeat ) {
+    game::BoardStreamDecoder decoder;
+    uint64_t ticks = 0;
+
+    const auto start = steady_clock::now();
+
+    const uint8_t* in = stream.data();
+    const uint8_t* end = stream.data() + stream.size();
+
+    while( in < end ) {
+      const uint64_t before = decoder.board().ticks;
+      in = decoder.decode_frame( in, end );
+
+      if( in == nullptr ) {
+        break;
+      }
+
+      // A resync starts a new game from its own tick count.
+      ticks += decoder.board().ticks > before ? decoder.board().ticks - before : decoder.board().ticks;
+    }
+
+    decode_seconds = std::min( decode_seconds, duration< double >( steady_clock::now() - start ).count() );
+    decoded_ticks = ticks;
+
+    if( in != end ) {
+      printf( "decoding stopped at byte %zu\n", ( size_t ) ( in ? in - stream.data() : 0 ) );
+      ++mismatches;
+    }
+  }
+
+  const double step_ns = step_seconds * 1e9 / total_ticks;
+  const double encode_ns = std::max( 0.0, encode_seconds - step_seconds ) * 1e9 / total_ticks;
+  const double decode_ns = decode_seconds * 1e9 / total_ticks;
+
+  printf( "games: %llu, ticks: %llu (%llu decoded), frames compared: %llu\n", ( unsigned long long ) games,
+    ( unsigned long long ) total_ticks, ( unsigned long long ) decoded_ticks, ( unsigned long long ) frames );
+  printf( "stream: %zu bytes, %.3f bytes/tick (snapshots: %.0f bytes/tick, %.0fx smaller)\n", stream.size(),
+    ( double ) stream.size() / total_ticks, SNAPSHOT_BYTES, SNAPSHOT_BYTES * total_ticks / stream.size() );
+  printf( "step: %.2f ns/tick, step + encode: %.2f ns/tick\n", step_ns, encode_seconds * 1e9 / total_ticks );
+  printf( "encode: %.2f ns/tick (%.1f GB/s of snapshots)\n", encode_ns, encode_ns > 0 ? SNAPSHOT_BYTES / encode_ns : 0.0 );
+  printf( "decode: %.2f ns/tick (%.1f GB/s of snapshots, %.2f GB/s of stream)\n", decode_ns, SNAPSHOT_BYTES / decode_ns,
+    stream.size() / decode_seconds / 1e9 );
+  printf( "%llu mismatches\n", ( unsigned long long ) mismatches );
+
+  return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <bot/autoplayer.hpp>
+#include <net/rollback.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+//
+// Plays a versus match between two autoplayers through two rollback sessions (see
+// net::RollbackSession) over a bad link, and checks they agree.
+//
+//    usage: versus [local|udp] [ticks] [latency_ms] [jitter_ms] [loss_percent] [max_rollback] [seed]
+//
+// local links the sessions in process, udp sends their datagrams over loopback (ports 47000 and
+// 47001). Either way each side's datagrams go through a ConditionedTransport adding the latency,
+// jitter and loss given. Time is simulated at 60 ticks a second, so a match runs as fast as the
+// boards and the bots allow.
+//
+// Once the match is over (or ticks have gone by) the sessions keep exchanging datagrams until
+// every input is confirmed, then both sessions' checksums are compared tick by tick, and against
+// the boards stepped with the confirmed inputs and no network at all. The tool exits with 1 if
+// anything differs.
+//
+
+static constexpr double TICKS_PER_SECOND = 60.0;
+
+struct Player {
+  std::unique_ptr< net::RollbackSession > session;
+  bot::Autoplayer autoplayer;
+
+  // Input held back by a stall, tried again next tick.
+  bool pending;
+  uint8_t input;
+
+  Player( const bot::SearchSettings& settings ) :
+    autoplayer( settings ),
+    pending( false ),
+    input( game::input_none ) {}
+
+  void tick() {
+    const int local = session->local_player();
+
+    if( !pending ) {
+      input = autoplayer.input( session->board( local ) );
+    }
+
+    pending = !session->advance( input );
+
+    if( !pending ) {
+      autoplayer.observe( session->local_result() );
+    }
+  }
+};
+
+static void report( const char* name, const net::RollbackSession& session, const net::ConditionedTransport& link, const double seconds ) {
+  const net::SessionStats& stats = session.stats();
+
+  printf( "%s: %llu ticks, %llu stalls, %llu mispredicted inputs\n", name, ( unsigned long long ) stats.ticks,
+    ( unsigned long long ) stats.stalls, ( unsigned long long ) stats.mispredictions );
+
+  printf( "  rollbacks: %llu (%.1f/s), %.2f ticks deep on average, %llu deepest\n", ( unsigned long long ) stats.rollbacks,
+    stats.rollbacks / seconds, stats.rollbacks ? ( double ) stats.rollback_ticks / stats.rollbacks : 0.0,
+    ( unsigned long long ) stats.max_rollback_depth );
+
+  printf( "  resimulation: %.3f ms total, %.2f us per rollback, %.3f%% of the frame time\n", stats.resimulate_seconds * 1e3,
+    stats.rollbacks ? stats.resimulate_seconds * 1e6 / stats.rollbacks : 0.0, 100.0 * stats.resimulate_seconds / seconds );
+
+  printf( "  datagrams: %llu sent (%llu dropped by the link), %llu received, %.0f bytes/s\n", ( unsigned long long ) stats.datagrams_sent,
+    ( unsigned long long ) link.dropped(), ( unsigned long long ) stats.datagrams_received, stats.bytes_sent / seconds );
+
+  printf( "  desyncs: %llu\n", ( unsigned long long ) stats.desyncs );
+}
+
+int main( int argc, char* argv[] ) {
+  const bool udp = argc > 1 && strcmp( argv[ 1 ], "udp" ) == 0;
+  const uint64_t ticks = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 36000;
+
+  net::LinkConditions conditions;
+  conditions.latency = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) / 1000.0;
+  conditions.jitter = ( argc > 4 ? atof( argv[ 4 ] ) : 10.0 ) / 1000.0;
+  conditions.loss = ( argc > 5 ? atof( argv[ 5 ] ) : 5.0 ) / 100.0;
+
+  net::SessionSettings settings;
+  settings.max_rollback = argc > 6 ? atoi( argv[ 6 ] ) : 12;
+  settings.seed = argc > 7 ? strtoull( argv[ 7 ], nullptr, 10 ) : 0;
+
+  //
+  // Links.
+  //
+  std::unique_ptr< net::Transport > ends[ 2 ];
+
+  if( udp ) {
+    auto first = std::make_unique< net::UdpTransport >( 47000, "127.0.0.1", 47001 );
+    auto second = std::make_unique< net::UdpTransport >( 47001, "127.0.0.1", 47000 );
+
+    if( !first->is_open() || !second->is_open() ) {
+      printf( "couldn't open udp ports 47000 and 47001\n" );
+      return 1;
+    }
+
+    ends[ 0 ] = std::move( first );
+    ends[ 1 ] = std::move( second );
+  }
+  else {
+    auto first = std::make_unique< net::LocalTransport >();
+    auto second = std::make_unique< net::LocalTransport >();
+    net::LocalTransport::connect( *first, *second );
+
+    ends[ 0 ] = std::move( first );
+    ends[ 1 ] = std::move( second );
+  }
+
+  net::ConditionedTransport links[ 2 ] = {
+    net::ConditionedTransport{ *ends[ 0 ], conditions, settings.seed * 2 + 1 },
+    net::ConditionedTransport{ *ends[ 1 ], conditions, settings.seed * 2 + 2 },
+  };
+
+  // Different bots, so the players don't press the same keys at the same time.
+  bot::SearchSettings strong;
+  bot::SearchSettings weak;
+  weak.beam_width = 2;
+  weak.depth = 1;
+
+  Player players[ 2 ] = { Player{ strong }, Player{ weak } };
+
+  for( int player{}; player < 2; ++player ) {
+    players[ player ].session = std::make_unique< net::RollbackSession >( links[ player ], player, settings );
+  }
+
+  //
+  // Play.
+  //
+  uint64_t tick = 0;
+
+  const auto over = [ & ]() {
+    return players[ 0 ].session->board( 0 ).is_game_over() && players[ 1 ].session->board( 1 ).is_game_over();
+  };
+
+  for( ; tick < ticks && !over(); ++tick ) {
+    for( int player{}; player < 2; ++player ) {
+      links[ player ].set_time( tick / TICKS_PER_SECOND );
+      players[ player ].session->poll();
+    }
+
+    for( Player& player : players ) {
+      player.tick();
+    }
+  }
+
+  const double seconds = tick / TICKS_PER_SECOND;
+
+  // Carry on exchanging datagrams until each side has every input of the other (one side may
+  // have stalled on the last tick, so they aren't always on the same tick).
+  const auto settled = [ & ]() {
+    for( int player{}; player < 2; ++player ) {
+      const net::RollbackSession& other = *players[ 1 - player ].session;
+
+      if( players[ player ].session->inputs( 1 - player ).size() < other.inputs( 1 - player ).size() ) {
+        return false;
+      }
+    }
+
+    return true;
+  };
+
+  for( uint64_t extra{}; extra < 60 * 60 && !settled(); ++extra, ++tick ) {
+    for( int player{}; player < 2; ++player ) {
+      links[ player ].set_time( tick / TICKS_PER_SECOND );
+      players[ player ].session->poll();
+      players[ player ].session->resend();
+    }
+  }
+
+  //
+  // Check.
+  //
+  const net::RollbackSession& first = *players[ 0 ].session;
+  const net::RollbackSession& second = *players[ 1 ].session;
+
+  uint64_t mismatches = settled() ? 0 : 1;
+
+  const uint64_t confirmed = std::min( first.confirmed_ticks(), second.confirmed_ticks() );
+
+  for( uint64_t t{}; t < confirmed; ++t ) {
+    mismatches += first.checksum( t ) != second.checksum( t ) ? 1 : 0;
+  }
+
+  // The same match with no network.
+  game::Board reference[ 2 ] = {
+    game::Board{ settings.seed, settings.randomizer, settings.preview_size },
+    game::Board{ settings.seed, settings.randomizer, settings.preview_size },
+  };
+
+  for( uint64_t t{}; t < confirmed; ++t ) {
+    reference[ 0 ].step( first.inputs( 0 )[ t ] );
+    reference[ 1 ].step( second.inputs( 1 )[ t ] );
+  }
+
+  if( confirmed > 0 && net::RollbackSession::make_checksum( reference ) != first.checksum( confirmed - 1 ) ) {
+    ++mismatches;
+  }
+
+  printf( "%s link: %.0f ms latency, %.0f ms jitter, %.1f%% loss, max rollback %d ticks\n", udp ? "udp" : "local",
+    conditions.latency * 1e3, conditions.jitter * 1e3, conditions.loss * 100.0, settings.max_rollback );
+
+  printf( "match: %llu ticks (%.1f s), %llu confirmed, scores %d and %d\n", ( unsigned long long ) first.tick(), seconds,
+    ( unsigned long long ) confirmed, first.board( 0 ).score(), first.board( 1 ).score() );
+
+  report( "player 0", first, links[ 0 ], seconds );
+  report( "player 1", second, links[ 1 ], seconds );
+
+  printf( "%llu mismatches\n", ( unsigned long long ) mismatches );
+
+  return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file
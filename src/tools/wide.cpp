@@ -0,0 +1,219 @@
+#include <game/board.hpp>
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//
+// Benchmarks boards from 10 up to 128 cells wide, see game::WideBoard.
+//
+//    usage: wide [ticks] [clears] [seed]
+//
+// For each width it reports:
+//
+//    tick    time per Board::step with random held inputs, dominated by collision tests.
+//    clear   time to copy a board with 4 full lines out of 20 and clear them with the line masks.
+//    scan    time to find the same full lines cell by cell, what a board without line masks
+//            would pay.
+//
+// Before timing, clears on random boards are checked cell by cell against a plain compaction,
+// the tool exits with 1 if any differ.
+//
+
+static constexpr int HEIGHT = 20;
+
+struct WidthResult {
+  int width;
+  int line_bytes;
+  size_t mismatches;
+  double tick_ns;
+  double clear_ns;
+  double scan_ns;
+};
+
+template< int W >
+void fill_random( game::BasicBitBoard< W, HEIGHT >& bits, game::Random& random ) {
+  bits.clear();
+
+  for( int y{}; y < HEIGHT; ++y ) {
+    // A few full lines, the rest with holes and emptier towards the top.
+    const bool full = random.next_below( 5 ) == 0;
+
+    for( int x{}; x < W; ++x ) {
+      if( full || random.next_below( HEIGHT ) < ( uint32_t ) y ) {
+        bits.set( x, y, 1 + random.next_below( 7 ) );
+      }
+    }
+  }
+}
+
+// Clears full lines cell by cell with get/set and checks the result against clear_full_lines.
+template< int W >
+bool check_clear( game::BasicBitBoard< W, HEIGHT > bits ) {
+  int cells[ HEIGHT ][ W ];
+  int destination = HEIGHT - 1;
+
+  for( int y = HEIGHT - 1; y >= 0; --y ) {
+    bool full = true;
+    for( int x{}; x < W; ++x ) {
+      full &= bits.get( x, y ) != 0;
+    }
+
+    if( full ) {
+      continue;
+    }
+
+    for( int x{}; x < W; ++x ) {
+      cells[ destination ][ x ] = bits.get( x, y );
+    }
+
+    --destination;
+  }
+
+  for( ; destination >= 0; --destination ) {
+    for( int x{}; x < W; ++x ) {
+      cells[ destination ][ x ] = 0;
+    }
+  }
+
+  bits.clear_full_lines();
+
+  for( int y{}; y < HEIGHT; ++y ) {
+    for( int x{}; x < W; ++x ) {
+      if( bits.get( x, y ) != cells[ y ][ x ] || game::line_test( bits.line( y ), x ) != ( cells[ y ][ x ] != 0 ) ) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+template< int W >
+WidthResult run( const uint64_t ticks, const int clears, const uint64_t seed ) {
+  using namespace std::chrono;
+
+  WidthResult result{};
+  result.width = W;
+  result.line_bytes = ( int ) sizeof( typename game::BasicBitBoard< W, HEIGHT >::line_t );
+
+  //
+  // Check.
+  //
+  game::Random random{ seed };
+  game::BasicBitBoard< W, HEIGHT > bits;
+
+  for( int i{}; i < 1000; ++i ) {
+    fill_random( bits, random );
+    result.mismatches += check_clear( bits ) ? 0 : 1;
+  }
+
+  //
+  // Ticks.
+  //
+  game::BasicBoard< W, HEIGHT > board{ seed, game::randomizer_bag };
+
+  uint32_t input_random = 0x9E3779B9;
+  uint8_t input = game::input_none;
+  uint32_t hold = 0;
+  uint64_t events = 0;
+
+  auto start = steady_clock::now();
+
+  for( uint64_t tick{}; tick < ticks; ++tick ) {
+    if( hold == 0 ) {
+      input_random ^= input_random << 13;
+      input_random ^= input_random >> 17;
+      input_random ^= input_random << 5;
+
+      input = input_random & ( game::input_left | game::input_right | game::input_rotate | game::input_soft_drop );
+      hold = ( input_random >> 8 ) % 16 + 1;
+    }
+
+    --hold;
+
+    const game::StepResult step = board.step( input );
+    events += step.events;
+
+    if( step.events & game::event_game_over ) {
+      board.reset();
+    }
+  }
+
+  result.tick_ns = duration< double, std::nano >( steady_clock::now() - start ).count() / ticks;
+
+  //
+  // Clears, the same board is copied and cleared over and over.
+  //
+  game::BasicBitBoard< W, HEIGHT > prepared;
+  prepared.clear();
+
+  for( int y{}; y < HEIGHT; ++y ) {
+    for( int x{}; x < W; ++x ) {
+      if( y % 5 == 4 || ( x + y ) % 3 != 0 ) {
+        prepared.set( x, y, 1 );
+      }
+    }
+  }
+
+  uint64_t cleared = 0;
+
+  start = steady_clock::now();
+
+  for( int i{}; i < clears; ++i ) {
+    game::BasicBitBoard< W, HEIGHT > copy = prepared;
+    cleared += std::popcount( copy.clear_full_lines() );
+  }
+
+  result.clear_ns = duration< double, std::nano >( steady_clock::now() - start ).count() / clears;
+
+  start = steady_clock::now();
+
+  for( int i{}; i < clears; ++i ) {
+    for( int y{}; y < HEIGHT; ++y ) {
+      bool full = true;
+      for( int x{}; x < W && full; ++x ) {
+        full = prepared.get( x, y ) != 0;
+      }
+
+      cleared += full;
+    }
+  }
+
+  result.scan_ns = duration< double, std::nano >( steady_clock::now() - start ).count() / clears;
+
+  // Keeps the loops above from being optimised out.
+  if( cleared == 0 && events == 0 ) {
+    printf( "nothing happened\n" );
+  }
+
+  return result;
+}
+
+int main( int argc, char* argv[] ) {
+  const uint64_t ticks = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 5000000;
+  const int clears = argc > 2 ? atoi( argv[ 2 ] ) : 200000;
+  const uint64_t seed = argc > 3 ? strtoull( argv[ 3 ], nullptr, 10 ) : 0;
+
+  const WidthResult results[] = {
+    run< 10 >( ticks, clears, seed ),
+    run< 32 >( ticks, clears, seed ),
+    run< 64 >( ticks, clears, seed ),
+    run< 128 >( ticks, clears, seed ),
+  };
+
+  size_t mismatches = 0;
+
+  printf( "width  line bytes   tick ns   clear ns   scan ns\n" );
+
+  for( const WidthResult& result : results ) {
+    printf( "%5d  %10d  %8.1f  %9.1f  %8.1f\n", result.width, result.line_bytes, result.tick_ns, result.clear_ns, result.scan_ns );
+    mismatches += result.mismatches;
+  }
+
+  printf( "%zu mismatches\n", mismatches );
+
+  return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file